@@ -1,97 +1,131 @@
 #include "actions.h"
 
+#include <algorithm>
+
 #include <cbdebugger_interfaces.h>
 #include <cbplugin.h>
 #include <logmanager.h>
 
 #include "cmd_result_parser.h"
 #include "frame.h"
+#include "helpers.h"
 #include "updated_variable.h"
 
 namespace dbg_mi
 {
 
-void BreakpointAddAction::OnStart()
+wxString MakeBreakpointInsertCommand(Breakpoint const &breakpoint)
 {
     wxString cmd(wxT("-break-insert -f "));
 
-    if(m_breakpoint->HasCondition())
-        cmd += wxT("-c ") + m_breakpoint->GetCondition() + wxT(" ");
-    if(m_breakpoint->HasIgnoreCount())
-        cmd += wxT("-i ") + wxString::Format(wxT("%d "), m_breakpoint->GetIgnoreCount());
+    if(!breakpoint.IsEnabled())
+        cmd += wxT("-d ");
+    if(breakpoint.HasCondition())
+        cmd += wxT("-c ") + QuoteString(breakpoint.GetCondition()) + wxT(" ");
+    if(breakpoint.HasIgnoreCount())
+        cmd += wxT("-i ") + wxString::Format(wxT("%d "), breakpoint.GetIgnoreCount());
+
+    cmd += wxString::Format(wxT("%s:%d"), breakpoint.GetLocation().c_str(), breakpoint.GetLine());
+    return cmd;
+}
+
+wxString MakeBreakpointConditionCommand(Breakpoint const &breakpoint)
+{
+    wxString cmd = wxString::Format(wxT("-break-condition %d"), breakpoint.GetIndex());
+    // without a condition the breakpoint becomes unconditional
+    if(breakpoint.HasCondition())
+        cmd += wxT(" ") + QuoteString(breakpoint.GetCondition());
+    return cmd;
+}
+
+void BreakpointAddAction::OnStart()
+{
+    for(int ii = 0; ii < static_cast<int>(m_breakpoints.size()); ++ii)
+    {
+        CommandID const id = Execute(MakeBreakpointInsertCommand(*m_breakpoints[ii]));
+        m_commands[id] = ii;
+    }
+    m_logger.Debug(wxString::Format(wxT("BreakpointAddAction::inserting %d breakpoints"),
+                                    static_cast<int>(m_breakpoints.size())));
+    if(m_breakpoints.empty())
+        Finish();
+}
 
-    cmd += wxString::Format(wxT("%s:%d"), m_breakpoint->GetLocation().c_str(), m_breakpoint->GetLine());
-    m_initial_cmd = Execute(cmd);
-    m_logger.Debug(wxT("BreakpointAddAction::m_initial_cmd = ") + m_initial_cmd.ToString());
+void BreakpointAddAction::ReportFailure(Breakpoint const &breakpoint, wxString const &message)
+{
+    ++m_failed;
+    m_logger.Log(wxString::Format(_("Breakpoint at %s:%d can't be set: %s"), breakpoint.GetLocation().c_str(),
+                                  breakpoint.GetLine(), message.c_str()),
+                 Logger::Log::Error);
 }
 
 void BreakpointAddAction::OnCommandOutput(CommandID const &id, ResultParser const &result)
 {
     m_logger.Debug(wxT("BreakpointAddAction::OnCommandResult: ") + id.ToString());
 
-    if(m_initial_cmd == id)
+    CommandIDMap<int>::iterator it = m_commands.find(id);
+    if(it == m_commands.end())
+        return;
+    Breakpoint &breakpoint = *m_breakpoints[it->second];
+    m_commands.erase(it);
+
+    const ResultValue &value = result.GetResultValue();
+    if (result.GetResultClass() == ResultParser::ClassDone)
     {
-        bool finish = true;
-        const ResultValue &value = result.GetResultValue();
-        if (result.GetResultClass() == ResultParser::ClassDone)
+        const ResultValue *number = value.GetTupleValue(wxT("bkpt.number"));
+        long n;
+        if(number && number->ToLong(n))
         {
-            const ResultValue *number = value.GetTupleValue(wxT("bkpt.number"));
-            if(number)
-            {
-                const wxString &number_value = number->GetSimpleValue();
-                long n;
-                if(number_value.ToLong(&n, 10))
-                {
-                    m_logger.Debug(wxString::Format(wxT("BreakpointAddAction::breakpoint index is %d"), n));
-                    m_breakpoint->SetIndex(n);
-
-                    if(!m_breakpoint->IsEnabled())
-                    {
-                        m_disable_cmd = Execute(wxString::Format(wxT("-break-disable %d"), n));
-                        finish = false;
-                    }
-                }
-                else
-                    m_logger.Debug(wxT("BreakpointAddAction::error getting the index :( "));
-            }
-            else
-            {
-                m_logger.Debug(wxT("BreakpointAddAction::error getting number value:( "));
-                m_logger.Debug(value.MakeDebugString());
-            }
+            m_logger.Debug(wxString::Format(wxT("BreakpointAddAction::breakpoint index is %d"), n));
+            m_container.SetNumber(breakpoint, n);
+            // gdb counts the hits of a new breakpoint from zero
+            breakpoint.SetHitCount(0);
         }
-        else if (result.GetResultClass() == ResultParser::ClassError)
+        else
         {
-            wxString message;
-            if (Lookup(value, wxT("msg"), message))
-                m_logger.Log(message, Logger::Log::Error);
+            m_logger.Debug(wxT("BreakpointAddAction::error getting the index :( "));
+            m_logger.Debug(value.MakeDebugString());
         }
+    }
+    else if (result.GetResultClass() == ResultParser::ClassError)
+    {
+        wxString message;
+        Lookup(value, wxT("msg"), message);
+        ReportFailure(breakpoint, message);
+    }
 
-        if (finish)
+    if(m_commands.empty())
+    {
+        if(m_failed > 0 && m_breakpoints.size() > 1)
         {
-            m_logger.Debug(wxT("BreakpointAddAction::Finishing1"));
-            Finish();
+            m_logger.Log(wxString::Format(_("%d of %d breakpoints can't be set"), m_failed,
+                                          static_cast<int>(m_breakpoints.size())),
+                         Logger::Log::Error);
         }
-    }
-    else if(m_disable_cmd == id)
-    {
-        m_logger.Debug(wxT("BreakpointAddAction::Finishing2"));
+        m_logger.Debug(wxT("BreakpointAddAction::Finishing"));
         Finish();
     }
 }
 
 GenerateBacktrace::GenerateBacktrace(SwitchToFrameInvoker *switch_to_frame, BacktraceContainer &backtrace,
-                                     CurrentFrame &current_frame, Logger &logger) :
+                                     BacktraceCache &cache, CurrentFrame &current_frame, Logger &logger,
+                                     int first_frame) :
     m_switch_to_frame(switch_to_frame),
     m_backtrace(backtrace),
+    m_cache(cache),
     m_logger(logger),
     m_current_frame(current_frame),
+    m_first_frame(first_frame),
+    m_depth(-1),
+    m_max_depth(-1),
+    m_end(first_frame),
+    m_first_fetched(0),
     m_first_valid(-1),
     m_old_active_frame(-1),
-    m_parsed_backtrace(false),
-    m_parsed_args(false),
-    m_parsed_frame_info(false)
+    m_commands_left(0),
+    m_fetching_rest(false)
 {
+    SetPriority(PriorityHigh);
 }
 
 GenerateBacktrace::~GenerateBacktrace()
@@ -99,84 +133,102 @@ GenerateBacktrace::~GenerateBacktrace()
     delete m_switch_to_frame;
 }
 
-void GenerateBacktrace::OnCommandOutput(CommandID const &id, ResultParser const &result)
+void GenerateBacktrace::ListFrames(int start, int end, CommandID &frames_id, CommandID &args_id)
 {
-    if(id == m_backtrace_id)
+    frames_id = Execute(wxString::Format(wxT("-stack-list-frames %d %d"), start, end - 1));
+    args_id = Execute(wxString::Format(wxT("-stack-list-arguments 1 %d %d"), start, end - 1));
+    m_commands_left += 2;
+}
+
+void GenerateBacktrace::ParseFrames(ResultParser const &result, int start, BacktraceContainer &frames)
+{
+    ResultValue const *stack = result.GetResultValue().GetTupleValue(wxT("stack"));
+    if(!stack)
     {
-        ResultValue const *stack = result.GetResultValue().GetTupleValue(wxT("stack"));
-        if(!stack)
-            m_logger.Debug(wxT("GenerateBacktrace::OnCommandOutput: no stack tuple in the output"));
-        else
+        m_logger.Debug(wxT("GenerateBacktrace::OnCommandOutput: no stack tuple in the output"));
+        return;
+    }
+
+    int size = stack->GetTupleSize();
+    m_logger.Debug(wxString::Format(wxT("GenerateBacktrace::OnCommandOutput: tuple size %d %s"),
+                                    size, stack->MakeDebugString().c_str()));
+
+    for(int ii = 0; ii < size; ++ii)
+    {
+        ResultValue const *frame_value = stack->GetTupleValueByIndex(ii);
+        assert(frame_value);
+        Frame frame;
+        if(frame.ParseFrame(*frame_value))
         {
-            int size = stack->GetTupleSize();
-            m_logger.Debug(wxString::Format(wxT("GenerateBacktrace::OnCommandOutput: tuple size %d %s"),
-                                            size, stack->MakeDebugString().c_str()));
+            cbStackFrame s;
+            if(frame.HasValidSource())
+                s.SetFile(frame.GetFilename(), wxString::Format(wxT("%d"), frame.GetLine()));
+            else
+                s.SetFile(frame.GetFrom(), wxEmptyString);
+            s.SetSymbol(frame.GetFunction());
+            s.SetNumber(start + ii);
+            s.SetAddress(frame.GetAddress());
+            s.MakeValid(frame.HasValidSource());
+
+            frames.push_back(cb::shared_ptr<cbStackFrame>(new cbStackFrame(s)));
+        }
+        else
+            m_logger.Debug(wxT("can't parse frame: ") + frame_value->MakeDebugString());
+    }
+}
 
-            m_backtrace.clear();
+void GenerateBacktrace::ParseArguments(ResultParser const &result, BacktraceContainer &frames, int first)
+{
+    m_logger.Debug(wxT("GenerateBacktrace::OnCommandOutput arguments"));
+    FrameArguments arguments;
 
-            for(int ii = 0; ii < size; ++ii)
+    if(!arguments.Attach(result.GetResultValue()))
+    {
+        m_logger.Debug(wxT("GenerateBacktrace::OnCommandOutput: can't attach to output of command"));
+    }
+    else if(arguments.GetCount() != static_cast<int>(frames.size()) - first)
+    {
+        m_logger.Debug(wxT("GenerateBacktrace::OnCommandOutput: stack arg count differ from the number of frames"));
+    }
+    else
+    {
+        int size = arguments.GetCount();
+        for(int ii = 0; ii < size; ++ii)
+        {
+            wxString args;
+            cbStackFrame &frame = *frames[first + ii];
+            if(arguments.GetFrame(ii, args))
+                frame.SetSymbol(frame.GetSymbol() + wxT("(") + args + wxT(")"));
+            else
             {
-                ResultValue const *frame_value = stack->GetTupleValueByIndex(ii);
-                assert(frame_value);
-                Frame frame;
-                if(frame.ParseFrame(*frame_value))
-                {
-                    cbStackFrame s;
-                    if(frame.HasValidSource())
-                        s.SetFile(frame.GetFilename(), wxString::Format(wxT("%d"), frame.GetLine()));
-                    else
-                        s.SetFile(frame.GetFrom(), wxEmptyString);
-                    s.SetSymbol(frame.GetFunction());
-                    s.SetNumber(ii);
-                    s.SetAddress(frame.GetAddress());
-                    s.MakeValid(frame.HasValidSource());
-                    if(s.IsValid() && m_first_valid == -1)
-                        m_first_valid = ii;
-
-                    m_backtrace.push_back(cb::shared_ptr<cbStackFrame>(new cbStackFrame(s)));
-                }
-                else
-                    m_logger.Debug(wxT("can't parse frame: ") + frame_value->MakeDebugString());
+                m_logger.Debug(wxString::Format(wxT("GenerateBacktrace::OnCommandOutput: ")
+                                                wxT("can't get args for frame %d"),
+                                                frame.GetNumber()));
             }
         }
-        m_parsed_backtrace = true;
     }
+}
+
+void GenerateBacktrace::OnCommandOutput(CommandID const &id, ResultParser const &result)
+{
+    if(id == m_top_frames_id)
+        ParseFrames(result, m_first_frame, m_top_frames);
+    else if(id == m_top_args_id)
+        ParseArguments(result, m_top_frames, 0);
+    else if(id == m_frames_id)
+        ParseFrames(result, m_first_frame + m_top_frames.size() + m_first_fetched, m_frames);
     else if(id == m_args_id)
+        ParseArguments(result, m_frames, m_first_fetched);
+    else if(id == m_depth_id)
     {
-        m_logger.Debug(wxT("GenerateBacktrace::OnCommandOutput arguments"));
-        FrameArguments arguments;
-
-        if(!arguments.Attach(result.GetResultValue()))
-        {
-            m_logger.Debug(wxT("GenerateBacktrace::OnCommandOutput: can't attach to output of command: ")
-                           + id.ToString());
-        }
-        else if(arguments.GetCount() != static_cast<int>(m_backtrace.size()))
+        if(result.GetResultClass() != ResultParser::ClassDone
+           || !Lookup(result.GetResultValue(), wxT("depth"), m_depth))
         {
-            m_logger.Debug(wxT("GenerateBacktrace::OnCommandOutput: stack arg count differ from the number of frames"));
+            m_depth = -1;
         }
-        else
-        {
-            int size = arguments.GetCount();
-            for(int ii = 0; ii < size; ++ii)
-            {
-                wxString args;
-                if(arguments.GetFrame(ii, args))
-                    m_backtrace[ii]->SetSymbol(m_backtrace[ii]->GetSymbol() + wxT("(") + args + wxT(")"));
-                else
-                {
-                    m_logger.Debug(wxString::Format(wxT("GenerateBacktrace::OnCommandOutput: ")
-                                                    wxT("can't get args for frame %d"),
-                                                    ii));
-                }
-            }
-        }
-        m_parsed_args = true;
     }
     else if (id == m_frame_info_id)
     {
-        m_parsed_frame_info = true;
-
         //^done,frame={level="0",addr="0x0000000000401060",func="main",
         //file="/path/main.cpp",fullname="/path/main.cpp",line="80"}
         if (result.GetResultClass() != ResultParser::ClassDone)
@@ -191,108 +243,330 @@ void GenerateBacktrace::OnCommandOutput(CommandID const &id, ResultParser const
         }
     }
 
-    if(m_parsed_backtrace && m_parsed_args && m_parsed_frame_info)
+    if(--m_commands_left > 0)
+        return;
+    if(m_fetching_rest)
+        Done();
+    else
+        OnTopFrames();
+}
+
+void GenerateBacktrace::OnStart()
+{
+    if(m_first_frame == 0)
     {
-        if (!m_backtrace.empty())
-        {
-            int frame = m_current_frame.GetUserSelectedFrame();
-            if (frame < 0 && cbDebuggerCommonConfig::GetFlag(cbDebuggerCommonConfig::AutoSwitchFrame))
-                frame = m_first_valid;
-            if (frame < 0)
-                frame = 0;
-
-            m_current_frame.SetFrame(frame);
-            int number = m_backtrace.empty() ? 0 : m_backtrace[frame]->GetNumber();
-            if (m_old_active_frame != number)
-                m_switch_to_frame->Invoke(number);
-        }
+        m_frame_info_id = Execute(wxT("-stack-info-frame"));
+        ++m_commands_left;
+    }
+    // Counting all frames of a deep stack is slow, the exact depth is needed only to match the cached frames.
+    if(m_first_frame == 0 && m_cache.IsStepping())
+        m_depth_id = Execute(wxT("-stack-info-depth"));
+    else
+    {
+        m_max_depth = m_first_frame + c_backtrace_page_size + 1;
+        m_depth_id = Execute(wxString::Format(wxT("-stack-info-depth %d"), m_max_depth));
+    }
+    ++m_commands_left;
 
-        Manager::Get()->GetDebuggerManager()->GetBacktraceDialog()->Reload();
-        Finish();
+    // The top frames of the first page are fetched first, the rest of the page may be in the cache.
+    int const count = m_first_frame == 0 ? c_backtrace_top_frames : c_backtrace_page_size;
+    ListFrames(m_first_frame, m_first_frame + count, m_top_frames_id, m_top_args_id);
+}
+
+void GenerateBacktrace::OnTopFrames()
+{
+    m_fetching_rest = true;
+
+    int const fetched = m_first_frame + m_top_frames.size();
+    m_end = m_depth < 0 ? fetched : std::min(m_depth, m_first_frame + c_backtrace_page_size);
+    if(fetched >= m_end || m_top_frames.empty())
+    {
+        Done();
+        return;
     }
+
+    int start = fetched;
+    cbStackFrame const &deepest = *m_top_frames.back();
+    int const thread_id = m_current_frame.GetThreadId();
+    if(m_first_frame == 0 && m_max_depth < 0
+       && m_cache.Matches(deepest.GetNumber(), deepest.GetAddress(), m_depth, thread_id))
+    {
+        start += m_cache.CopyFrames(m_frames, start, m_end, m_depth);
+        m_logger.Debug(wxString::Format(wxT("GenerateBacktrace: %d frames taken from the cache"), start - fetched));
+    }
+
+    if(start < m_end)
+    {
+        m_first_fetched = m_frames.size();
+        ListFrames(start, m_end, m_frames_id, m_args_id);
+    }
+    else
+        Done();
 }
-void GenerateBacktrace::OnStart()
+
+void GenerateBacktrace::Done()
 {
-    m_frame_info_id = Execute(wxT("-stack-info-frame"));
-    m_backtrace_id = Execute(wxT("-stack-list-frames 0 30"));
-    m_args_id = Execute(wxT("-stack-list-arguments 1 0 30"));
+    if(m_first_frame == 0)
+        m_backtrace.clear();
+    else if(static_cast<int>(m_backtrace.size()) > m_first_frame)
+        m_backtrace.resize(m_first_frame); // removes the placeholder
+    m_backtrace.insert(m_backtrace.end(), m_top_frames.begin(), m_top_frames.end());
+    m_backtrace.insert(m_backtrace.end(), m_frames.begin(), m_frames.end());
+
+    int const size = m_backtrace.size();
+    if(m_depth >= 0)
+    {
+        // gdb stops counting at the max depth, so the stack may be deeper
+        bool const exact = m_max_depth < 0 || m_depth < m_max_depth;
+        if(exact)
+            m_cache.Store(m_backtrace, m_depth, m_current_frame.GetThreadId());
+        if(m_depth > size)
+            m_backtrace.push_back(MakeMoreFramesPlaceholder(size, exact ? m_depth - size : -1));
+    }
+
+    if(m_first_frame == 0 && size > 0)
+    {
+        for(int ii = 0; ii < size && m_first_valid == -1; ++ii)
+        {
+            if(m_backtrace[ii]->IsValid())
+                m_first_valid = ii;
+        }
+
+        int frame = m_current_frame.GetUserSelectedFrame();
+        if (frame < 0 && cbDebuggerCommonConfig::GetFlag(cbDebuggerCommonConfig::AutoSwitchFrame))
+            frame = m_first_valid;
+        if (frame < 0 || frame >= size)
+            frame = 0;
+
+        m_current_frame.SetFrame(frame);
+        int number = m_backtrace[frame]->GetNumber();
+        if (m_old_active_frame != number)
+            m_switch_to_frame->Invoke(number);
+    }
+
+#ifndef TEST_PROJECT
+    Manager::Get()->GetDebuggerManager()->GetBacktraceDialog()->Reload();
+#endif
+    Finish();
 }
 
-GenerateThreadsList::GenerateThreadsList(ThreadsContainer &threads, int current_thread_id, Logger &logger) :
+GenerateThreadsList::GenerateThreadsList(ThreadsContainer &threads, int current_thread_id, Logger &logger,
+                                         int first_row) :
     m_threads(threads),
     m_logger(logger),
-    m_current_thread_id(current_thread_id)
+    m_current_thread_id(current_thread_id),
+    m_first_row(first_row),
+    m_frames_left(0)
 {
+    SetPriority(PriorityLow);
 }
 
-void GenerateThreadsList::OnCommandOutput(CommandID const & /*id*/, ResultParser const &result)
+namespace
 {
-    Finish();
-    m_threads.clear();
+wxString MakeFrameInfo(ResultValue const &frame_value)
+{
+    wxString info, str;
+
+    if(Lookup(frame_value, wxT("addr"), str))
+        info += str;
+    if(Lookup(frame_value, wxT("func"), str))
+    {
+        info += wxT(" ") + str;
+
+        if(FrameArguments::ParseFrame(frame_value, str))
+            info += wxT("(") + str + wxT(")");
+        else
+            info += wxT("()");
+    }
+
+    int line;
 
-    int current_thread_id = 0;
-    if(!Lookup(result.GetResultValue(), wxT("current-thread-id"), current_thread_id))
+    if(Lookup(frame_value, wxT("file"), str) && Lookup(frame_value, wxT("line"), line))
     {
-        m_logger.Debug(wxT("GenerateThreadsList::OnCommandOutput - no current thread id"));
+        info += wxString::Format(wxT(" in %s:%d"), str.c_str(), line);
+    }
+    else if(Lookup(frame_value, wxT("from"), str))
+        info += wxT(" in ") + str;
+    return info;
+}
+
+/// Parses the output of -thread-list-ids.
+bool ParseThreadIDs(ResultValue const &output, std::vector<int> &ids)
+{
+    ResultValue const *thread_ids = output.GetTupleValue(wxT("thread-ids"));
+    if(!thread_ids)
+        return false;
+    for(int ii = 0; ii < thread_ids->GetTupleSize(); ++ii)
+    {
+        long thread_id;
+        if(thread_ids->GetTupleValueByIndex(ii)->ToLong(thread_id))
+            ids.push_back(thread_id);
+    }
+    return true;
+}
+} // anonymous namespace
+
+void GenerateThreadsList::OnCommandOutput(CommandID const &id, ResultParser const &result)
+{
+    if(id == m_list_ids_command)
+    {
+        std::vector<int> ids;
+        if(!ParseThreadIDs(result.GetResultValue(), ids))
+            m_logger.Debug(wxT("GenerateThreadsList::OnCommandOutput - no thread ids"));
+
+        m_threads.Synchronize(ids);
+        Lookup(result.GetResultValue(), wxT("current-thread-id"), m_current_thread_id);
+        m_threads.SetCurrent(m_current_thread_id);
+        FetchFrames();
         return;
     }
 
     ResultValue const *threads = result.GetResultValue().GetTupleValue(wxT("threads"));
     if(!threads || (threads->GetType() != ResultValue::Tuple && threads->GetType() != ResultValue::Array))
-    {
         m_logger.Debug(wxT("GenerateThreadsList::OnCommandOutput - no threads"));
-        return;
+    else
+    {
+        for(int ii = 0; ii < threads->GetTupleSize(); ++ii)
+        {
+            ResultValue const &thread_value = *threads->GetTupleValueByIndex(ii);
+
+            int thread_id;
+            if(!Lookup(thread_value, wxT("id"), thread_id))
+                continue;
+
+            wxString target_id;
+            if(!Lookup(thread_value, wxT("target-id"), target_id))
+                target_id = wxEmptyString;
+
+            ResultValue const *frame_value = thread_value.GetTupleValue(wxT("frame"));
+            m_threads.SetInfo(thread_id, target_id, frame_value ? MakeFrameInfo(*frame_value) : wxString());
+        }
     }
-    int count = threads->GetTupleSize();
-    for(int ii = 0; ii < count; ++ii)
+
+    if(--m_frames_left == 0)
+        Done();
+}
+
+void GenerateThreadsList::OnStart()
+{
+    if(!m_threads.IsSynchronized())
+        m_list_ids_command = Execute(wxT("-thread-list-ids"));
+    else
     {
-        ResultValue const &thread_value = *threads->GetTupleValueByIndex(ii);
+        m_threads.SetCurrent(m_current_thread_id);
+        FetchFrames();
+    }
+}
 
-        int thread_id;
-        if(!Lookup(thread_value, wxT("id"), thread_id))
+void GenerateThreadsList::FetchFrames()
+{
+    std::vector<int> ids;
+    if(m_current_thread_id >= 0 && m_threads.IsStale(m_current_thread_id) && !m_threads.IsRunning(m_current_thread_id))
+        ids.push_back(m_current_thread_id);
+
+    // the pages without stale threads are skipped
+    size_t const current_count = ids.size();
+    int const rows = m_threads.size();
+    while(ids.size() == current_count && m_first_row < rows)
+    {
+        m_threads.GetStaleThreads(m_first_row, m_first_row + c_threads_page_size, ids);
+        if(ids.size() == current_count)
+            m_first_row += c_threads_page_size;
+    }
+
+    for(size_t ii = 0; ii < ids.size(); ++ii)
+    {
+        // the current thread can be in the page too
+        if(ii > 0 && ids[ii] == ids[0])
             continue;
+        Execute(wxString::Format(wxT("-thread-info %d"), ids[ii]));
+        ++m_frames_left;
+    }
 
-        wxString info;
-        if(!Lookup(thread_value, wxT("target-id"), info))
-            info = wxEmptyString;
+    if(m_frames_left == 0)
+        Done();
+}
 
-        ResultValue const *frame_value = thread_value.GetTupleValue(wxT("frame"));
+void GenerateThreadsList::Done()
+{
+#ifndef TEST_PROJECT
+    Manager::Get()->GetDebuggerManager()->GetThreadsDialog()->Reload();
+#endif
+    // the page is shown before the next one is fetched, so the first threads don't wait for the rest
+    m_first_row += c_threads_page_size;
+    if(m_first_row < static_cast<int>(m_threads.size()))
+        FetchFrames();
+    else
+        Finish();
+}
 
-        if(frame_value)
-        {
-            wxString str;
+GenerateThreadsSnapshot::GenerateThreadsSnapshot(ThreadsSnapshotInvoker *invoker, ThreadsContainer &threads,
+                                                 Logger &logger) :
+    m_invoker(invoker),
+    m_threads(threads),
+    m_logger(logger)
+{
+    SetPriority(PriorityLow);
+}
 
-            if(Lookup(*frame_value, wxT("addr"), str))
-                info += wxT(" ") + str;
-            if(Lookup(*frame_value, wxT("func"), str))
-            {
-                info += wxT(" ") + str;
+GenerateThreadsSnapshot::~GenerateThreadsSnapshot()
+{
+    delete m_invoker;
+}
 
-                if(FrameArguments::ParseFrame(*frame_value, str))
-                    info += wxT("(") + str + wxT(")");
-                else
-                    info += wxT("()");
-            }
+void GenerateThreadsSnapshot::OnStart()
+{
+    if(!m_threads.IsSynchronized())
+        m_list_ids_command = Execute(wxT("-thread-list-ids"));
+    else
+        ListStacks();
+}
 
-            int line;
+void GenerateThreadsSnapshot::ListStacks()
+{
+    for(size_t ii = 0; ii < m_threads.size(); ++ii)
+    {
+        int const thread_id = m_threads[ii]->GetNumber();
+        CommandID const id = Execute(wxString::Format(wxT("-stack-list-frames --thread %d 0 %d"),
+                                                      thread_id, c_snapshot_max_frames - 1));
+        m_stack_commands[id] = thread_id;
+    }
 
-            if(Lookup(*frame_value, wxT("file"), str) && Lookup(*frame_value, wxT("line"), line))
-            {
-                info += wxString::Format(wxT(" in %s:%d"), str.c_str(), line);
-            }
-            else if(Lookup(*frame_value, wxT("from"), str))
-                info += wxT(" in ") + str;
-        }
+    if(m_stack_commands.empty())
+        Done();
+}
 
-        m_threads.push_back(cb::shared_ptr<cbThread>(new cbThread(thread_id == current_thread_id, thread_id, info)));
+void GenerateThreadsSnapshot::OnCommandOutput(CommandID const &id, ResultParser const &result)
+{
+    if(id == m_list_ids_command)
+    {
+        std::vector<int> ids;
+        if(!ParseThreadIDs(result.GetResultValue(), ids))
+            m_logger.Debug(wxT("GenerateThreadsSnapshot::OnCommandOutput - no thread ids"));
+        m_threads.Synchronize(ids);
+        ListStacks();
+        return;
     }
 
-    Manager::Get()->GetDebuggerManager()->GetThreadsDialog()->Reload();
+    CommandIDMap<int>::iterator it = m_stack_commands.find(id);
+    if(it == m_stack_commands.end())
+        return;
+    // a thread, which is running in non-stop mode or has exited, has no stack
+    if(!m_snapshot.AddThread(it->second, result.GetResultValue()))
+    {
+        m_logger.Debug(wxString::Format(wxT("GenerateThreadsSnapshot::OnCommandOutput - no stack for thread %d"),
+                                        it->second));
+    }
+    m_stack_commands.erase(it);
+
+    if(m_stack_commands.empty())
+        Done();
 }
 
-void GenerateThreadsList::OnStart()
+void GenerateThreadsSnapshot::Done()
 {
-    Execute(wxT("-thread-info"));
+    m_invoker->Invoke(m_snapshot);
+    Finish();
 }
 
 void ParseWatchInfo(ResultValue const &value, int &children_count, bool &dynamic, bool &has_more)
@@ -333,6 +607,16 @@ void AppendNullChild(cb::shared_ptr<Watch> watch)
     cbWatch::AddChild(watch, cb::shared_ptr<cbWatch>(new Watch(wxT("updating..."), watch->ForTooltip())));
 }
 
+/// Appends the child, which lists the next page of children of the watch when it is expanded.
+void AppendMoreChild(cb::shared_ptr<Watch> watch)
+{
+    cb::shared_ptr<Watch> more(new Watch(wxT("..."), watch->ForTooltip(), false));
+    more->SetMorePlaceholder(true);
+    more->SetValue(wxT("expand to show more children"));
+    cbWatch::AddChild(watch, more);
+    AppendNullChild(more);
+}
+
 cb::shared_ptr<Watch> AddChild(cb::shared_ptr<Watch> parent, ResultValue const &child_value, wxString const &symbol,
                                WatchesContainer &watches)
 {
@@ -355,6 +639,7 @@ cb::shared_ptr<Watch> AddChild(cb::shared_ptr<Watch> parent, ResultValue const &
         child = cb::shared_ptr<Watch>(new Watch(symbol, parent->ForTooltip()));
         ParseWatchValueID(*child, child_value);
         cbWatch::AddChild(parent, child);
+        watches.Register(child);
     }
 
     child->MarkAsRemoved(false);
@@ -389,6 +674,8 @@ WatchBaseAction::WatchBaseAction(WatchesContainer &watches, Logger &logger) :
     m_start(-1),
     m_end(-1)
 {
+    // the varobjs are floating, they are created and updated in the selected frame
+    SetUsesFrame(true);
 }
 
 WatchBaseAction::~WatchBaseAction()
@@ -403,11 +690,15 @@ bool WatchBaseAction::ParseListCommand(CommandID const &id, ResultValue const &v
                    + id.ToString() + wxT(" -> ") + value.MakeDebugString());
 
     ListCommandParentMap::iterator it = m_parent_map.find(id);
-    if(it == m_parent_map.end() || !it->second)
+    if(it == m_parent_map.end() || !it->second.parent)
     {
         m_logger.Debug(wxT("WatchBaseAction::ParseListCommand - no parent for id: ") + id.ToString());
         return false;
     }
+    // Listing the children can execute more list commands, so the iterator doesn't stay valid.
+    // Every list command has one result, so its entry isn't needed anymore.
+    ListCommand const command = it->second;
+    m_parent_map.erase(it);
 
     struct DisplayHint
     {
@@ -431,7 +722,15 @@ bool WatchBaseAction::ParseListCommand(CommandID const &id, ResultValue const &v
         int count = children->GetTupleSize();
 
         m_logger.Debug(wxString::Format(wxT("WatchBaseAction::ParseListCommand - children %d"), count));
-        cb::shared_ptr<Watch> parent_watch = it->second;
+        cb::shared_ptr<Watch> parent_watch = command.parent;
+
+        // The placeholder for the rest of the children is replaced by the children listed now.
+        for(int ii = 0; ii < parent_watch->GetChildCount(); ++ii)
+        {
+            cb::shared_ptr<Watch> child = cb::static_pointer_cast<Watch>(parent_watch->GetChild(ii));
+            if(child->IsMorePlaceholder())
+                child->MarkAsRemoved(true);
+        }
 
         wxString strMapKey;
 
@@ -440,7 +739,7 @@ bool WatchBaseAction::ParseListCommand(CommandID const &id, ResultValue const &v
             ResultValue const *child_value;
             child_value = children->GetTupleValueByIndex(ii);
 
-            if(child_value->GetName() == wxT("child"))
+            if(child_value->NameEquals("child"))
             {
                 wxString symbol;
                 if(!Lookup(*child_value, wxT("exp"), symbol))
@@ -483,7 +782,7 @@ bool WatchBaseAction::ParseListCommand(CommandID const &id, ResultValue const &v
                         if(!parent_watch->HasBeenExpanded())
                         {
                             parent_watch->SetHasBeenExpanded(true);
-                            parent_watch->RemoveChildren();
+                            m_watches.RemoveChildren(parent_watch);
                         }
                         child = AddChild(parent_watch, *child_value, (mapValue ? strMapKey : symbol), m_watches);
                         if (dynamic)
@@ -501,7 +800,7 @@ bool WatchBaseAction::ParseListCommand(CommandID const &id, ResultValue const &v
                             if(!parent_watch->HasBeenExpanded())
                             {
                                 parent_watch->SetHasBeenExpanded(true);
-                                parent_watch->RemoveChildren();
+                                m_watches.RemoveChildren(parent_watch);
                             }
                             child = AddChild(parent_watch, *child_value, (mapValue ? strMapKey : symbol), m_watches);
                             AppendNullChild(child);
@@ -526,24 +825,37 @@ bool WatchBaseAction::ParseListCommand(CommandID const &id, ResultValue const &v
                                + children->GetTupleValueByIndex(ii)->MakeDebugString());
             }
         }
-        parent_watch->RemoveMarkedChildren();
+        m_watches.RemoveMarkedChildren(parent_watch);
+
+        if(command.start > -1)
+        {
+            parent_watch->GetFetchedRanges().Add(command.start, command.end);
+
+            int has_more;
+            if(Lookup(value, wxT("has_more"), has_more) && has_more == 1)
+                AppendMoreChild(parent_watch);
+        }
     }
     return !error;
 }
 
 void WatchBaseAction::ExecuteListCommand(cb::shared_ptr<Watch> watch, cb::shared_ptr<Watch> parent)
 {
-    CommandID id;
-
-    if(m_start > -1 && m_end > -1)
+    int start = m_start, end = m_end;
+    if(start < 0 || end < 0)
     {
-        id = Execute(wxString::Format(wxT("-var-list-children 2 \"%s\" %d %d "),
-                                      watch->GetID().c_str(), m_start, m_end));
+        // Refresh the children which have been fetched so far, but at least the first page of them.
+        start = 0;
+        end = std::max(watch->GetFetchedRanges().GetEnd(), c_watch_page_size);
     }
-    else
-        id = Execute(wxString::Format(wxT("-var-list-children 2 \"%s\""), watch->GetID().c_str()));
 
-    m_parent_map[id] = parent ? parent : watch;
+    CommandID id = Execute(wxString::Format(wxT("-var-list-children 2 \"%s\" %d %d "),
+                                            watch->GetID().c_str(), start, end));
+
+    ListCommand &command = m_parent_map[id];
+    command.parent = parent ? parent : watch;
+    command.start = parent ? -1 : start;
+    command.end = parent ? -1 : end;
     ++m_sub_commands_left;
 }
 
@@ -561,7 +873,9 @@ void WatchBaseAction::ExecuteListCommand(wxString const &watch_id, cb::shared_pt
     else
         id = Execute(wxString::Format(wxT("-var-list-children 2 \"%s\""), watch_id.c_str()));
 
-    m_parent_map[id] = parent;
+    ListCommand &command = m_parent_map[id];
+    command.parent = parent;
+    command.start = command.end = -1;
     ++m_sub_commands_left;
 }
 
@@ -589,10 +903,12 @@ void WatchCreateAction::OnCommandOutput(CommandID const &id, ResultParser const
                 int children;
                 ParseWatchInfo(value, children, dynamic, has_more);
                 ParseWatchValueID(*m_watch, value);
+                m_watches.Register(m_watch);
                 if(dynamic && has_more)
                 {
                     m_step = StepSetRange;
-                    Execute(wxT("-var-set-update-range \"") + m_watch->GetID() + wxT("\" 0 100"));
+                    Execute(wxString::Format(wxT("-var-set-update-range \"%s\" 0 %d"),
+                                             m_watch->GetID().c_str(), c_watch_page_size));
                     AppendNullChild(m_watch);
 
                 }
@@ -620,13 +936,13 @@ void WatchCreateAction::OnCommandOutput(CommandID const &id, ResultParser const
     if(error)
     {
         m_logger.Debug(wxT("WatchCreateAction::OnCommandOutput - error in command: ") + id.ToString());
-        UpdateWatches(m_logger);
+        UpdateWatchesTooltipOrAll(m_watch, m_logger);
         Finish();
     }
     else if(m_sub_commands_left == 0)
     {
         m_logger.Debug(wxT("WatchCreateAction::Output - finishing at") + id.ToString());
-        UpdateWatches(m_logger);
+        UpdateWatchesTooltipOrAll(m_watch, m_logger);
         Finish();
     }
 }
@@ -652,10 +968,53 @@ WatchesUpdateAction::WatchesUpdateAction(WatchesContainer &watches, Logger &logg
 {
 }
 
+bool WatchesUpdateAction::SetLive(cb::shared_ptr<Watch> const &watch, bool live)
+{
+    if(!watch->GetID().empty())
+    {
+        if(watch->IsFrozen() == live)
+        {
+            Execute(wxString::Format(wxT("-var-set-frozen \"%s\" %d"), watch->GetID().c_str(), live ? 0 : 1));
+            watch->SetFrozen(!live);
+            ++m_sub_commands_left;
+        }
+        // the children of a frozen varobj are skipped too
+        if(!live)
+            return false;
+    }
+    else if(!live)
+        return false;
+
+    bool const expanded = watch->IsExpanded();
+    bool has_live = !watch->GetID().empty();
+    for(int ii = 0; ii < watch->GetChildCount(); ++ii)
+    {
+        cb::shared_ptr<Watch> child = cb::static_pointer_cast<Watch>(watch->GetChild(ii));
+        if(SetLive(child, expanded))
+            has_live = true;
+    }
+    return has_live;
+}
+
 void WatchesUpdateAction::OnStart()
 {
-    m_update_command = Execute(wxT("-var-update 1 *"));
-    m_sub_commands_left = 1;
+    // Only the watches shown in the watches window are updated, the tooltips and the children of the collapsed
+    // watches are frozen. They are thawed, when they are shown again, and the next update catches up with them.
+    m_sub_commands_left = 0;
+    bool has_live = false;
+    for(WatchesContainer::iterator it = m_watches.begin(); it != m_watches.end(); ++it)
+    {
+        if(SetLive(*it, !(*it)->ForTooltip()))
+            has_live = true;
+    }
+
+    if(has_live)
+    {
+        m_update_command = Execute(wxT("-var-update 1 *"));
+        ++m_sub_commands_left;
+    }
+    else if(m_sub_commands_left == 0)
+        Finish();
 }
 
 bool WatchesUpdateAction::ParseUpdate(ResultParser const &result)
@@ -694,12 +1053,12 @@ bool WatchesUpdateAction::ParseUpdate(ResultParser const &result)
                 {
                 case UpdatedVariable::InScope_No:
                     watch->Expand(false);
-                    watch->RemoveChildren();
+                    m_watches.RemoveChildren(watch);
                     watch->SetValue(wxT("-- not in scope --"));
                     break;
                 case UpdatedVariable::InScope_Invalid:
                     watch->Expand(false);
-                    watch->RemoveChildren();
+                    m_watches.RemoveChildren(watch);
                     watch->SetValue(wxT("-- invalid -- "));
                     break;
                 case UpdatedVariable::InScope_Yes:
@@ -707,7 +1066,7 @@ bool WatchesUpdateAction::ParseUpdate(ResultParser const &result)
                     {
                         if(updated_var.HasNewNumberOfChildren())
                         {
-                            watch->RemoveChildren();
+                            m_watches.RemoveChildren(watch);
 
                             if(updated_var.GetNewNumberOfChildren() > 0)
                                 ExecuteListCommand(watch);
@@ -732,7 +1091,7 @@ bool WatchesUpdateAction::ParseUpdate(ResultParser const &result)
                     {
                         if(updated_var.HasNewNumberOfChildren())
                         {
-                            watch->RemoveChildren();
+                            m_watches.RemoveChildren(watch);
 
                             if(updated_var.GetNewNumberOfChildren() > 0)
                                 ExecuteListCommand(watch);
@@ -773,6 +1132,15 @@ void WatchesUpdateAction::OnCommandOutput(CommandID const &id, ResultParser cons
             return;
         }
     }
+    else if(m_parent_map.find(id) == m_parent_map.end())
+    {
+        // the result of -var-set-frozen
+        if(result.GetResultClass() == ResultParser::ClassError)
+        {
+            m_logger.Debug(wxT("WatchUpdateAction::Output - can't freeze ")
+                           + result.GetResultValue().MakeDebugString());
+        }
+    }
     else
     {
         ResultValue const &value = result.GetResultValue();
@@ -794,7 +1162,9 @@ void WatchesUpdateAction::OnCommandOutput(CommandID const &id, ResultParser cons
 
 void WatchExpandedAction::OnStart()
 {
-    m_update_id = Execute(wxT("-var-update ") + m_expanded_watch->GetID());
+    // The values are already up to date, when the next page of an expanded watch is listed.
+    if(m_start == 0)
+        m_update_id = Execute(wxT("-var-update ") + m_expanded_watch->GetID());
     ExecuteListCommand(m_expanded_watch, cb::shared_ptr<Watch>());
 }
 
@@ -831,7 +1201,7 @@ void WatchCollapseAction::OnCommandOutput(CommandID const &id, ResultParser cons
     if(result.GetResultClass() == ResultParser::ClassDone)
     {
         m_collapsed_watch->SetHasBeenExpanded(false);
-        m_collapsed_watch->RemoveChildren();
+        m_watches.RemoveChildren(m_collapsed_watch);
         AppendNullChild(m_collapsed_watch);
         UpdateWatchesTooltipOrAll(m_collapsed_watch, m_logger);
     }
@@ -2,9 +2,10 @@
 #define _DEBUGGER_GDB_MI_ACTIONS_H_
 
 #include <tr1/memory>
-#include <tr1/unordered_map>
 #include "cmd_queue.h"
+#include "command_id_map.h"
 #include "definitions.h"
+#include "threads_snapshot.h"
 
 class cbDebuggerPlugin;
 
@@ -47,27 +48,55 @@ protected:
     }
 };
 
-class Breakpoint;
+/// The -break-insert command for the breakpoint; a disabled breakpoint is inserted disabled with -d.
+wxString MakeBreakpointInsertCommand(Breakpoint const &breakpoint);
+/// The -break-condition command, which changes the condition of a breakpoint set in gdb; the condition is quoted
+/// like in the insert command.
+wxString MakeBreakpointConditionCommand(Breakpoint const &breakpoint);
 
+/// Inserts one or more breakpoints. All inserts are queued at once, so they are written to gdb in batches and their
+/// results arrive pipelined. A failed insert is reported and doesn't stop the others.
 class BreakpointAddAction : public Action
 {
 public:
-    BreakpointAddAction(std::tr1::shared_ptr<Breakpoint> const &breakpoint, Logger &logger) :
-        m_breakpoint(breakpoint),
+    typedef std::vector<std::tr1::shared_ptr<Breakpoint> > BreakpointList;
+public:
+    BreakpointAddAction(std::tr1::shared_ptr<Breakpoint> const &breakpoint, BreakpointsContainer &container,
+                        Logger &logger) :
+        m_breakpoints(1, breakpoint),
+        m_container(container),
+        m_failed(0),
+        m_logger(logger)
+    {
+        // the breakpoints must be in gdb before the program runs, so the inserts can fill the whole window
+        SetPriority(PriorityHigh);
+    }
+    BreakpointAddAction(BreakpointList const &breakpoints, BreakpointsContainer &container, Logger &logger) :
+        m_breakpoints(breakpoints),
+        m_container(container),
+        m_failed(0),
         m_logger(logger)
     {
+        SetPriority(PriorityHigh);
     }
     virtual ~BreakpointAddAction()
     {
         m_logger.Debug(wxT("BreakpointAddAction::destructor"));
     }
     virtual void OnCommandOutput(CommandID const &id, ResultParser const &result);
+
+    int GetFailedCount() const { return m_failed; }
 protected:
     virtual void OnStart();
 
 private:
-    std::tr1::shared_ptr<Breakpoint> m_breakpoint;
-    CommandID m_initial_cmd, m_disable_cmd;
+    void ReportFailure(Breakpoint const &breakpoint, wxString const &message);
+private:
+    BreakpointList m_breakpoints;
+    BreakpointsContainer &m_container;
+    /// The index in m_breakpoints of the breakpoint inserted by the command.
+    CommandIDMap<int> m_commands;
+    int m_failed;
 
     Logger &m_logger;
 };
@@ -84,6 +113,7 @@ public:
         m_logger(logger)
     {
         SetWaitPrevious(true);
+        SetPriority(PriorityHigh);
     }
     virtual ~RunAction()
     {
@@ -121,40 +151,108 @@ struct SwitchToFrameInvoker
     virtual void Invoke(int frame_number) = 0;
 };
 
+/// The number of frames fetched by one GenerateBacktrace, deeper stacks are loaded page by page.
+const int c_backtrace_page_size = 30;
+/// The number of the innermost frames, which are always fetched. The frames below them may come from the cache.
+const int c_backtrace_top_frames = 3;
+
+/// Fetches the frames [first_frame, first_frame + c_backtrace_page_size) of the current thread. If the stack is
+/// deeper, a placeholder is appended after the frames; selecting it starts a GenerateBacktrace for the next page.
+/// The depth is counted only up to the end of the page, unless the cached frames may be reused after a step.
 class GenerateBacktrace : public Action
 {
     GenerateBacktrace(GenerateBacktrace &);
     GenerateBacktrace& operator =(GenerateBacktrace &);
 public:
-    GenerateBacktrace(SwitchToFrameInvoker *switch_to_frame, BacktraceContainer &backtrace,
-                      CurrentFrame &current_frame, Logger &logger);
+    GenerateBacktrace(SwitchToFrameInvoker *switch_to_frame, BacktraceContainer &backtrace, BacktraceCache &cache,
+                      CurrentFrame &current_frame, Logger &logger, int first_frame = 0);
     virtual ~GenerateBacktrace();
     virtual void OnCommandOutput(CommandID const &id, ResultParser const &result);
+    /// The backtrace is replaced only when all frames have arrived.
+    virtual bool CanCancelStarted() const { return true; }
 protected:
     virtual void OnStart();
+private:
+    void ListFrames(int start, int end, CommandID &frames_id, CommandID &args_id);
+    void ParseFrames(ResultParser const &result, int start, BacktraceContainer &frames);
+    void ParseArguments(ResultParser const &result, BacktraceContainer &frames, int first);
+    void OnTopFrames();
+    void Done();
 private:
     SwitchToFrameInvoker *m_switch_to_frame;
-    CommandID m_backtrace_id, m_args_id, m_frame_info_id;
+    CommandID m_top_frames_id, m_top_args_id, m_frames_id, m_args_id, m_frame_info_id, m_depth_id;
     BacktraceContainer &m_backtrace;
+    BacktraceCache &m_cache;
+    BacktraceContainer m_top_frames, m_frames;
     Logger &m_logger;
     CurrentFrame &m_current_frame;
+    int m_first_frame, m_depth, m_max_depth, m_end, m_first_fetched;
     int m_first_valid, m_old_active_frame;
-    bool m_parsed_backtrace, m_parsed_args, m_parsed_frame_info;
+    int m_commands_left;
+    bool m_fetching_rest;
 };
 
+/// The number of threads whose frames are fetched by one GenerateThreadsList.
+const int c_threads_page_size = 50;
+
+/// Fetches the frames of the current thread and of the threads, which are out of date, one page at a time starting
+/// with the page at first_row. The list of threads is fetched only the first time, later it is updated by the
+/// notifications.
 class GenerateThreadsList : public Action
 {
 public:
-    GenerateThreadsList(ThreadsContainer &threads, int current_thread_id, Logger &logger);
+    GenerateThreadsList(ThreadsContainer &threads, int current_thread_id, Logger &logger, int first_row = 0);
     virtual void OnCommandOutput(CommandID const &id, ResultParser const &result);
+    /// The threads which haven't been updated stay out of date and are fetched by the next list.
+    virtual bool CanCancelStarted() const { return true; }
 protected:
     virtual void OnStart();
+private:
+    void FetchFrames();
+    void Done();
 private:
     ThreadsContainer &m_threads;
     Logger &m_logger;
+    CommandID m_list_ids_command;
     int m_current_thread_id;
+    int m_first_row;
+    int m_frames_left;
+};
+
+
+struct ThreadsSnapshotInvoker
+{
+    virtual ~ThreadsSnapshotInvoker() {}
+
+    virtual void Invoke(ThreadsSnapshot const &snapshot) = 0;
 };
 
+/// The maximum number of frames listed for a thread by GenerateThreadsSnapshot.
+const int c_snapshot_max_frames = 100;
+
+/// Lists the stacks of all threads and groups the identical ones. The stacks are listed with --thread, so the
+/// selected thread doesn't change, and all commands are sent at once, so gdb answers them in one stream.
+class GenerateThreadsSnapshot : public Action
+{
+    GenerateThreadsSnapshot(GenerateThreadsSnapshot &);
+    GenerateThreadsSnapshot& operator =(GenerateThreadsSnapshot &);
+public:
+    GenerateThreadsSnapshot(ThreadsSnapshotInvoker *invoker, ThreadsContainer &threads, Logger &logger);
+    virtual ~GenerateThreadsSnapshot();
+    virtual void OnCommandOutput(CommandID const &id, ResultParser const &result);
+protected:
+    virtual void OnStart();
+private:
+    void ListStacks();
+    void Done();
+private:
+    ThreadsSnapshotInvoker *m_invoker;
+    ThreadsContainer &m_threads;
+    Logger &m_logger;
+    ThreadsSnapshot m_snapshot;
+    CommandIDMap<int> m_stack_commands;
+    CommandID m_list_ids_command;
+};
 
 template<typename Notification>
 class SwitchToThread : public Action
@@ -165,6 +263,8 @@ public:
         m_logger(logger),
         m_notification(notification)
     {
+        SetPriority(PriorityHigh);
+        SetSelectsFrame(true);
     }
 
     virtual void OnCommandOutput(CommandID const &/*id*/, ResultParser const &result)
@@ -193,6 +293,8 @@ public:
         m_notification(notification),
         m_user_action(user_action)
     {
+        SetPriority(PriorityHigh);
+        SetSelectsFrame(true);
     }
 
     virtual void OnCommandOutput(CommandID const &/*id*/, ResultParser const &result)
@@ -211,6 +313,12 @@ private:
     bool m_user_action;
 };
 
+/// Number of children listed at once, when a watch is expanded.
+const int c_watch_page_size = 50;
+
+/// Reads the number of children and the dynamic and has_more flags of a -var-create or -var-list-children result.
+void ParseWatchInfo(ResultValue const &value, int &children_count, bool &dynamic, bool &has_more);
+
 class WatchBaseAction : public Action
 {
 public:
@@ -224,7 +332,13 @@ protected:
 
     void SetRange(int start, int end) { m_start = start; m_end = end; }
 protected:
-    typedef std::tr1::unordered_map<CommandID, cb::shared_ptr<Watch> > ListCommandParentMap;
+    struct ListCommand
+    {
+        cb::shared_ptr<Watch> parent;
+        // The page of the parent's children which is listed, -1 if the command doesn't list them directly.
+        int start, end;
+    };
+    typedef CommandIDMap<ListCommand> ListCommandParentMap;
 protected:
     ListCommandParentMap m_parent_map;
     WatchesContainer &m_watches;
@@ -278,6 +392,9 @@ protected:
 
 private:
     bool ParseUpdate(ResultParser const &result);
+    /// Freezes or thaws the varobjs of the watch and its children, so only the shown ones stay live.
+    /// Returns true if some varobj in the tree is live.
+    bool SetLive(cb::shared_ptr<Watch> const &watch, bool live);
 private:
     CommandID   m_update_command;
 };
@@ -285,13 +402,14 @@ private:
 class WatchExpandedAction : public WatchBaseAction
 {
 public:
+    /// Lists the page of children of expanded_watch beginning at start.
     WatchExpandedAction(cb::shared_ptr<Watch> parent_watch, cb::shared_ptr<Watch> expanded_watch,
-                        WatchesContainer &watches, Logger &logger) :
+                        WatchesContainer &watches, Logger &logger, int start = 0) :
         WatchBaseAction(watches, logger),
         m_watch(parent_watch),
         m_expanded_watch(expanded_watch)
     {
-        SetRange(0, 100);
+        SetRange(start, start + c_watch_page_size);
     }
 
     virtual void OnCommandOutput(CommandID const &id, ResultParser const &result);
@@ -1,5 +1,14 @@
 #include "cmd_queue.h"
 
+#include <algorithm>
+#include <cstring>
+
+#ifdef __WXMSW__
+    #include <wx/msw/wrapwin.h>
+#else
+    #include <time.h>
+#endif
+
 namespace dbg_mi
 {
 
@@ -45,7 +54,7 @@ CommandID CommandExecutor::Execute(wxString const &cmd)
         m_logger->Debug(wxT("cmd==>") + id.ToString() + cmd, Logger::Line::Command);
         m_logger->AddCommand(id.ToString() + cmd);
     }
-    if(DoExecute(id, cmd))
+    if(Send(id, cmd))
         return id;
     else
         return dbg_mi::CommandID();
@@ -57,44 +66,255 @@ void CommandExecutor::ExecuteSimple(dbg_mi::CommandID const &id, wxString const
         m_logger->Debug(wxT("cmd==>") + id.ToString() + cmd, Logger::Line::Command);
         m_logger->AddCommand(id.ToString() + cmd);
     }
-    DoExecute(id, cmd);
+    Send(id, cmd);
 }
 
-bool CommandExecutor::ProcessOutput(wxString const &output)
+bool CommandExecutor::Send(dbg_mi::CommandID const &id, wxString const &cmd)
 {
-    dbg_mi::CommandID id;
-    Result r;
+    CommandStats::Class &stats = m_stats.Get(CommandStats::GetCommandClass(cmd));
+    // the token, the command and the new line
+    stats.bytes_out += id.ToString().length() + cmd.length() + 1;
 
-    if(m_logger)
+    // the timestamp is taken before the command is executed, because the mock executors answer immediately
+    InFlightCommand &command = m_in_flight[id];
+    command.timestamp = GetTimestamp();
+    command.stats = &stats;
+    if(DoExecute(id, cmd))
+        return true;
+    m_in_flight.erase(id);
+    return false;
+}
+
+void CommandExecutor::EndBatch()
+{
+    assert(m_batch_depth > 0);
+    if(--m_batch_depth == 0)
+        DoFlush();
+}
+
+int64_t CommandExecutor::GetTimestamp() const
+{
+#ifdef __WXMSW__
+    LARGE_INTEGER frequency, counter;
+    QueryPerformanceFrequency(&frequency);
+    QueryPerformanceCounter(&counter);
+    // split in two, so the multiplication doesn't overflow
+    return counter.QuadPart / frequency.QuadPart * 1000000
+           + counter.QuadPart % frequency.QuadPart * 1000000 / frequency.QuadPart;
+#else
+    timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return int64_t(now.tv_sec) * 1000000 + now.tv_nsec / 1000;
+#endif
+}
+
+bool ParseGDBOutputLine(char const *line, int length, CommandID &id, int &record_start)
+{
+    int pos = 0;
+    while(pos < length && line[pos] >= '0' && line[pos] <= '9')
+        ++pos;
+    if(pos <= 10)
     {
-        if(!dbg_mi::ParseGDBOutputLine(output, r.id, r.output))
-        {
-            m_logger->Debug(wxT("unparsable_output==>") + output, Logger::Line::Unknown);
+        if(pos != 0 || length == 0)
             return false;
+        if(line[0] == '*' || line[0] == '^' || line[0] == '+' || line[0] == '=')
+        {
+            id = CommandID();
+            record_start = 0;
+            return true;
         }
         else
-            m_logger->Debug(wxT("output==>") + output, Logger::Line::CommandResult);
+            return false;
     }
     else
     {
-        if(!dbg_mi::ParseGDBOutputLine(output, r.id, r.output))
-            return false;
+        long action_id = 0, cmd_id = 0;
+        for(int ii = 0; ii < pos - 10; ++ii)
+            action_id = action_id * 10 + (line[ii] - '0');
+        for(int ii = pos - 10; ii < pos; ++ii)
+            cmd_id = cmd_id * 10 + (line[ii] - '0');
+
+        id = dbg_mi::CommandID(action_id, cmd_id);
+        record_start = pos;
+        return true;
     }
+}
 
-    m_results.push_back(r);
+void OutputParser::Feed(char const *data, int length)
+{
+    char const *end = data + length;
+    while(data < end)
+    {
+        char const *line_end = static_cast<char const*>(std::memchr(data, '\n', end - data));
+        if(!line_end)
+        {
+            m_partial.append(data, end - data);
+            return;
+        }
+
+        // the complete lines are parsed directly from the chunk, only the split ones are copied
+        if(m_partial.empty())
+            ParseLine(data, line_end - data);
+        else
+        {
+            m_partial.append(data, line_end - data);
+            ParseLine(m_partial.data(), m_partial.length());
+            m_partial.clear();
+        }
+        data = line_end + 1;
+    }
+}
+
+bool OutputParser::ParseLine(char const *line, int length)
+{
+    while(length > 0 && (line[length - 1] == '\n' || line[length - 1] == '\r'))
+        --length;
+    if(length == 0)
+        return false;
+
+    CommandID id;
+    int record_start;
+    if(!ParseGDBOutputLine(line, length, id, record_start))
+    {
+        m_handler->OnUnknownLine(line, length);
+        return false;
+    }
+
+    ResultParser *parser = new ResultParser;
+    if(!parser->Parse(line + record_start, length - record_start))
+    {
+        delete parser;
+        parser = NULL;
+    }
+    m_handler->OnRecord(id, parser, line, length);
     return true;
 }
 
+ParsedOutput::~ParsedOutput()
+{
+    for(Records::iterator it = m_records.begin(); it != m_records.end(); ++it)
+        delete it->parser;
+}
+
+void ParsedOutput::OnRecord(CommandID const &id, ResultParser *parser, char const *line, int length)
+{
+    Record record;
+    record.id = id;
+    record.parser = parser;
+    record.offset = m_lines.length();
+    record.length = length;
+    record.unknown = false;
+    m_records.push_back(record);
+    m_lines.append(line, length);
+}
+
+void ParsedOutput::OnUnknownLine(char const *line, int length)
+{
+    Record record;
+    record.parser = NULL;
+    record.offset = m_lines.length();
+    record.length = length;
+    record.unknown = true;
+    m_records.push_back(record);
+    m_lines.append(line, length);
+}
+
+void ParsedOutput::Deliver(OutputParser::Handler &handler)
+{
+    for(Records::iterator it = m_records.begin(); it != m_records.end(); ++it)
+    {
+        char const *line = m_lines.data() + it->offset;
+        if(it->unknown)
+            handler.OnUnknownLine(line, it->length);
+        else
+        {
+            ResultParser *parser = it->parser;
+            it->parser = NULL;
+            handler.OnRecord(it->id, parser, line, it->length);
+        }
+    }
+    m_records.clear();
+    m_lines.clear();
+}
+
+CommandExecutor::~CommandExecutor()
+{
+    ClearResults();
+}
+
+bool CommandExecutor::ProcessOutput(wxString const &output)
+{
+    wxCharBuffer const utf8 = output.utf8_str();
+    return m_output_parser.ParseLine(utf8.data(), std::strlen(utf8.data()));
+}
+
+void CommandExecutor::ProcessOutput(char const *data, int length)
+{
+    m_output_parser.Feed(data, length);
+}
+
+void CommandExecutor::OnRecord(CommandID const &id, ResultParser *parser, char const *line, int length)
+{
+    if(m_logger)
+        m_logger->Debug(wxT("output==>") + wxString(line, wxConvUTF8, length), Logger::Line::CommandResult);
+
+    InFlightCommands::iterator it = m_in_flight.find(id);
+    if(it != m_in_flight.end())
+    {
+        CommandStats::Class &stats = *it->second.stats;
+        stats.bytes_in += length + 1;
+
+        // only the result record finishes the command, the async records with the same token come later
+        if(!parser || parser->GetResultType() == ResultParser::Result)
+        {
+            int64_t const latency = GetTimestamp() - it->second.timestamp;
+            m_in_flight.erase(it);
+
+            ++m_latency.count;
+            m_latency.total += latency;
+            m_latency.last = latency;
+            m_latency.max = std::max(m_latency.max, latency);
+            stats.latency.Add(latency);
+        }
+    }
+    else
+        m_stats.Get(CommandStats::c_async_class).bytes_in += length + 1;
+
+    Result r;
+    r.id = id;
+    r.parser = parser;
+    m_results.push_back(r);
+}
+
+void CommandExecutor::OnUnknownLine(char const *line, int length)
+{
+    if(m_logger)
+        m_logger->Debug(wxT("unparsable_output==>") + wxString(line, wxConvUTF8, length), Logger::Line::Unknown);
+    m_stats.Get(CommandStats::c_async_class).bytes_in += length + 1;
+}
+
+void CommandExecutor::ClearResults()
+{
+    for(Results::iterator it = m_results.begin(); it != m_results.end(); ++it)
+        delete it->parser;
+    m_results.clear();
+}
+
 void CommandExecutor::Clear()
 {
     m_last = 0;
-    m_results.clear();
+    ClearResults();
+    m_output_parser.Clear();
+    m_in_flight.clear();
+    m_latency = LatencyStats();
+    m_stats.Clear();
 
     DoClear();
 }
 
 ActionsMap::ActionsMap() :
-    m_last_id(1)
+    m_last_id(1),
+    m_generation(0)
 {
 }
 
@@ -108,26 +328,37 @@ void ActionsMap::Add(Action *action)
 {
     action->SetID(m_last_id++);
     m_actions.push_back(action);
+    m_actions_by_id[action->GetID()] = action;
+    CancelIfStale(*action);
 }
 
-Action* ActionsMap::Find(int id)
+void ActionsMap::CancelIfStale(Action &action)
+{
+    if(action.Canceled() || action.GetGeneration() < 0 || action.GetGeneration() >= m_generation)
+        return;
+    // the actions which have sent some commands are left to finish, if canceling them would break their state
+    if(!action.Started() || action.CanCancelStarted())
+        action.Cancel();
+}
+
+void ActionsMap::NewGeneration()
 {
+    ++m_generation;
+    // the canceled actions are removed by Run, one of them may be dispatching its result right now
     for(Actions::iterator it = m_actions.begin(); it != m_actions.end(); ++it)
-    {
-        if((*it)->GetID() == id)
-            return *it;
-    }
-    return NULL;
+        CancelIfStale(**it);
+}
+
+Action* ActionsMap::Find(int id)
+{
+    ActionsByID::iterator it = m_actions_by_id.find(id);
+    return it != m_actions_by_id.end() ? it->second : NULL;
 }
 
 Action const * ActionsMap::Find(int id) const
 {
-    for(Actions::const_iterator it = m_actions.begin(); it != m_actions.end(); ++it)
-    {
-        if((*it)->GetID() == id)
-            return *it;
-    }
-    return NULL;
+    ActionsByID::const_iterator it = m_actions_by_id.find(id);
+    return it != m_actions_by_id.end() ? it->second : NULL;
 }
 
 void ActionsMap::Clear()
@@ -135,59 +366,108 @@ void ActionsMap::Clear()
     for(Actions::iterator it = m_actions.begin(); it != m_actions.end(); ++it)
         delete *it;
     m_actions.clear();
+    m_actions_by_id.clear();
     m_last_id = 1;
+    m_generation = 0;
 }
 
-void ActionsMap::Run(CommandExecutor &executor)
+bool ActionsMap::CanExecute(CommandExecutor const &executor, Action::Priority priority)
 {
-    if(Empty())
-        return;
+    int const max_in_flight = executor.GetMaxInFlight();
+    if(priority == Action::PriorityHigh || max_in_flight <= 0)
+        return executor.CanExecute();
 
-    Logger *logger = executor.GetLogger();
+    int const limit = std::max(max_in_flight - max_in_flight / 4, 1);
+    return executor.GetInFlightCount() < limit;
+}
 
-    bool first = true;
-    for(Actions::iterator it = m_actions.begin(); it != m_actions.end(); )
+size_t ActionsMap::GetSchedulableCount() const
+{
+    // the first action can be a barrier, which has waited for all previous actions to finish
+    size_t count = 1;
+    while(count < m_actions.size() && !m_actions[count]->GetWaitPrevious())
+        ++count;
+
+    // A command using the frame, which is sent after the selection, would be evaluated in the new frame.
+    bool frame_commands_left = false;
+    for(size_t ii = 0; ii < count; ++ii)
     {
-        Action &action = **it;
+        Action const &action = *m_actions[ii];
+        if(action.Canceled())
+            continue;
+        if(action.GetSelectsFrame() && !action.Started() && frame_commands_left)
+            return ii;
+        if(action.GetUsesFrame() && (!action.Started() || action.HasPendingCommands()))
+            frame_commands_left = true;
+    }
+    return count;
+}
 
-        // test if we have a barrier action
-        if(action.GetWaitPrevious() && !first)
-            break;
+bool ActionsMap::RunActions(CommandExecutor &executor)
+{
+    Logger *logger = executor.GetLogger();
+    size_t count = GetSchedulableCount();
 
-        if(!action.Started())
+    bool window_full = false;
+    for(int priority = Action::PriorityHigh; priority <= Action::PriorityLow && !window_full; ++priority)
+    {
+        for(size_t ii = 0; ii < count; ++ii)
         {
-            if(logger)
+            Action &action = *m_actions[ii];
+            if(action.GetPriority() != priority || action.Canceled())
+                continue;
+
+            if(!action.Started())
             {
-                logger->Debug(wxString::Format(wxT("ActionsMap::Run -> starting action: %p id: %d"),
-                                               &action, action.GetID()),
-                              Logger::Line::Debug);
+                if(logger)
+                {
+                    logger->Debug(wxString::Format(wxT("ActionsMap::Run -> starting action: %p id: %d"),
+                                                   &action, action.GetID()),
+                                  Logger::Line::Debug);
+                }
+                action.Start();
+            }
+            while(action.HasPendingCommands() && CanExecute(executor, action.GetPriority()))
+            {
+                CommandID id;
+                wxString const &command = action.PopPendingCommand(id);
+                executor.ExecuteSimple(id, command);
+            }
+            // the window is full, the rest will be sent when some of the results arrive
+            if(action.HasPendingCommands())
+            {
+                window_full = true;
+                break;
             }
-            action.Start();
-        }
-        while(action.HasPendingCommands())
-        {
-            CommandID id;
-            wxString const &command = action.PopPendingCommand(id);
-            executor.ExecuteSimple(id, command);
         }
+    }
 
-        first = false;
-        if(!action.Finished())
-            ++it;
-        else
+    bool removed = false;
+    for(size_t ii = 0; ii < count; )
+    {
+        Action *action = m_actions[ii];
+        if(action->Finished() && !action->HasPendingCommands())
         {
-            if(logger && action.HasPendingCommands())
-            {
-                logger->Debug(wxString::Format(wxT("ActionsMap::Run -> action[%p id: %d] ")
-                                               wxT("has pending commands but is being removed"),
-                                               &action, action.GetID()),
-                              Logger::Line::Debug);
-            }
-            delete *it;
-            it = m_actions.erase(it);
-            if (it == m_actions.begin())
-                first = true;
+            m_actions_by_id.erase(action->GetID());
+            delete action;
+            m_actions.erase(m_actions.begin() + ii);
+            --count;
+            removed = true;
         }
+        else
+            ++ii;
     }
+    return removed;
+}
+
+void ActionsMap::Run(CommandExecutor &executor)
+{
+    if(Empty())
+        return;
+
+    executor.BeginBatch();
+    while(!Empty() && RunActions(executor))
+        ;
+    executor.EndBatch();
 }
 } // namespace dbg_mi
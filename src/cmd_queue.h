@@ -4,11 +4,14 @@
 
 #include <deque>
 #include <ostream>
+#include <string>
 #include <tr1/unordered_map>
+#include <vector>
 
 #include <wx/string.h>
 
 #include "cmd_result_parser.h"
+#include "command_stats.h"
 /*
 #include <wx/thread.h>
 class PipedProcess;
@@ -66,9 +69,11 @@ public:
         return m_command_in_action;
     }
 
+    /// The action in the high 32 bits and the command in the low 32 bits, so every id has its own key.
     int64_t GetFullID() const
     {
-        return (static_cast<int64_t>(m_action) >> 32) + m_command_in_action;
+        return static_cast<int64_t>((static_cast<uint64_t>(static_cast<uint32_t>(m_action)) << 32)
+                                    | static_cast<uint32_t>(m_command_in_action));
     }
 
 private:
@@ -81,7 +86,95 @@ inline std::ostream& operator<< (std::ostream& s, CommandID const &id)
     return s;
 }
 
+} // namespace dbg_mi
+
+namespace std
+{
+namespace tr1
+{
+template <>
+struct hash<dbg_mi::CommandID> : public unary_function<dbg_mi::CommandID, size_t>
+{
+   size_t operator()(dbg_mi::CommandID const& v) const
+   {
+       return std::tr1::hash<int64_t>()(v.GetFullID());
+   }
+};
+
+}
+}
+
+namespace dbg_mi
+{
+
 bool ParseGDBOutputLine(wxString const &line, CommandID &id, wxString &result_str);
+/// Same as above, but works on the raw bytes; record_start is the position of the record after the id.
+bool ParseGDBOutputLine(char const *line, int length, CommandID &id, int &record_start);
+
+/// Push parser for the output of gdb.
+/// It is fed with the bytes as they are read from the pipe and the lines can be split between the chunks at
+/// any place. Every complete line is parsed in place and passed to the handler.
+class OutputParser
+{
+    OutputParser(OutputParser const &);
+    OutputParser& operator =(OutputParser const &);
+public:
+    struct Handler
+    {
+        virtual ~Handler() {}
+
+        /// The handler takes the ownership of the parser, which is NULL if the record could not be parsed.
+        virtual void OnRecord(CommandID const &id, ResultParser *parser, char const *line, int length) = 0;
+        virtual void OnUnknownLine(char const *line, int length) = 0;
+    };
+public:
+    explicit OutputParser(Handler &handler) : m_handler(&handler) {}
+
+    /// The next records are passed to the new handler, the incomplete line is kept.
+    void SetHandler(Handler &handler) { m_handler = &handler; }
+
+    void Feed(char const *data, int length);
+    /// Parses a complete line, the line end is optional. Returns false for the lines which are not MI records.
+    bool ParseLine(char const *line, int length);
+
+    bool HasPartialLine() const { return !m_partial.empty(); }
+    void Clear() { m_partial.clear(); }
+private:
+    std::string m_partial;
+    Handler *m_handler;
+};
+
+/// Collects the records parsed on another thread, so they can be passed to the executor later in the same order.
+class ParsedOutput : public OutputParser::Handler
+{
+    ParsedOutput(ParsedOutput const &);
+    ParsedOutput& operator =(ParsedOutput const &);
+public:
+    ParsedOutput() {}
+    ~ParsedOutput();
+
+    virtual void OnRecord(CommandID const &id, ResultParser *parser, char const *line, int length);
+    virtual void OnUnknownLine(char const *line, int length);
+
+    bool Empty() const { return m_records.empty(); }
+    int GetCount() const { return m_records.size(); }
+
+    /// Passes the records to the handler, which takes the ownership of the parsers.
+    void Deliver(OutputParser::Handler &handler);
+private:
+    struct Record
+    {
+        CommandID id;
+        ResultParser *parser;
+        int offset, length;
+        bool unknown;
+    };
+    typedef std::vector<Record> Records;
+
+    Records m_records;
+    // the lines of all records, they are needed for the log
+    std::string m_lines;
+};
 
 class Action
 {
@@ -98,13 +191,26 @@ class Action
         int id;
     };
     typedef std::deque<Command> PendingCommands;
+public:
+    /// The actions of a higher priority send their commands first and they can use the whole in-flight window.
+    enum Priority
+    {
+        PriorityHigh = 0,   ///< the position, the thread and the frame the user is looking at
+        PriorityNormal,     ///< the watches and the tooltips
+        PriorityLow         ///< the refreshes, which can wait
+    };
 public:
     Action() :
         m_id(-1),
         m_last_command_id(0),
+        m_generation(-1),
+        m_priority(PriorityNormal),
         m_started(false),
         m_finished(false),
-        m_wait_previous(false)
+        m_canceled(false),
+        m_wait_previous(false),
+        m_selects_frame(false),
+        m_uses_frame(false)
     {
     }
 
@@ -124,12 +230,37 @@ public:
         m_finished = true;
     }
 
+    /// Drops the commands which aren't sent yet, the results of the sent ones are discarded.
+    void Cancel()
+    {
+        m_pending_commands.clear();
+        m_canceled = true;
+        m_finished = true;
+    }
+
     bool Started() const { return m_started; }
     bool Finished() const { return m_finished; }
+    bool Canceled() const { return m_canceled; }
+
+    /// The stop the action refreshes the UI for, -1 if it isn't tied to a stop.
+    void SetGeneration(int generation) { m_generation = generation; }
+    int GetGeneration() const { return m_generation; }
+    /// Returns true if the action can be canceled after it has sent some of its commands.
+    virtual bool CanCancelStarted() const { return false; }
 
     void SetWaitPrevious(bool flag) { m_wait_previous = flag; }
     bool GetWaitPrevious() const { return m_wait_previous; }
 
+    void SetPriority(Priority priority) { m_priority = priority; }
+    Priority GetPriority() const { return m_priority; }
+
+    /// The action changes the selected thread or frame, so it isn't moved ahead of the actions using them.
+    void SetSelectsFrame(bool flag) { m_selects_frame = flag; }
+    bool GetSelectsFrame() const { return m_selects_frame; }
+    /// The commands of the action are evaluated in the selected thread and frame.
+    void SetUsesFrame(bool flag) { m_uses_frame = flag; }
+    bool GetUsesFrame() const { return m_uses_frame; }
+
     CommandID Execute(wxString const &command)
     {
         m_pending_commands.push_back(Command(command, m_last_command_id));
@@ -158,49 +289,85 @@ private:
     PendingCommands m_pending_commands;
     int m_id;
     int m_last_command_id;
+    int m_generation;
+    Priority m_priority;
     bool m_started;
     bool m_finished;
+    bool m_canceled;
     bool m_wait_previous;
+    bool m_selects_frame;
+    bool m_uses_frame;
 };
 
-class CommandExecutor
+class CommandExecutor : private OutputParser::Handler
 {
 public:
     struct Result
     {
         dbg_mi::CommandID id;
-        wxString output;
+        dbg_mi::ResultParser *parser;
+    };
+public:
+    struct LatencyStats
+    {
+        LatencyStats() : count(0), total(0), max(0), last(0) {}
+
+        int count;
+        int64_t total, max, last;
     };
 public:
     CommandExecutor() :
+        m_output_parser(*this),
         m_last(0),
+        m_max_in_flight(0),
+        m_batch_depth(0),
         m_logger(NULL)
     {
     }
-    virtual ~CommandExecutor() {}
+    virtual ~CommandExecutor();
 
     CommandID Execute(wxString const &cmd);
     void ExecuteSimple(dbg_mi::CommandID const &id, wxString const &cmd);
 
+    /// Limits the number of commands which are sent, but have no result yet; 0 means no limit.
+    void SetMaxInFlight(int count) { m_max_in_flight = count; }
+    int GetMaxInFlight() const { return m_max_in_flight; }
+    int GetInFlightCount() const { return m_in_flight.size(); }
+    bool CanExecute() const { return m_max_in_flight <= 0 || GetInFlightCount() < m_max_in_flight; }
+
+    /// The commands executed between BeginBatch and EndBatch can be sent to gdb with a single write.
+    void BeginBatch() { ++m_batch_depth; }
+    void EndBatch();
+
+    /// Time in microseconds between sending the commands and receiving their results.
+    LatencyStats const & GetLatencyStats() const { return m_latency; }
+    /// The latencies and the traffic of the commands grouped by their class.
+    CommandStats const & GetStats() const { return m_stats; }
+    void AddProcessingTime(int64_t time) { m_stats.Get(CommandStats::c_processing_class).latency.Add(time); }
+
+    /// Monotonic time in microseconds.
+    virtual int64_t GetTimestamp() const;
+
     virtual wxString GetOutput() = 0;
 
     bool HasOutput() const { return !m_results.empty(); }
+    /// Processes a single line of output.
     bool ProcessOutput(wxString const &output);
+    /// Processes a chunk of the raw output, which doesn't have to end at a line end.
+    void ProcessOutput(char const *data, int length);
+    /// Processes the records, which were parsed by another thread.
+    void ProcessOutput(ParsedOutput &output) { output.Deliver(*this); }
 
     void Clear();
 
+    /// The caller takes the ownership of the returned parser, it is NULL if the record could not be parsed.
     dbg_mi::ResultParser* GetResult(dbg_mi::CommandID &id)
     {
         assert(!m_results.empty());
         Result const &r = m_results.front();
 
         id = r.id;
-        dbg_mi::ResultParser *parser = new dbg_mi::ResultParser;
-        if(!parser->Parse(r.output))
-        {
-            delete parser;
-            parser = NULL;
-        }
+        dbg_mi::ResultParser *parser = r.parser;
 
         m_results.pop_front();
         return parser;
@@ -213,11 +380,32 @@ public:
 protected:
     virtual bool DoExecute(dbg_mi::CommandID const &id, wxString const &cmd) = 0;
     virtual void DoClear() = 0;
+    /// Called at the end of the outer batch, the commands collected by DoExecute should be sent now.
+    virtual void DoFlush() {}
 
+    bool IsBatching() const { return m_batch_depth > 0; }
+private:
+    virtual void OnRecord(CommandID const &id, ResultParser *parser, char const *line, int length);
+    virtual void OnUnknownLine(char const *line, int length);
+    bool Send(dbg_mi::CommandID const &id, wxString const &cmd);
+    void ClearResults();
 protected:
     typedef std::deque<Result> Results;
+    struct InFlightCommand
+    {
+        int64_t timestamp;
+        CommandStats::Class *stats;
+    };
+    typedef std::tr1::unordered_map<CommandID, InFlightCommand> InFlightCommands;
+
     Results m_results;
+    OutputParser m_output_parser;
+    InFlightCommands m_in_flight;
+    LatencyStats m_latency;
+    CommandStats m_stats;
     int32_t m_last;
+    int m_max_in_flight;
+    int m_batch_depth;
     Logger *m_logger;
 };
 
@@ -233,46 +421,35 @@ public:
     void Clear();
     int GetLastID() const { return m_last_id; }
 
+    /// Starts a new stop generation, the actions of the older generations are canceled.
+    /// Called when a run command is queued, so only the last stop in a burst of steps is refreshed.
+    void NewGeneration();
+    int GetGeneration() const { return m_generation; }
+
     bool Empty() const { return m_actions.empty(); }
+    /// Starts the actions and sends their commands. The actions before the first barrier are scheduled by their
+    /// priority, the actions of the same priority in the order they were added. An action selecting a thread or a
+    /// frame waits like a barrier, until the earlier actions using the selected frame have sent all their commands.
     void Run(CommandExecutor &executor);
+private:
+    /// Returns true if some action has been removed, so a barrier may have become the first action.
+    bool RunActions(CommandExecutor &executor);
+    /// The number of actions, which can be scheduled.
+    size_t GetSchedulableCount() const;
+    /// Cancels the action if it refreshes a superseded stop.
+    void CancelIfStale(Action &action);
+    /// If the window is limited, the lower priorities can't fill it, so a command of the user is sent at once.
+    static bool CanExecute(CommandExecutor const &executor, Action::Priority priority);
 private:
     typedef std::deque<Action*> Actions;
+    typedef std::tr1::unordered_map<int, Action*> ActionsByID;
 
     Actions m_actions;
+    ActionsByID m_actions_by_id;
     int m_last_id;
+    int m_generation;
 };
 
-template<typename OnNotify>
-bool DispatchResults(CommandExecutor &exec, ActionsMap &actions_map, OnNotify &on_notify)
-{
-    while(exec.HasOutput())
-    {
-        CommandID id;
-        ResultParser *parser = exec.GetResult(id);
-
-        if(!parser)
-            return false;
-
-        switch(parser->GetResultType())
-        {
-        case ResultParser::Result:
-            {
-                Action *action = actions_map.Find(id.GetActionID());
-                if(action)
-                    action->OnCommandOutput(id, *parser);
-            }
-            break;
-        case ResultParser::TypeUnknown:
-            break;
-        default:
-            on_notify(*parser);
-        }
-
-        delete parser;
-    }
-    return true;
-}
-
 class Logger
 {
 public:
@@ -312,22 +489,48 @@ public:
     virtual void ClearCommand() = 0;
 };
 
-} // namespace dbg_mi
-
-namespace std
-{
-namespace tr1
-{
-template <>
-struct hash<dbg_mi::CommandID> : public unary_function<dbg_mi::CommandID, size_t>
+/// Passes all results to their actions and the notifications to on_notify. Returns false if some record couldn't
+/// be parsed; it is skipped, so the records after it aren't stuck in the queue.
+template<typename OnNotify>
+bool DispatchResults(CommandExecutor &exec, ActionsMap &actions_map, OnNotify &on_notify)
 {
-   size_t operator()(dbg_mi::CommandID const& v) const
-   {
-       return std::tr1::hash<int64_t>()(v.GetFullID());
-   }
-};
+    bool parsed = true;
+    while(exec.HasOutput())
+    {
+        CommandID id;
+        ResultParser *parser = exec.GetResult(id);
 
+        if(!parser)
+        {
+            if(exec.GetLogger())
+                exec.GetLogger()->Debug(wxT("DispatchResults: skipping a record, which can't be parsed, id: ")
+                                        + id.ToString());
+            parsed = false;
+            continue;
+        }
+
+        int64_t const start = exec.GetTimestamp();
+        switch(parser->GetResultType())
+        {
+        case ResultParser::Result:
+            {
+                Action *action = actions_map.Find(id.GetActionID());
+                if(action && !action->Canceled())
+                    action->OnCommandOutput(id, *parser);
+            }
+            break;
+        case ResultParser::TypeUnknown:
+            break;
+        default:
+            on_notify(*parser);
+        }
+
+        delete parser;
+        exec.AddProcessingTime(exec.GetTimestamp() - start);
+    }
+    return parsed;
 }
-}
+
+} // namespace dbg_mi
 
 #endif // _DEBUGGER_MI_GDB_CMD_QUEUE_H_
@@ -1,5 +1,11 @@
 #include "cmd_result_parser.h"
 
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <string>
+
 #include "cmd_result_tokens.h"
 
 namespace dbg_mi
@@ -34,10 +40,209 @@ bool StripEnclosingQuotes(wxString &str)
     return true;
 }
 
-bool ParseTuple(wxString const &str, int &start, ResultValue &tuple, bool want_closing_brace)
+namespace
+{
+
+/// Input for the parser, which works on the raw UTF-8 bytes and copies the names and values
+/// directly in the arena of the ResultValue tree.
+class UTF8Input
+{
+public:
+    UTF8Input(char const *str, int length) : m_str(str), m_length(length) {}
+
+    int Length() const { return m_length; }
+    char At(int pos) const { return m_str[pos]; }
+    bool NextToken(int pos, Token &token) const { return GetNextToken(m_str, m_length, pos, token); }
+    bool StartsWith(int pos, char const *prefix) const
+    {
+        for(; *prefix; ++prefix, ++pos)
+        {
+            if(pos >= m_length || m_str[pos] != *prefix)
+                return false;
+        }
+        return true;
+    }
+    wxString Extract(int start, int end) const { return wxString(m_str + start, wxConvUTF8, end - start); }
+
+    void SetName(Token const &token, ResultValue &value) const
+    {
+        value.SetName(m_str + token.start, token.Length());
+    }
+    // Used for the elements of a list, which have only a value and no name.
+    void SetNameAsValue(Token const &name, ResultValue &value) const
+    {
+        value.SetType(ResultValue::Simple);
+        value.SetSimpleValue(m_str + name.start, name.Length());
+        value.SetName(NULL, 0);
+    }
+
+    // Does the same as StripEnclosingQuotes, but in a single pass over the bytes of the token.
+    bool SetSimpleValue(Token const &token, ResultValue &value) const
+    {
+        char const *str = m_str + token.start;
+        int length = token.Length();
+        if(length == 0)
+        {
+            value.SetSimpleValue(str, 0);
+            return true;
+        }
+        if(str[0] == '"' && str[length - 1] == '"')
+        {
+            if(length >= 2 && str[length - 2] == '\\')
+                return false;
+            ++str;
+            length = std::max(length - 2, 0);
+        }
+        else if(str[0] == '"')
+            return false;
+        else if(str[length - 1] == '"')
+        {
+            if(length >= 2 && str[length - 2] != '\\')
+                return false;
+        }
+
+        if(!std::memchr(str, '\\', length))
+        {
+            value.SetSimpleValue(str, length);
+            return true;
+        }
+
+        // Every backslash in front of a quote is dropped, so \\\" becomes ".
+        std::string unescaped;
+        unescaped.reserve(length);
+        for(int ii = 0; ii < length; ++ii)
+        {
+            if(str[ii] == '"')
+            {
+                while(!unescaped.empty() && unescaped[unescaped.length() - 1] == '\\')
+                    unescaped.erase(unescaped.length() - 1);
+            }
+            unescaped += str[ii];
+        }
+        value.SetSimpleValue(unescaped.c_str(), unescaped.length());
+        return true;
+    }
+private:
+    char const *m_str;
+    int m_length;
+};
+
+size_t const c_arena_alignment = 16;
+size_t const c_arena_first_chunk = 4096;
+size_t const c_arena_max_chunk = 65536;
+
+inline size_t AlignArenaSize(size_t size)
+{
+    return (size + c_arena_alignment - 1) & ~(c_arena_alignment - 1);
+}
+
+wxString const c_empty_string;
+
+/// Tuples with fewer values are searched linearly.
+int const c_tuple_index_threshold = 16;
+
+/// Keys shorter than this are converted to UTF-8 on the stack.
+int const c_key_buffer_size = 64;
+
+/// FNV-1a hash of the UTF-8 bytes of a name.
+inline unsigned HashName(char const *name, int length)
+{
+    unsigned hash = 2166136261u;
+    for(int ii = 0; ii < length; ++ii)
+    {
+        hash ^= static_cast<unsigned char>(name[ii]);
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+} // anonymous namespace
+
+ResultArena::ResultArena() :
+    m_chunks(NULL),
+    m_strings(NULL),
+    m_allocated(0)
+{
+}
+
+ResultArena::~ResultArena()
 {
-    Token token;
+    for(ConvertedString *str = m_strings; str; str = str->next)
+        str->~ConvertedString();
+    while(m_chunks)
+    {
+        Chunk *next = m_chunks->next;
+        delete [] reinterpret_cast<char*>(m_chunks);
+        m_chunks = next;
+    }
+}
+
+void* ResultArena::Allocate(size_t size)
+{
+    size = AlignArenaSize(std::max(size, size_t(1)));
+    size_t const header = AlignArenaSize(sizeof(Chunk));
+
+    if(m_chunks && m_chunks->used + size <= m_chunks->size)
+    {
+        char *result = reinterpret_cast<char*>(m_chunks) + header + m_chunks->used;
+        m_chunks->used += size;
+        return result;
+    }
+
+    size_t chunk_size = m_chunks ? std::min(m_chunks->size * 2, c_arena_max_chunk) : c_arena_first_chunk;
+    bool const dedicated = size > chunk_size / 2;
+    if(dedicated)
+        chunk_size = size;
+
+    Chunk *chunk = reinterpret_cast<Chunk*>(new char[header + chunk_size]);
+    chunk->size = chunk_size;
+    chunk->used = size;
+    m_allocated += chunk_size;
+
+    // Big blocks go behind the current chunk, so its free space is still used by the next allocations.
+    if(dedicated && m_chunks)
+    {
+        chunk->next = m_chunks->next;
+        m_chunks->next = chunk;
+    }
+    else
+    {
+        chunk->next = m_chunks;
+        m_chunks = chunk;
+    }
+    return reinterpret_cast<char*>(chunk) + header;
+}
+
+char* ResultArena::CopyString(char const *str, int length)
+{
+    char *result = static_cast<char*>(Allocate(length));
+    std::memcpy(result, str, length);
+    return result;
+}
+
+wxString const & ResultArena::ConvertString(char const *str, int length)
+{
+    ConvertedString *converted = new (Allocate(sizeof(ConvertedString))) ConvertedString;
+    converted->value = wxString(str, wxConvUTF8, length);
+    converted->next = m_strings;
+    m_strings = converted;
+    return converted->value;
+}
+
+int ResultArena::GetChunkCount() const
+{
+    int count = 0;
+    for(Chunk const *chunk = m_chunks; chunk; chunk = chunk->next)
+        ++count;
+    return count;
+}
+
+template<typename Input>
+bool ParseTuple(Input const &input, int &start, ResultValue &tuple, bool want_closing_brace)
+{
+    Token token, name_token;
     int pos = start;
+    // The values are allocated in the arena of the tuple, so nothing has to be freed on error.
     ResultValue *curr_value = NULL;
 
     enum Step
@@ -49,9 +254,9 @@ bool ParseTuple(wxString const &str, int &start, ResultValue &tuple, bool want_c
     };
     Step step = Nothing;
 
-    while(pos < static_cast<int>(str.length()))
+    while(pos < input.Length())
     {
-        if(!GetNextToken(str, pos, token))
+        if(!input.NextToken(pos, token))
             return false;
 
         switch(token.type)
@@ -65,11 +270,8 @@ bool ParseTuple(wxString const &str, int &start, ResultValue &tuple, bool want_c
                 step = Value;
 
                 curr_value->SetType(ResultValue::Simple);
-                wxString value = token.ExtractString(str);
-
-                if(!StripEnclosingQuotes(value))
+                if(!input.SetSimpleValue(token, *curr_value))
                     return false;
-                curr_value->SetSimpleValue(value);
             }
             else
             {
@@ -77,19 +279,15 @@ bool ParseTuple(wxString const &str, int &start, ResultValue &tuple, bool want_c
                     return false;
                 step = Name;
 
-                curr_value = new ResultValue;
-                curr_value->SetName(token.ExtractString(str));
+                curr_value = tuple.NewTupleValue();
+                input.SetName(token, *curr_value);
+                name_token = token;
             }
             break;
 
         case Token::Equal:
-            if(!curr_value)
-                return false;
-            if(step != Name)
-            {
-                delete curr_value;
+            if(!curr_value || step != Name)
                 return false;
-            }
             step = Equal;
             break;
 
@@ -99,26 +297,16 @@ bool ParseTuple(wxString const &str, int &start, ResultValue &tuple, bool want_c
             if(tuple.GetType() == ResultValue::Array)
             {
                 if(step == Name)
-                {
-                    curr_value->SetType(ResultValue::Simple);
-                    curr_value->SetSimpleValue(curr_value->GetName());
-                    curr_value->SetName(_T(""));
-                }
+                    input.SetNameAsValue(name_token, *curr_value);
                 else if(step != Value)
-                {
-                    delete curr_value;
                     return false;
-                }
             }
             else
             {
                 if(step != Value)
-                {
-                    delete curr_value;
                     return false;
-                }
             }
-            tuple.SetTupleValue(curr_value);
+            tuple.AttachTupleValue(curr_value);
             curr_value = NULL;
             step = Nothing;
             break;
@@ -130,23 +318,17 @@ bool ParseTuple(wxString const &str, int &start, ResultValue &tuple, bool want_c
                     return false;
                 else
                 {
-                    curr_value = new ResultValue;
+                    curr_value = tuple.NewTupleValue();
                     step = Equal;
                 }
             }
             if(step != Equal)
-            {
-                delete curr_value;
                 return false;
-            }
 
             curr_value->SetType(ResultValue::Tuple);
             pos = token.end;
-            if(!ParseTuple(str, pos, *curr_value, true))
-            {
-                delete curr_value;
+            if(!ParseTuple(input, pos, *curr_value, true))
                 return false;
-            }
             else
             {
                 token.end = pos;
@@ -156,20 +338,12 @@ bool ParseTuple(wxString const &str, int &start, ResultValue &tuple, bool want_c
             break;
 
         case Token::ListStart:
-            if(!curr_value)
+            if(!curr_value || step != Equal)
                 return false;
-            if(step != Equal)
-            {
-                delete curr_value;
-                return false;
-            }
             curr_value->SetType(ResultValue::Array);
             pos = token.end;
-            if(!ParseTuple(str, pos, *curr_value, true))
-            {
-                delete curr_value;
+            if(!ParseTuple(input, pos, *curr_value, true))
                 return false;
-            }
             else
             {
                 token.end = pos;
@@ -182,44 +356,26 @@ bool ParseTuple(wxString const &str, int &start, ResultValue &tuple, bool want_c
             if(!curr_value)
                 return false;
             if(tuple.GetType() != ResultValue::Tuple || !want_closing_brace)
-            {
-                delete curr_value;
                 return false;
-            }
             if(step != Value)
-            {
-                delete curr_value;
                 return false;
-            }
             start = pos + 1;
-            tuple.SetTupleValue(curr_value);
+            tuple.AttachTupleValue(curr_value);
             return true;
 
         case Token::ListEnd:
-//            if(!curr_value)
-//                return false;
             if(tuple.GetType() != ResultValue::Array || !want_closing_brace)
-            {
-                delete curr_value;
                 return false;
-            }
 
             if(step == Name)
             {
-                curr_value->SetType(ResultValue::Simple);
-                curr_value->SetSimpleValue(curr_value->GetName());
-                curr_value->SetName(_T(""));
-                tuple.SetTupleValue(curr_value);
+                input.SetNameAsValue(name_token, *curr_value);
+                tuple.AttachTupleValue(curr_value);
             }
             else if(step == Value)
-            {
-                tuple.SetTupleValue(curr_value);
-            }
+                tuple.AttachTupleValue(curr_value);
             else if(step != Nothing || curr_value)
-            {
-                delete curr_value;
                 return false;
-            }
 
             start = pos + 1;
             return true;
@@ -233,12 +389,9 @@ bool ParseTuple(wxString const &str, int &start, ResultValue &tuple, bool want_c
     if(curr_value)
     {
         if(step != Value)
-        {
-            delete curr_value;
             return false;
-        }
         else
-            tuple.SetTupleValue(curr_value);
+            tuple.AttachTupleValue(curr_value);
     }
     if(token.type == Token::Comma || token.type == Token::ListStart || token.type == Token::TupleStart)
         return false;
@@ -253,9 +406,177 @@ bool ParseTuple(wxString const &str, int &start, ResultValue &tuple, bool want_c
 
 
 bool ParseValue(wxString const &str, ResultValue &results, int start)
+{
+    wxCharBuffer const utf8 = str.substr(start).utf8_str();
+    return ParseValue(utf8.data(), std::strlen(utf8.data()), results, 0);
+}
+
+bool ParseValue(char const *str, int length, ResultValue &results, int start)
 {
     results.SetType(ResultValue::Tuple);
-    return ParseTuple(str, start, results, false);
+    return ParseTuple(UTF8Input(str, length), start, results, false);
+}
+
+ResultValue::ResultValue() :
+    m_values(NULL),
+    m_count(0),
+    m_capacity(0),
+    m_name_string(NULL),
+    m_simple_string(NULL),
+    m_index(NULL),
+    m_index_mask(0),
+    m_type(Simple),
+    m_arena(NULL),
+    m_owns_arena(false)
+{
+}
+
+ResultValue::ResultValue(wxChar const *name, Type type) :
+    m_values(NULL),
+    m_count(0),
+    m_capacity(0),
+    m_name_string(NULL),
+    m_simple_string(NULL),
+    m_index(NULL),
+    m_index_mask(0),
+    m_type(type),
+    m_arena(NULL),
+    m_owns_arena(false)
+{
+    SetName(name);
+}
+
+ResultValue::ResultValue(ResultArena *arena) :
+    m_values(NULL),
+    m_count(0),
+    m_capacity(0),
+    m_name_string(NULL),
+    m_simple_string(NULL),
+    m_index(NULL),
+    m_index_mask(0),
+    m_type(Simple),
+    m_arena(arena),
+    m_owns_arena(false)
+{
+}
+
+ResultValue::ResultValue(ResultValue const &o) :
+    m_values(NULL),
+    m_count(0),
+    m_capacity(0),
+    m_name_string(NULL),
+    m_simple_string(NULL),
+    m_index(NULL),
+    m_index_mask(0),
+    m_type(Simple),
+    m_arena(NULL),
+    m_owns_arena(false)
+{
+    CopyFrom(o);
+}
+
+ResultValue::~ResultValue()
+{
+    // Only the root of the tree owns the arena, the other values live inside it and are never destroyed.
+    if(m_owns_arena)
+        delete m_arena;
+}
+
+void ResultValue::Swap(ResultValue &o)
+{
+    std::swap(m_name, o.m_name);
+    std::swap(m_simple, o.m_simple);
+    std::swap(m_name_string, o.m_name_string);
+    std::swap(m_simple_string, o.m_simple_string);
+    std::swap(m_values, o.m_values);
+    std::swap(m_count, o.m_count);
+    std::swap(m_capacity, o.m_capacity);
+    std::swap(m_index, o.m_index);
+    std::swap(m_index_mask, o.m_index_mask);
+    std::swap(m_type, o.m_type);
+    std::swap(m_arena, o.m_arena);
+    std::swap(m_owns_arena, o.m_owns_arena);
+}
+
+void ResultValue::CopyFrom(ResultValue const &o)
+{
+    m_type = o.m_type;
+    SetName(o.m_name.data, o.m_name.length);
+    SetSimpleValue(o.m_simple.data, o.m_simple.length);
+
+    m_count = 0;
+    if(o.m_count > 0)
+    {
+        ResultArena &arena = GetArena();
+        m_values = static_cast<ResultValue**>(arena.Allocate(o.m_count * sizeof(ResultValue*)));
+        m_capacity = o.m_count;
+        for(int ii = 0; ii < o.m_count; ++ii)
+        {
+            ResultValue *value = NewTupleValue();
+            value->CopyFrom(*o.m_values[ii]);
+            m_values[m_count++] = value;
+        }
+    }
+}
+
+bool ResultValue::operator ==(ResultValue const &o) const
+{
+    if(m_type != o.m_type || !m_name.Equals(o.m_name))
+        return false;
+
+    switch(m_type)
+    {
+    case Simple:
+        return m_simple.Equals(o.m_simple);
+    case Array:
+    case Tuple:
+        if(m_count != o.m_count)
+            return false;
+        for(int ii = 0; ii < m_count; ++ii)
+        {
+            if(*m_values[ii] != *o.m_values[ii])
+                return false;
+        }
+        return true;
+    }
+    return false;
+}
+
+ResultArena& ResultValue::GetArena()
+{
+    if(!m_arena)
+    {
+        m_arena = new ResultArena;
+        m_owns_arena = true;
+    }
+    return *m_arena;
+}
+
+void ResultValue::SetName(wxString const &name)
+{
+    wxCharBuffer const utf8 = name.utf8_str();
+    SetName(utf8.data(), std::strlen(utf8.data()));
+}
+
+void ResultValue::SetName(char const *name, int length)
+{
+    m_name.data = length > 0 ? GetArena().CopyString(name, length) : NULL;
+    m_name.length = length;
+    m_name_string = NULL;
+}
+
+void ResultValue::SetSimpleValue(wxString const &value)
+{
+    assert(m_type == Simple);
+    wxCharBuffer const utf8 = value.utf8_str();
+    SetSimpleValue(utf8.data(), std::strlen(utf8.data()));
+}
+
+void ResultValue::SetSimpleValue(char const *value, int length)
+{
+    m_simple.data = length > 0 ? GetArena().CopyString(value, length) : NULL;
+    m_simple.length = length;
+    m_simple_string = NULL;
 }
 
 void ResultValue::SetType(Type type)
@@ -263,70 +584,202 @@ void ResultValue::SetType(Type type)
     m_type = type;
 }
 
+ResultValue* ResultValue::NewTupleValue()
+{
+    ResultArena &arena = GetArena();
+    return new (arena.Allocate(sizeof(ResultValue))) ResultValue(&arena);
+}
+
+void ResultValue::AttachTupleValue(ResultValue *value)
+{
+    assert(value && value->m_arena == m_arena);
+    if(m_count == m_capacity)
+    {
+        int capacity = m_capacity > 0 ? m_capacity * 2 : 4;
+        ResultValue **values = static_cast<ResultValue**>(GetArena().Allocate(capacity * sizeof(ResultValue*)));
+        if(m_count > 0)
+            std::memcpy(values, m_values, m_count * sizeof(ResultValue*));
+        m_values = values;
+        m_capacity = capacity;
+    }
+    m_values[m_count++] = value;
+    // the index will be rebuilt by the next lookup
+    m_index = NULL;
+}
+
 void ResultValue::SetTupleValue(ResultValue *value)
 {
     assert(value);
-    m_value.tuple.push_back(value);
+    ResultValue *copy = NewTupleValue();
+    copy->CopyFrom(*value);
+    delete value;
+    AttachTupleValue(copy);
+}
+
+ResultValue const* ResultValue::FindTupleValue(char const *name, int length) const
+{
+    if(m_count < c_tuple_index_threshold)
+    {
+        for(int ii = 0; ii < m_count; ++ii)
+        {
+            if(m_values[ii]->m_name.Equals(name, length))
+                return m_values[ii];
+        }
+        return NULL;
+    }
+
+    if(!m_index)
+        BuildIndex();
+    for(unsigned slot = HashName(name, length) & m_index_mask; m_index[slot] != 0; slot = (slot + 1) & m_index_mask)
+    {
+        ResultValue const *value = m_values[m_index[slot] - 1];
+        if(value->m_name.Equals(name, length))
+            return value;
+    }
+    return NULL;
+}
+
+void ResultValue::BuildIndex() const
+{
+    unsigned size = 1;
+    while(size < static_cast<unsigned>(m_count) * 2)
+        size <<= 1;
+
+    m_index = static_cast<int*>(m_arena->Allocate(size * sizeof(int)));
+    std::memset(m_index, 0, size * sizeof(int));
+    m_index_mask = size - 1;
+
+    // Linear probing keeps the values with the same name in insertion order, so the lookup finds the
+    // first one, like the linear search does.
+    for(int ii = 0; ii < m_count; ++ii)
+    {
+        String const &name = m_values[ii]->m_name;
+        unsigned slot = HashName(name.data, name.length) & m_index_mask;
+        while(m_index[slot] != 0)
+            slot = (slot + 1) & m_index_mask;
+        m_index[slot] = ii + 1;
+    }
 }
 
 ResultValue const * ResultValue::GetTupleValue(wxString const &key) const
+{
+    return GetTupleValue(static_cast<wxChar const*>(key.c_str()));
+}
+
+ResultValue const * ResultValue::GetTupleValue(wxChar const *key) const
 {
     assert(m_type == Tuple);
-    wxString::size_type pos = key.find(wxT('.'));
-    if(pos != wxString::npos)
+    ResultValue const *tuple = this;
+
+    // Every part of the dotted key is converted to UTF-8 once, then the names are compared by length
+    // and by bytes without converting them.
+    char name[c_key_buffer_size];
+    while(true)
     {
-        wxString const &subkey = key.substr(0, pos);
-        Container::const_iterator it = FindTupleValue(subkey);
-        if(it != m_value.tuple.end() && (*it)->GetType() == Tuple)
-            return (*it)->GetTupleValue(key.substr(pos + 1, key.length() - pos - 1));
+        int length = 0;
+        for(; key[length] != wxT('\0') && key[length] != wxT('.'); ++length)
+        {
+            if(length == c_key_buffer_size || static_cast<unsigned>(key[length]) >= 0x80)
+            {
+                // long or non-ascii keys are rare
+                wxCharBuffer const utf8 = wxString(key).utf8_str();
+                return tuple->FindDottedTupleValue(utf8.data(), std::strlen(utf8.data()));
+            }
+            name[length] = static_cast<char>(key[length]);
+        }
+
+        ResultValue const *value = tuple->FindTupleValue(name, length);
+        if(!value || key[length] == wxT('\0'))
+            return value;
+        if(value->GetType() != Tuple)
+            return NULL;
+        tuple = value;
+        key += length + 1;
     }
-    else
+}
+
+ResultValue const* ResultValue::FindDottedTupleValue(char const *name, int length) const
+{
+    ResultValue const *tuple = this;
+
+    // walk the dotted key without creating sub strings
+    while(true)
     {
-        Container::const_iterator it = FindTupleValue(key);
-        if(it != m_value.tuple.end())
-            return *it;
+        char const *dot = static_cast<char const*>(std::memchr(name, '.', length));
+        if(!dot)
+            return tuple->FindTupleValue(name, length);
+
+        int const pos = dot - name;
+        tuple = tuple->FindTupleValue(name, pos);
+        if(!tuple || tuple->GetType() != Tuple)
+            return NULL;
+        name += pos + 1;
+        length -= pos + 1;
     }
-    return NULL;
 }
 
-ResultValue const* ResultValue::GetTupleValueByIndex(int index) const
+bool ResultValue::ToLong(long &result) const
+{
+    assert(m_type == Simple);
+    char buffer[32];
+    if(m_simple.length >= static_cast<int>(sizeof(buffer)))
+        return GetSimpleValue().ToLong(&result, 10);
+    if(m_simple.length == 0)
+        return false;
+
+    std::memcpy(buffer, m_simple.data, m_simple.length);
+    buffer[m_simple.length] = '\0';
+    char *end;
+    errno = 0;
+    long const value = std::strtol(buffer, &end, 10);
+    if(errno != 0 || *end != '\0')
+        return false;
+    result = value;
+    return true;
+}
+
+wxString const & ResultValue::ConvertString(String const &str, wxString const *&converted) const
 {
-    Container::const_iterator it = m_value.tuple.begin();
+    // an empty string may have no arena
+    if(str.length == 0)
+        return c_empty_string;
+    converted = &m_arena->ConvertString(str.data, str.length);
+    return *converted;
+}
 
-    std::advance(it, index);
-    if(it != m_value.tuple.end())
-        return *it;
+ResultValue const* ResultValue::GetTupleValueByIndex(int index) const
+{
+    if(index >= 0 && index < m_count)
+        return m_values[index];
     else
         return NULL;
 }
 
 wxString ResultValue::MakeDebugString() const
 {
+    wxString const &name = GetName();
     switch(m_type)
     {
     case Simple:
-        if(m_name.empty())
-            return m_value.simple;
+        if(name.empty())
+            return m_simple.ToString();
         else
-            return m_name + _T("=") + m_value.simple;
+            return name + _T("=") + m_simple.ToString();
         break;
     case Tuple:
         {
             wxString s;
-            if(m_name.empty())
+            if(name.empty())
                 s = _T("{");
             else
-                s = m_name + _T("={");
+                s = name + _T("={");
 
-            bool first = true;
-            for(Container::const_iterator it = m_value.tuple.begin(); it != m_value.tuple.end(); ++it)
+            for(int ii = 0; ii < m_count; ++ii)
             {
-                if(first)
-                    first = false;
-                else
+                if(ii > 0)
                     s += _T(",");
 
-                s += (*it)->MakeDebugString();
+                s += m_values[ii]->MakeDebugString();
             }
 
             s += _T("}");
@@ -335,19 +788,16 @@ wxString ResultValue::MakeDebugString() const
     case Array:
         {
             wxString s;
-            if(m_name.empty())
+            if(name.empty())
                 s = _T("[");
             else
-                s = m_name + _T("=[");
-            bool first = true;
-            for(Container::const_iterator it = m_value.tuple.begin(); it != m_value.tuple.end(); ++it)
+                s = name + _T("=[");
+            for(int ii = 0; ii < m_count; ++ii)
             {
-                if(first)
-                    first = false;
-                else
+                if(ii > 0)
                     s += _T(",");
 
-                s += (*it)->MakeDebugString();
+                s += m_values[ii]->MakeDebugString();
             }
 
             s += _T("]");
@@ -360,75 +810,93 @@ wxString ResultValue::MakeDebugString() const
 
 bool ResultParser::Parse(wxString const &s)
 {
-    m_type = ParseType(s);
+    wxCharBuffer const utf8 = s.utf8_str();
+    return Parse(utf8.data(), std::strlen(utf8.data()));
+}
+
+bool ResultParser::Parse(char const *str, int length)
+{
+    m_type = length > 0 ? ParseType(str[0]) : TypeUnknown;
+    return ParseRecord(UTF8Input(str, length));
+}
+
+template<typename Input>
+bool ResultParser::ParseRecord(Input const &input)
+{
     m_class = ClassUnknown;
-    wxString str = s.substr(1, s.length() - 1);
-    if (str.length() == 0)
+    // skip the record type character
+    int const start = 1;
+    if (input.Length() <= start)
         return false;
 
-    wxString::size_type after_class_index = 0;
+    int after_class_index = start;
 
     if (m_type == NotifyAsyncOutput)
     {
-        after_class_index = str.find(wxT(','));
-        if (after_class_index == wxString::npos)
-        {
-            m_async_type = str;
+        while (after_class_index < input.Length() && input.At(after_class_index) != ',')
+            ++after_class_index;
+        m_async_type = input.Extract(start, after_class_index);
+        if (after_class_index == input.Length())
             return true;
-        }
-        else
-            m_async_type = str.substr(0, after_class_index);
     }
     else
     {
-        if(str.StartsWith(_T("done")))
+        if(input.StartsWith(start, "done"))
         {
             m_class = ClassDone;
-            after_class_index = 4;
+            after_class_index += 4;
         }
-        else if(str.StartsWith(_T("stopped")))
+        else if(input.StartsWith(start, "stopped"))
         {
             m_class = ClassStopped;
-            after_class_index = 7;
+            after_class_index += 7;
         }
-        else if(str.StartsWith(_T("running")))
+        else if(input.StartsWith(start, "running"))
         {
             m_class = ClassRunning;
-            after_class_index = 7;
+            after_class_index += 7;
         }
-        else if(str.StartsWith(_T("connected")))
+        else if(input.StartsWith(start, "connected"))
         {
             m_class = ClassConnected;
-            after_class_index = 9;
+            after_class_index += 9;
         }
-        else if(str.StartsWith(_T("error")))
+        else if(input.StartsWith(start, "error"))
         {
             m_class = ClassError;
-            after_class_index = 5;
+            after_class_index += 5;
         }
-        else if(str.StartsWith(_T("exit")))
+        else if(input.StartsWith(start, "exit"))
         {
             m_class = ClassExit;
-            after_class_index = 4;
+            after_class_index += 4;
         }
         else
             return false;
     }
 
-    if(str[after_class_index] == _T(','))
-        return ParseValue(str, m_value, after_class_index + 1);
-    else if(after_class_index != str.length())
-        return false;
-    else
+    if(after_class_index == input.Length())
         return true;
+    else if(input.At(after_class_index) == ',')
+    {
+        m_value.SetType(ResultValue::Tuple);
+        int pos = after_class_index + 1;
+        return ParseTuple(input, pos, m_value, false);
+    }
+    else
+        return false;
 }
 
 ResultParser::Type ResultParser::ParseType(wxString const &str)
 {
     if(str.empty())
         return TypeUnknown;
+    return ParseType(str[0]);
+}
 
-    switch(str[0])
+ResultParser::Type ResultParser::ParseType(wxChar first_char)
+{
+    switch(first_char)
     {
     case wxT('^'): // result record
         return ResultParser::Result;
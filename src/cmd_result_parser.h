@@ -2,23 +2,54 @@
 #define _DEBUGGER_MI_GDB_CMD_RESULT_PARSER_H_
 
 #include <algorithm>
-#include <vector>
+#include <cassert>
+#include <cstddef>
+#include <cstring>
 #include <wx/string.h>
 
 namespace dbg_mi
 {
 
-class ResultValue
+/// Bump allocator for the nodes and the strings of a parsed result tree.
+/// Nothing is freed individually, all the memory is released at once when the arena is destroyed.
+class ResultArena
 {
-    struct Equal
+    ResultArena(ResultArena const &);
+    ResultArena& operator =(ResultArena const &);
+public:
+    ResultArena();
+    ~ResultArena();
+
+    void* Allocate(size_t size);
+    char* CopyString(char const *str, int length);
+    /// Converts a UTF-8 string, the result lives until the arena is destroyed.
+    wxString const & ConvertString(char const *str, int length);
+
+    size_t GetAllocatedSize() const { return m_allocated; }
+    int GetChunkCount() const;
+private:
+    struct Chunk
     {
-        bool operator()(ResultValue *l, ResultValue *r) const
-        {
-            return *l == *r;
-        }
+        Chunk *next;
+        size_t size;
+        size_t used;
     };
+
+    // The converted strings are allocated in the chunks, they are destroyed with the arena.
+    struct ConvertedString
+    {
+        wxString value;
+        ConvertedString *next;
+    };
+
+    Chunk *m_chunks;
+    ConvertedString *m_strings;
+    size_t m_allocated;
+};
+
+class ResultValue
+{
 public:
-    typedef std::vector<ResultValue*> Container;
     enum Type
     {
         Simple = 0,
@@ -26,111 +57,109 @@ public:
         Tuple
     };
 public:
-    ResultValue() :
-        m_type(Simple)
-    {
-    }
-    ResultValue(wxChar const *name, Type type) :
-        m_name(name),
-        m_type(type)
-    {
-    }
+    ResultValue();
+    ResultValue(wxChar const *name, Type type);
+    ResultValue(ResultValue const &o);
+    ~ResultValue();
 
-    bool operator ==(ResultValue const &o) const
+    ResultValue& operator =(ResultValue o)
     {
-        if(m_name == o.m_name && m_type == o.m_type)
-        {
-            switch(m_type)
-            {
-            case Simple:
-                return m_value.simple == o.m_value.simple;
-            case Array:
-            case Tuple:
-                return std::equal(m_value.tuple.begin(), m_value.tuple.end(), o.m_value.tuple.begin(), Equal());
-                break;
-            }
-        }
-        return false;
+        Swap(o);
+        return *this;
     }
+
+    bool operator ==(ResultValue const &o) const;
     bool operator !=(ResultValue const &o) const { return !(*this == o); }
 
 public:
 
-    void SetName(wxString const &name) { m_name = name; }
-    void SetSimpleValue(wxString const &value) { assert(m_type == Simple); m_value.simple = value; }
-
+    void SetName(wxString const &name);
+    void SetSimpleValue(wxString const &value);
 
     Type GetType() const { return m_type; }
     void SetType(Type type);
-    wxString const & GetName() const { return m_name; }
+    /// The name is converted from UTF-8 on the first call, use NameEquals to compare it without converting it.
+    wxString const & GetName() const { return m_name_string ? *m_name_string : ConvertString(m_name, m_name_string); }
+    bool NameEquals(char const *name, int length) const { return m_name.Equals(name, length); }
+    bool NameEquals(char const *name) const { return m_name.Equals(name, std::strlen(name)); }
 
-    wxString const & GetSimpleValue() const { assert(m_type == Simple); return m_value.simple; }
+    /// Like GetName, use SimpleValueEquals or ToLong if a wxString isn't needed.
+    wxString const & GetSimpleValue() const
+    {
+        assert(m_type == Simple);
+        return m_simple_string ? *m_simple_string : ConvertString(m_simple, m_simple_string);
+    }
+    bool SimpleValueEquals(char const *value) const
+    {
+        assert(m_type == Simple);
+        return m_simple.Equals(value, std::strlen(value));
+    }
+    /// Parses the simple value as a decimal number like wxString::ToLong does.
+    bool ToLong(long &result) const;
 
-    int GetTupleSize() const { assert(m_type != Simple); return m_value.tuple.size(); }
+    int GetTupleSize() const { assert(m_type != Simple); return m_count; }
 
+    /// Adds a copy of value to the tuple and deletes value.
     void SetTupleValue(ResultValue *value);
     ResultValue const * GetTupleValue(wxString const &key) const;
+    ResultValue const * GetTupleValue(wxChar const *key) const;
     ResultValue const* GetTupleValueByIndex(int index) const;
     wxString MakeDebugString() const;
-private:
-    Container::iterator FindTupleValue(wxChar const *name)
-    {
-        for(Container::iterator it = m_value.tuple.begin(); it != m_value.tuple.end(); ++it)
-        {
-            if((*it)->GetName() == name)
-                return it;
-        }
-        return m_value.tuple.end();
-    }
-    Container::const_iterator FindTupleValue(wxChar const *name) const
-    {
-        for(Container::const_iterator it = m_value.tuple.begin(); it != m_value.tuple.end(); ++it)
-        {
-            if((*it)->GetName() == name)
-                return it;
-        }
-        return m_value.tuple.end();
-    }
-private:
-    wxString m_name;
-    Type     m_type;
 
-    struct Value
-    {
-        wxString simple;
-        Container tuple;
+    /// Allocates a new value in the arena of this tree; it is not part of the tuple until AttachTupleValue is called.
+    /// The value must not be deleted, it is released together with the arena.
+    ResultValue* NewTupleValue();
+    void AttachTupleValue(ResultValue *value);
 
-        friend void swap(Value &lhs, Value &rhs)
-        {
-            lhs.simple.swap(rhs.simple);
-            std::swap(lhs.tuple, rhs.tuple);
-        }
+    void SetName(char const *name, int length);
+    void SetSimpleValue(char const *value, int length);
+    ResultArena& GetArena();
+private:
+    /// UTF-8 string stored in the arena.
+    struct String
+    {
+        String() : data(NULL), length(0) {}
 
-        Value() {}
-        Value(Value const &v) :
-            simple(v.simple)
+        wxString ToString() const
         {
-            for(Container::const_iterator it = v.tuple.begin(); it != v.tuple.end(); ++it)
-            {
-                tuple.push_back(new ResultValue(**it));
-            }
+            return length > 0 ? wxString(data, wxConvUTF8, length) : wxString();
         }
-        ~Value()
+        bool Equals(char const *key, int key_length) const
         {
-            for(Container::const_iterator it = tuple.begin(); it != tuple.end(); ++it)
-                delete *it;
+            return length == key_length && (length == 0 || std::memcmp(data, key, length) == 0);
         }
+        bool Equals(String const &o) const { return Equals(o.data, o.length); }
 
-        Value const& operator =(Value v)
-        {
-            swap(*this, v);
-            return *this;
-        }
-
-    } m_value;
+        char const *data;
+        int length;
+    };
+private:
+    explicit ResultValue(ResultArena *arena);
+
+    void Swap(ResultValue &o);
+    void CopyFrom(ResultValue const &o);
+    wxString const & ConvertString(String const &str, wxString const *&converted) const;
+    ResultValue const* FindTupleValue(char const *name, int length) const;
+    ResultValue const* FindDottedTupleValue(char const *name, int length) const;
+    void BuildIndex() const;
+private:
+    String m_name;
+    String m_simple;
+    ResultValue **m_values;
+    int m_count, m_capacity;
+    // The strings converted by GetName and GetSimpleValue, they live in the arena.
+    mutable wxString const *m_name_string;
+    mutable wxString const *m_simple_string;
+    // Hash index of the names in m_values, built on the first lookup in big tuples.
+    mutable int *m_index;
+    mutable unsigned m_index_mask;
+    Type m_type;
+    ResultArena *m_arena;
+    bool m_owns_arena;
 };
 
 bool ParseValue(wxString const &str, ResultValue &results, int start = 0);
+bool ParseValue(char const *str, int length, ResultValue &results, int start = 0);
 
 class ResultParser
 {
@@ -165,7 +194,10 @@ public:
 
 public:
     bool Parse(wxString const &str);
+    /// Parses a record directly from the UTF-8 encoded output of gdb.
+    bool Parse(char const *str, int length);
     static Type ParseType(wxString const &str);
+    static Type ParseType(wxChar first_char);
 
     wxString MakeDebugString() const;
     Type GetResultType() const { return m_type; }
@@ -173,7 +205,11 @@ public:
 
     wxString GetAsyncNotifyType() const { return m_async_type; }
 
+    /// The whole tree is allocated in a single arena, which is freed when the parser is destroyed.
     ResultValue const & GetResultValue() const { return m_value; }
+private:
+    template<typename Input>
+    bool ParseRecord(Input const &input);
 private:
     Type m_type;
     Class m_class;
@@ -186,7 +222,7 @@ inline bool ToInt(ResultValue const &value, int &result_value)
     assert(value.GetType() == ResultValue::Simple);
 
     long l;
-    if(value.GetSimpleValue().ToLong(&l, 10))
+    if(value.ToLong(l))
     {
         result_value = l;
         return true;
@@ -195,7 +231,7 @@ inline bool ToInt(ResultValue const &value, int &result_value)
         return false;
 }
 
-inline bool Lookup(ResultValue const &value, wxString const &name, int &result_value)
+inline bool Lookup(ResultValue const &value, wxChar const *name, int &result_value)
 {
     assert(value.GetType() != ResultValue::Simple);
     ResultValue const *v = value.GetTupleValue(name);
@@ -205,25 +241,23 @@ inline bool Lookup(ResultValue const &value, wxString const &name, int &result_v
     return ToInt(*v, result_value);
 }
 
-inline bool Lookup(ResultValue const &value, wxString const &name, bool &result_value)
+inline bool Lookup(ResultValue const &value, wxChar const *name, bool &result_value)
 {
     assert(value.GetType() != ResultValue::Simple);
     ResultValue const *v = value.GetTupleValue(name);
     if(!v || v->GetType() != ResultValue::Simple)
         return false;
 
-    wxString const &s = v->GetSimpleValue();
-
-    if(s == wxT("true"))
+    if(v->SimpleValueEquals("true"))
         result_value = true;
-    else if(s == wxT("false"))
+    else if(v->SimpleValueEquals("false"))
         result_value = false;
     else
         return false;
     return true;
 }
 
-inline bool Lookup(ResultValue const &value, wxString const &name, wxString &result_value)
+inline bool Lookup(ResultValue const &value, wxChar const *name, wxString &result_value)
 {
     assert(value.GetType() != ResultValue::Simple);
     ResultValue const *v = value.GetTupleValue(name);
@@ -235,6 +269,21 @@ inline bool Lookup(ResultValue const &value, wxString const &name, wxString &res
     return true;
 }
 
+inline bool Lookup(ResultValue const &value, wxString const &name, int &result_value)
+{
+    return Lookup(value, static_cast<wxChar const*>(name.c_str()), result_value);
+}
+
+inline bool Lookup(ResultValue const &value, wxString const &name, bool &result_value)
+{
+    return Lookup(value, static_cast<wxChar const*>(name.c_str()), result_value);
+}
+
+inline bool Lookup(ResultValue const &value, wxString const &name, wxString &result_value)
+{
+    return Lookup(value, static_cast<wxChar const*>(name.c_str()), result_value);
+}
+
 
 } // namespace dbg_mi
 
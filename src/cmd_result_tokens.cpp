@@ -3,13 +3,16 @@
 namespace dbg_mi
 {
 
+namespace
+{
 
-bool GetNextToken(wxString const &str, int pos, Token &token)
+template<typename String>
+bool DoGetNextToken(String const &str, int length, int pos, Token &token)
 {
-    while(pos < static_cast<int>(str.length()) && (str[pos] == _T(' ') || str[pos] == _T('\t')))
+    while(pos < length && (str[pos] == _T(' ') || str[pos] == _T('\t')))
         ++pos;
 
-    if(pos >= static_cast<int>(str.length()))
+    if(pos >= length)
         return false;
 
     token.start = -1;
@@ -46,7 +49,7 @@ bool GetNextToken(wxString const &str, int pos, Token &token)
     ++pos;
 
     bool escape_next = false;
-    while(pos < static_cast<int>(str.length()))
+    while(pos < length)
     {
         if((str[pos] == _T(' ') || str[pos] == _T('\t') || str[pos] == _T(',')
             || str[pos] == _T('=') || str[pos] == _T('{') || str[pos] == _T('}')
@@ -85,6 +88,19 @@ bool GetNextToken(wxString const &str, int pos, Token &token)
     }
 }
 
+} // anonymous namespace
+
+bool GetNextToken(wxString const &str, int pos, Token &token)
+{
+    return DoGetNextToken(str, static_cast<int>(str.length()), pos, token);
+}
+
+bool GetNextToken(char const *str, int length, int pos, Token &token)
+{
+    // All the separators are ASCII and the bytes of a multi-byte UTF-8 sequence are always >= 0x80,
+    // so scanning the raw bytes can't split a character.
+    return DoGetNextToken(str, length, pos, token);
+}
 
 } // namespace dbg_mi
 
@@ -40,6 +40,11 @@ struct Token
         assert(end <= static_cast<int>(s.length()));
         return s.substr(start, end - start);
     }
+    wxString ExtractString(char const *s) const
+    {
+        return wxString(s + start, wxConvUTF8, end - start);
+    }
+    int Length() const { return end - start; }
 
     int start, end;
     Type type;
@@ -47,6 +52,10 @@ struct Token
 
 bool GetNextToken(wxString const &str, int pos, Token &token);
 
+// Works directly on the UTF-8 bytes received from gdb. The returned token is only a view
+// (offset and length) in the buffer, so nothing is allocated or copied while tokenizing.
+bool GetNextToken(char const *str, int length, int pos, Token &token);
+
 } // namespace dbg_mi
 
 #endif // _DEBUGGER_GDB_MI_CMD_RESULT_TOKENIZE_H_
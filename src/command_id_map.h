@@ -0,0 +1,136 @@
+#ifndef _DEBUGGER_GDB_MI_COMMAND_ID_MAP_H_
+#define _DEBUGGER_GDB_MI_COMMAND_ID_MAP_H_
+
+#include <cassert>
+#include <vector>
+
+#include "cmd_queue.h"
+
+namespace dbg_mi
+{
+
+/// Hash map from CommandID to T with open addressing and linear probing.
+/// All entries are stored in one array, so there is no allocation per entry as in tr1::unordered_map.
+/// The iterators and the references to the values are invalidated by insert and erase.
+template<typename T>
+class CommandIDMap
+{
+public:
+    struct Entry
+    {
+        Entry() : used(false) {}
+
+        CommandID first;
+        T second;
+        bool used;
+    };
+    typedef Entry* iterator;
+    typedef Entry const* const_iterator;
+public:
+    CommandIDMap() : m_size(0) {}
+
+    iterator end() { return NULL; }
+    const_iterator end() const { return NULL; }
+
+    bool empty() const { return m_size == 0; }
+    int size() const { return m_size; }
+
+    iterator find(CommandID const &id)
+    {
+        if(m_entries.empty())
+            return end();
+        size_t const mask = m_entries.size() - 1;
+        for(size_t index = GetHome(id); m_entries[index].used; index = (index + 1) & mask)
+        {
+            if(m_entries[index].first == id)
+                return &m_entries[index];
+        }
+        return end();
+    }
+
+    const_iterator find(CommandID const &id) const
+    {
+        return const_cast<CommandIDMap*>(this)->find(id);
+    }
+
+    T& operator[](CommandID const &id)
+    {
+        iterator it = find(id);
+        if(it != end())
+            return it->second;
+
+        // the load factor is kept below one half, so the probe sequences stay short
+        if(2 * (m_size + 1) > static_cast<int>(m_entries.size()))
+            Grow();
+        Entry &entry = Insert(id);
+        ++m_size;
+        return entry.second;
+    }
+
+    void erase(iterator it)
+    {
+        assert(it && it->used);
+        size_t const mask = m_entries.size() - 1;
+        size_t hole = it - &m_entries[0];
+
+        // shift back the following entries of the probe sequence, so no tombstones are needed
+        for(size_t next = (hole + 1) & mask; m_entries[next].used; next = (next + 1) & mask)
+        {
+            size_t const home = GetHome(m_entries[next].first);
+            if(((next - home) & mask) >= ((next - hole) & mask))
+            {
+                m_entries[hole] = m_entries[next];
+                hole = next;
+            }
+        }
+        m_entries[hole] = Entry();
+        --m_size;
+    }
+
+    void clear()
+    {
+        m_entries.clear();
+        m_size = 0;
+    }
+private:
+    size_t GetHome(CommandID const &id) const
+    {
+        // Fibonacci hashing spreads the consecutive commands of an action over the whole table
+        uint64_t const hash = static_cast<uint64_t>(id.GetFullID()) * 0x9E3779B97F4A7C15ULL;
+        return static_cast<size_t>(hash >> 32) & (m_entries.size() - 1);
+    }
+
+    Entry& Insert(CommandID const &id)
+    {
+        size_t const mask = m_entries.size() - 1;
+        size_t index = GetHome(id);
+        while(m_entries[index].used)
+            index = (index + 1) & mask;
+
+        Entry &entry = m_entries[index];
+        entry.first = id;
+        entry.used = true;
+        return entry;
+    }
+
+    void Grow()
+    {
+        Entries old;
+        old.swap(m_entries);
+        m_entries.resize(old.empty() ? 16 : old.size() * 2);
+        for(typename Entries::iterator it = old.begin(); it != old.end(); ++it)
+        {
+            if(it->used)
+                Insert(it->first).second = it->second;
+        }
+    }
+private:
+    typedef std::vector<Entry> Entries;
+
+    Entries m_entries;
+    int m_size;
+};
+
+} // namespace dbg_mi
+
+#endif // _DEBUGGER_GDB_MI_COMMAND_ID_MAP_H_
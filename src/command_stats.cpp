@@ -0,0 +1,95 @@
+#include "command_stats.h"
+
+#include <algorithm>
+
+namespace dbg_mi
+{
+
+LatencyHistogram::LatencyHistogram() :
+    m_count(0),
+    m_total(0),
+    m_max(0)
+{
+    std::fill(m_buckets, m_buckets + BucketCount, 0);
+}
+
+void LatencyHistogram::Add(int64_t latency)
+{
+    latency = std::max<int64_t>(latency, 0);
+    ++m_buckets[GetBucket(latency)];
+    ++m_count;
+    m_total += latency;
+    m_max = std::max(m_max, latency);
+}
+
+int64_t LatencyHistogram::GetPercentile(int percent) const
+{
+    if(m_count == 0)
+        return 0;
+
+    // the rank of the sample at the percentile, rounded up
+    int64_t const rank = std::max<int64_t>((int64_t(m_count) * percent + 99) / 100, 1);
+    int64_t seen = 0;
+    for(int bucket = 0; bucket < BucketCount; ++bucket)
+    {
+        seen += m_buckets[bucket];
+        // the last bucket has no upper bound
+        if(seen >= rank)
+            return bucket == BucketCount - 1 ? m_max : std::min(GetBucketEnd(bucket), m_max);
+    }
+    return m_max;
+}
+
+int LatencyHistogram::GetBucket(int64_t latency)
+{
+    int const sub_buckets = 1 << SubBucketBits;
+    if(latency < sub_buckets)
+        return static_cast<int>(latency);
+
+    int exponent = 0;
+    while((latency >> exponent) > 1)
+        ++exponent;
+
+    int const sub = static_cast<int>(latency >> (exponent - SubBucketBits)) & (sub_buckets - 1);
+    int const bucket = ((exponent - SubBucketBits + 1) << SubBucketBits) + sub;
+    return std::min(bucket, static_cast<int>(BucketCount) - 1);
+}
+
+int64_t LatencyHistogram::GetBucketEnd(int bucket)
+{
+    int const sub_buckets = 1 << SubBucketBits;
+    if(bucket < sub_buckets)
+        return bucket;
+
+    int const shift = (bucket >> SubBucketBits) - 1;
+    int64_t const start = int64_t(sub_buckets + (bucket & (sub_buckets - 1))) << shift;
+    return start + (int64_t(1) << shift) - 1;
+}
+
+wxChar const *CommandStats::c_async_class = wxT("(async output)");
+wxChar const *CommandStats::c_processing_class = wxT("(plugin processing)");
+
+wxString CommandStats::GetCommandClass(wxString const &command)
+{
+    size_t const pos = command.find_first_of(wxT(" \t"));
+    return pos == wxString::npos ? command : command.substr(0, pos);
+}
+
+wxString CommandStats::MakeReport() const
+{
+    wxString report = wxString::Format(wxT("%-28s %8s %10s %10s %10s %12s %12s\n"),
+                                       wxT("command"), wxT("count"), wxT("p50 (ms)"), wxT("p99 (ms)"),
+                                       wxT("max (ms)"), wxT("bytes out"), wxT("bytes in"));
+    for(Classes::const_iterator it = m_classes.begin(); it != m_classes.end(); ++it)
+    {
+        LatencyHistogram const &latency = it->second.latency;
+        report += wxString::Format(wxT("%-28s %8d %10.3f %10.3f %10.3f %12ld %12ld\n"),
+                                   it->first.c_str(), latency.GetCount(),
+                                   latency.GetPercentile(50) / 1000.0, latency.GetPercentile(99) / 1000.0,
+                                   latency.GetMax() / 1000.0,
+                                   static_cast<long>(it->second.bytes_out), static_cast<long>(it->second.bytes_in));
+    }
+    return report;
+}
+
+} // namespace dbg_mi
@@ -0,0 +1,70 @@
+#ifndef _DEBUGGER_GDB_MI_COMMAND_STATS_H_
+#define _DEBUGGER_GDB_MI_COMMAND_STATS_H_
+
+#include <map>
+#include <stdint.h>
+
+#include <wx/string.h>
+
+namespace dbg_mi
+{
+
+/// Histogram of latencies in microseconds. The buckets grow exponentially with four sub-buckets per power of two,
+/// so the percentiles are accurate to 25% with a fixed amount of memory.
+class LatencyHistogram
+{
+public:
+    LatencyHistogram();
+
+    void Add(int64_t latency);
+
+    int GetCount() const { return m_count; }
+    int64_t GetTotal() const { return m_total; }
+    int64_t GetMax() const { return m_max; }
+    /// Returns the upper bound of the bucket which contains the given percentile, it is never above the maximum.
+    int64_t GetPercentile(int percent) const;
+private:
+    enum { SubBucketBits = 2, BucketCount = 40 << SubBucketBits };
+
+    static int GetBucket(int64_t latency);
+    static int64_t GetBucketEnd(int bucket);
+private:
+    int m_buckets[BucketCount];
+    int m_count;
+    int64_t m_total, m_max;
+};
+
+/// Statistics of the commands sent to gdb grouped by their class, which is the name of the MI command.
+class CommandStats
+{
+public:
+    struct Class
+    {
+        Class() : bytes_out(0), bytes_in(0) {}
+
+        LatencyHistogram latency;
+        int64_t bytes_out, bytes_in;
+    };
+    typedef std::map<wxString, Class> Classes;
+public:
+    /// The records which don't belong to a command in flight are counted in this class.
+    static wxChar const *c_async_class;
+    /// The time the plugin needs to handle the records is counted in this class.
+    static wxChar const *c_processing_class;
+
+    static wxString GetCommandClass(wxString const &command);
+
+    /// The reference stays valid until Clear is called.
+    Class& Get(wxString const &command_class) { return m_classes[command_class]; }
+    Classes const& GetClasses() const { return m_classes; }
+    void Clear() { m_classes.clear(); }
+
+    /// Formats a table with a row for every class.
+    wxString MakeReport() const;
+private:
+    Classes m_classes;
+};
+
+} // namespace dbg_mi
+
+#endif // _DEBUGGER_GDB_MI_COMMAND_STATS_H_
@@ -8,6 +8,7 @@
 #include <wx/intl.h>
 #include <wx/stattext.h>
 #include <wx/textctrl.h>
+#include <wx/spinctrl.h>
 //*)
 
 #include <wx/filedlg.h>
@@ -22,6 +23,10 @@ const long ConfigurationPanel::ID_BUTTON_BROWSE = wxNewId();
 const long ConfigurationPanel::ID_TEXTCTRL_INIT_COMMANDS = wxNewId();
 const long ConfigurationPanel::ID_CHECKBOX_PRETTY_PRINTERS = wxNewId();
 const long ConfigurationPanel::ID_CHECKBOX_CPP_EXCEPTIONS = wxNewId();
+const long ConfigurationPanel::ID_CHECKBOX_NON_STOP = wxNewId();
+const long ConfigurationPanel::ID_CHECKBOX_TARGET_CONDITIONS = wxNewId();
+const long ConfigurationPanel::ID_CHECKBOX_PREFETCH_TOOLTIPS = wxNewId();
+const long ConfigurationPanel::ID_SPINCTRL_MAX_IN_FLIGHT = wxNewId();
 //*)
 
 BEGIN_EVENT_TABLE(ConfigurationPanel,wxPanel)
@@ -34,6 +39,8 @@ ConfigurationPanel::ConfigurationPanel(wxWindow* parent)
 	//(*Initialize(ConfigurationPanel)
 	wxBoxSizer* execSizer;
 	wxBoxSizer* option_sizer;
+	wxBoxSizer* in_flight_sizer;
+	wxStaticText* in_flight_label;
 	wxStaticText* init_cmd_warning;
 	wxBoxSizer* main_sizer;
 	wxStaticText* exec_path_label;
@@ -64,6 +71,22 @@ ConfigurationPanel::ConfigurationPanel(wxWindow* parent)
 	m_check_cpp_excepetions = new wxCheckBox(this, ID_CHECKBOX_CPP_EXCEPTIONS, _("Catch C++ exceptions"), wxDefaultPosition, wxDefaultSize, 0, wxDefaultValidator, _T("ID_CHECKBOX_CPP_EXCEPTIONS"));
 	m_check_cpp_excepetions->SetValue(false);
 	option_sizer->Add(m_check_cpp_excepetions, 0, wxBOTTOM|wxLEFT|wxRIGHT|wxALIGN_LEFT|wxALIGN_BOTTOM, 5);
+	m_check_non_stop = new wxCheckBox(this, ID_CHECKBOX_NON_STOP, _("Non-stop mode: only the thread, which has stopped, is halted (gdb >= 7.0 is required)"), wxDefaultPosition, wxDefaultSize, 0, wxDefaultValidator, _T("ID_CHECKBOX_NON_STOP"));
+	m_check_non_stop->SetValue(false);
+	option_sizer->Add(m_check_non_stop, 0, wxBOTTOM|wxLEFT|wxRIGHT|wxALIGN_LEFT|wxALIGN_BOTTOM, 5);
+	m_check_target_conditions = new wxCheckBox(this, ID_CHECKBOX_TARGET_CONDITIONS, _("Evaluate the breakpoint conditions on the target, if it supports it (gdb >= 7.5 is required)"), wxDefaultPosition, wxDefaultSize, 0, wxDefaultValidator, _T("ID_CHECKBOX_TARGET_CONDITIONS"));
+	m_check_target_conditions->SetValue(false);
+	option_sizer->Add(m_check_target_conditions, 0, wxBOTTOM|wxLEFT|wxRIGHT|wxALIGN_LEFT|wxALIGN_BOTTOM, 5);
+	m_check_prefetch_tooltips = new wxCheckBox(this, ID_CHECKBOX_PREFETCH_TOOLTIPS, _("Prefetch the values of the identifiers around the current line for the value tooltips"), wxDefaultPosition, wxDefaultSize, 0, wxDefaultValidator, _T("ID_CHECKBOX_PREFETCH_TOOLTIPS"));
+	m_check_prefetch_tooltips->SetValue(false);
+	option_sizer->Add(m_check_prefetch_tooltips, 0, wxBOTTOM|wxLEFT|wxRIGHT|wxALIGN_LEFT|wxALIGN_BOTTOM, 5);
+	in_flight_sizer = new wxBoxSizer(wxHORIZONTAL);
+	in_flight_label = new wxStaticText(this, wxID_ANY, _("Maximum number of commands waiting for their results (0 means no limit):"), wxDefaultPosition, wxDefaultSize, 0, _T("wxID_ANY"));
+	in_flight_sizer->Add(in_flight_label, 0, wxLEFT|wxRIGHT|wxALIGN_LEFT|wxALIGN_CENTER_VERTICAL, 5);
+	m_spin_max_in_flight = new wxSpinCtrl(this, ID_SPINCTRL_MAX_IN_FLIGHT, _T("64"), wxDefaultPosition, wxDefaultSize, 0, 0, 1000, 64, _T("ID_SPINCTRL_MAX_IN_FLIGHT"));
+	m_spin_max_in_flight->SetValue(_T("64"));
+	in_flight_sizer->Add(m_spin_max_in_flight, 0, wxLEFT|wxRIGHT|wxALIGN_LEFT|wxALIGN_CENTER_VERTICAL, 5);
+	option_sizer->Add(in_flight_sizer, 0, wxBOTTOM|wxLEFT|wxRIGHT|wxALIGN_LEFT|wxALIGN_BOTTOM, 5);
 	main_sizer->Add(option_sizer, 1, wxALL|wxEXPAND|wxALIGN_LEFT|wxALIGN_CENTER_VERTICAL, 0);
 	SetSizer(main_sizer);
 	main_sizer->Fit(this);
@@ -134,6 +157,10 @@ wxPanel* Configuration::MakePanel(wxWindow *parent)
     panel->m_initial_commands->SetValue(GetInitialCommandsString());
     panel->m_check_pretty_printers->SetValue(GetFlag(Configuration::PrettyPrinters));
     panel->m_check_cpp_excepetions->SetValue(GetFlag(Configuration::CatchCppExceptions));
+    panel->m_check_non_stop->SetValue(GetFlag(Configuration::NonStop));
+    panel->m_check_target_conditions->SetValue(GetFlag(Configuration::TargetConditions));
+    panel->m_check_prefetch_tooltips->SetValue(GetFlag(Configuration::PrefetchTooltips));
+    panel->m_spin_max_in_flight->SetValue(GetMaxCommandsInFlight());
     return panel;
 }
 
@@ -145,6 +172,10 @@ bool Configuration::SaveChanges(wxPanel *p)
     m_config.Write(wxT("init_commands"), panel->m_initial_commands->GetValue());
     m_config.Write(wxT("pretty_printer"), panel->m_check_pretty_printers->GetValue());
     m_config.Write(wxT("catch_exceptions"), panel->m_check_cpp_excepetions->GetValue());
+    m_config.Write(wxT("non_stop"), panel->m_check_non_stop->GetValue());
+    m_config.Write(wxT("target_conditions"), panel->m_check_target_conditions->GetValue());
+    m_config.Write(wxT("prefetch_tooltips"), panel->m_check_prefetch_tooltips->GetValue());
+    m_config.Write(wxT("max_commands_in_flight"), panel->m_spin_max_in_flight->GetValue());
     return true;
 }
 
@@ -184,9 +215,20 @@ bool Configuration::GetFlag(Flags flag)
         return m_config.ReadBool(wxT("pretty_printer"), true);
     case CatchCppExceptions:
         return m_config.ReadBool(wxT("catch_exceptions"), false);
+    case NonStop:
+        return m_config.ReadBool(wxT("non_stop"), false);
+    case TargetConditions:
+        return m_config.ReadBool(wxT("target_conditions"), false);
+    case PrefetchTooltips:
+        return m_config.ReadBool(wxT("prefetch_tooltips"), false);
     default:
         return false;
     }
 }
 
+int Configuration::GetMaxCommandsInFlight()
+{
+    return m_config.ReadInt(wxT("max_commands_in_flight"), 64);
+}
+
 } // namespace dbg_mi
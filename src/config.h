@@ -12,6 +12,7 @@ class wxButton;
 class wxBoxSizer;
 class wxStaticText;
 class wxCheckBox;
+class wxSpinCtrl;
 //*)
 
 namespace dbg_mi
@@ -33,6 +34,10 @@ private:
     wxTextCtrl* m_exec_path;
     wxCheckBox* m_check_cpp_excepetions;
     wxCheckBox* m_check_pretty_printers;
+    wxCheckBox* m_check_non_stop;
+    wxCheckBox* m_check_target_conditions;
+    wxCheckBox* m_check_prefetch_tooltips;
+    wxSpinCtrl* m_spin_max_in_flight;
     //*)
 
     //(*Identifiers(ConfigurationPanel)
@@ -41,6 +46,10 @@ private:
     static const long ID_TEXTCTRL_INIT_COMMANDS;
     static const long ID_CHECKBOX_PRETTY_PRINTERS;
     static const long ID_CHECKBOX_CPP_EXCEPTIONS;
+    static const long ID_CHECKBOX_NON_STOP;
+    static const long ID_CHECKBOX_TARGET_CONDITIONS;
+    static const long ID_CHECKBOX_PREFETCH_TOOLTIPS;
+    static const long ID_SPINCTRL_MAX_IN_FLIGHT;
     //*)
 
     //(*Handlers(ConfigurationPanel)
@@ -72,11 +81,19 @@ public:
     enum Flags
     {
         PrettyPrinters = 0,
-        CatchCppExceptions
+        CatchCppExceptions,
+        NonStop,
+        TargetConditions,
+        PrefetchTooltips
     };
 
     bool GetFlag(Flags flag);
 
+    /// Maximum number of commands sent to gdb without a result, 0 means no limit.
+    /// The default leaves room to pipeline the refreshes after a stop, but a command of the user doesn't wait
+    /// behind hundreds of them.
+    int GetMaxCommandsInFlight();
+
 
 };
 
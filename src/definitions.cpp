@@ -1,9 +1,12 @@
 #include "definitions.h"
 
+#include <algorithm>
+
 namespace dbg_mi
 {
 void Breakpoint::SetEnabled(bool flag)
 {
+    m_enabled = flag;
 }
 
 wxString Breakpoint::GetLocation() const
@@ -28,7 +31,16 @@ wxString Breakpoint::GetType() const
 
 wxString Breakpoint::GetInfo() const
 {
-    return wxEmptyString;
+    wxString info;
+    if (HasCondition())
+        info += _("condition: ") + m_condition + wxT("; ");
+    if (HasIgnoreCount())
+        info += wxString::Format(_("ignore count: %d; "), m_ignore_count);
+    if (m_hit_count > 0)
+        info += wxString::Format(_("hits: %d; "), m_hit_count);
+    if (!info.empty())
+        info.RemoveLast(2);
+    return info;
 }
 
 bool Breakpoint::IsEnabled() const
@@ -46,43 +58,600 @@ bool Breakpoint::IsTemporary() const
     return m_temporary;
 }
 
-cb::shared_ptr<Watch> FindWatch(wxString const &expression, WatchesContainer &watches)
+namespace
+{
+/// The editor and gdb may spell the same file differently, the separators and on windows the case may differ.
+wxString NormalizeBreakpointPath(wxString const &filename)
+{
+    wxString result(filename);
+    result.Replace(wxT("\\"), wxT("/"));
+#ifdef __WXMSW__
+    result.MakeLower();
+#endif
+    return result;
+}
+
+struct BreakpointMatchProject
+{
+    BreakpointMatchProject(cbProject *project) : project(project) {}
+    bool operator()(cb::shared_ptr<Breakpoint> const &breakpoint) const
+    {
+        return breakpoint->GetProject() == project;
+    }
+    cbProject *project;
+};
+} // anonymous namespace
+
+void BreakpointsContainer::clear()
+{
+    m_breakpoints.clear();
+    m_by_location.clear();
+    m_by_number.clear();
+}
+
+BreakpointsContainer::Location BreakpointsContainer::MakeLocation(cbBreakpoint const &breakpoint)
+{
+    return Location(NormalizeBreakpointPath(breakpoint.GetLocation()), breakpoint.GetLine());
+}
+
+BreakpointsContainer::LocationIndex::iterator BreakpointsContainer::FindLocation(cbBreakpoint const *breakpoint)
+{
+    std::pair<LocationIndex::iterator, LocationIndex::iterator> range;
+    range = m_by_location.equal_range(MakeLocation(*breakpoint));
+    for (LocationIndex::iterator it = range.first; it != range.second; ++it)
+    {
+        if (it->second.get() == breakpoint)
+            return it;
+    }
+    return m_by_location.end();
+}
+
+void BreakpointsContainer::RemoveFromIndex(Breakpoint const &breakpoint)
+{
+    LocationIndex::iterator it = FindLocation(&breakpoint);
+    if (it != m_by_location.end())
+        m_by_location.erase(it);
+
+    NumberIndex::iterator number = m_by_number.find(breakpoint.GetIndex());
+    if (number != m_by_number.end() && number->second.get() == &breakpoint)
+        m_by_number.erase(number);
+}
+
+void BreakpointsContainer::Add(Pointer const &breakpoint)
+{
+    m_breakpoints.push_back(breakpoint);
+    m_by_location.insert(LocationIndex::value_type(MakeLocation(*breakpoint), breakpoint));
+    if (breakpoint->GetIndex() != -1)
+        m_by_number[breakpoint->GetIndex()] = breakpoint;
+}
+
+BreakpointsContainer::Pointer BreakpointsContainer::Remove(cbBreakpoint const *breakpoint)
+{
+    if (!breakpoint)
+        return Pointer();
+    LocationIndex::iterator location = FindLocation(breakpoint);
+    if (location == m_by_location.end())
+        return Pointer();
+    RemoveFromIndex(*location->second);
+
+    // the order of the list is shown in the breakpoints dialog, so it is kept
+    std::vector<Pointer>::iterator it = m_breakpoints.begin();
+    while (it->get() != breakpoint)
+        ++it;
+    Pointer result = *it;
+    m_breakpoints.erase(it);
+    return result;
+}
+
+bool BreakpointsContainer::RemoveProject(cbProject *project)
+{
+    std::vector<Pointer>::iterator it = std::remove_if(m_breakpoints.begin(), m_breakpoints.end(),
+                                                       BreakpointMatchProject(project));
+    if (it == m_breakpoints.end())
+        return false;
+    for (std::vector<Pointer>::iterator removed = it; removed != m_breakpoints.end(); ++removed)
+        RemoveFromIndex(**removed);
+    m_breakpoints.erase(it, m_breakpoints.end());
+    return true;
+}
+
+void BreakpointsContainer::ShiftLine(int index, int lines_to_shift)
+{
+    Pointer const &breakpoint = m_breakpoints[index];
+    LocationIndex::iterator it = FindLocation(breakpoint.get());
+    if (it != m_by_location.end())
+        m_by_location.erase(it);
+    breakpoint->ShiftLine(lines_to_shift);
+    m_by_location.insert(LocationIndex::value_type(MakeLocation(*breakpoint), breakpoint));
+}
+
+void BreakpointsContainer::SetNumber(Breakpoint &breakpoint, int number)
+{
+    NumberIndex::iterator old = m_by_number.find(breakpoint.GetIndex());
+    if (old != m_by_number.end() && old->second.get() == &breakpoint)
+        m_by_number.erase(old);
+
+    breakpoint.SetIndex(number);
+    if (number == -1)
+        return;
+    // a breakpoint deleted while its insert was running isn't indexed again
+    LocationIndex::iterator it = FindLocation(&breakpoint);
+    if (it != m_by_location.end())
+        m_by_number[number] = it->second;
+}
+
+void BreakpointsContainer::ResetNumbers()
+{
+    for (std::vector<Pointer>::iterator it = m_breakpoints.begin(); it != m_breakpoints.end(); ++it)
+        (*it)->SetIndex(-1);
+    m_by_number.clear();
+}
+
+bool BreakpointsContainer::UpdateHitCount(int number, int count)
+{
+    NumberIndex::iterator it = m_by_number.find(number);
+    if (it == m_by_number.end() || it->second->GetHitCount() == count)
+        return false;
+    it->second->SetHitCount(count);
+    return true;
+}
+
+BreakpointsContainer::Pointer BreakpointsContainer::Find(wxString const &filename, int line) const
+{
+    LocationIndex::const_iterator it = m_by_location.find(Location(NormalizeBreakpointPath(filename), line));
+    return it != m_by_location.end() ? it->second : Pointer();
+}
+
+BreakpointsContainer::Pointer BreakpointsContainer::FindByNumber(int number) const
+{
+    NumberIndex::const_iterator it = m_by_number.find(number);
+    return it != m_by_number.end() ? it->second : Pointer();
+}
+
+void FetchedRanges::Add(int start, int end)
 {
-    for(WatchesContainer::iterator it = watches.begin(); it != watches.end(); ++it)
+    if(start >= end)
+        return;
+
+    Ranges::iterator first = m_ranges.begin();
+    while(first != m_ranges.end() && first->second < start)
+        ++first;
+
+    // Merge all the ranges which overlap or touch the new one.
+    Ranges::iterator last = first;
+    while(last != m_ranges.end() && last->first <= end)
+    {
+        start = std::min(start, last->first);
+        end = std::max(end, last->second);
+        ++last;
+    }
+
+    first = m_ranges.erase(first, last);
+    m_ranges.insert(first, std::make_pair(start, end));
+}
+
+bool FetchedRanges::Contains(int start, int end) const
+{
+    for(Ranges::const_iterator it = m_ranges.begin(); it != m_ranges.end(); ++it)
+    {
+        if(it->first > start)
+            return false;
+        else if(it->second >= end)
+            return true;
+    }
+    return false;
+}
+
+int FetchedRanges::GetFirstMissing() const
+{
+    if(m_ranges.empty() || m_ranges.front().first > 0)
+        return 0;
+    return m_ranges.front().second;
+}
+
+void WatchesContainer::push_back(cb::shared_ptr<Watch> const &watch)
+{
+    m_watches.push_back(watch);
+    Register(watch);
+}
+
+WatchesContainer::iterator WatchesContainer::erase(iterator it)
+{
+    Unregister(*it);
+    return m_watches.erase(it);
+}
+
+void WatchesContainer::clear()
+{
+    m_watches.clear();
+    m_index.clear();
+}
+
+cb::shared_ptr<Watch> WatchesContainer::Find(wxString const &id) const
+{
+    Index::iterator it = m_index.find(id);
+    if(it == m_index.end())
+        return cb::shared_ptr<Watch>();
+
+    // The watch could have been destroyed or reset without being unregistered.
+    cb::shared_ptr<Watch> watch = it->second.lock();
+    if(!watch || watch->GetID() != id)
+    {
+        m_index.erase(it);
+        return cb::shared_ptr<Watch>();
+    }
+    return watch;
+}
+
+void WatchesContainer::Register(cb::shared_ptr<Watch> const &watch)
+{
+    if(!watch->GetID().empty())
+        m_index[watch->GetID()] = watch;
+
+    for(int child = 0; child < watch->GetChildCount(); ++child)
+        Register(cb::static_pointer_cast<Watch>(watch->GetChild(child)));
+}
+
+void WatchesContainer::Unregister(cb::shared_ptr<Watch> const &watch)
+{
+    Index::iterator it = m_index.find(watch->GetID());
+    if(it != m_index.end() && it->second.lock() == watch)
+        m_index.erase(it);
+
+    UnregisterChildren(*watch);
+}
+
+void WatchesContainer::UnregisterChildren(cbWatch &watch)
+{
+    for(int child = 0; child < watch.GetChildCount(); ++child)
+        Unregister(cb::static_pointer_cast<Watch>(watch.GetChild(child)));
+}
+
+void WatchesContainer::RemoveChildren(cb::shared_ptr<Watch> const &watch)
+{
+    UnregisterChildren(*watch);
+    watch->RemoveChildren();
+    watch->GetFetchedRanges().Clear();
+}
+
+void WatchesContainer::RemoveMarkedChildren(cb::shared_ptr<Watch> const &watch)
+{
+    for(int child = 0; child < watch->GetChildCount(); ++child)
     {
-        if(expression.StartsWith(it->get()->GetID()))
+        cb::shared_ptr<Watch> w = cb::static_pointer_cast<Watch>(watch->GetChild(child));
+        if(w->IsRemoved())
+            Unregister(w);
+    }
+    watch->RemoveMarkedChildren();
+}
+
+namespace
+{
+struct RowIDLess
+{
+    template<typename Row>
+    bool operator()(Row const &row, int id) const { return row.id < id; }
+};
+} // anonymous namespace
+
+void ThreadsContainer::clear()
+{
+    m_rows.clear();
+    m_current = -1;
+    m_synchronized = false;
+}
+
+ThreadsContainer::Rows::iterator ThreadsContainer::FindRow(int id)
+{
+    Rows::iterator it = std::lower_bound(m_rows.begin(), m_rows.end(), id, RowIDLess());
+    return it != m_rows.end() && it->id == id ? it : m_rows.end();
+}
+
+ThreadsContainer::Rows::const_iterator ThreadsContainer::FindRow(int id) const
+{
+    Rows::const_iterator it = std::lower_bound(m_rows.begin(), m_rows.end(), id, RowIDLess());
+    return it != m_rows.end() && it->id == id ? it : m_rows.end();
+}
+
+void ThreadsContainer::UpdateThread(Row &row)
+{
+    wxString info = row.target_id;
+    if(row.running)
+        info += wxT(" (running)");
+    else if(!row.stale && !row.frame.empty())
+        info += wxT(" ") + row.frame;
+    row.thread = cb::shared_ptr<cbThread>(new cbThread(row.id == m_current, row.id, info));
+}
+
+void ThreadsContainer::Add(int id)
+{
+    // The new threads have the highest numbers, so they are appended in most cases.
+    Rows::iterator it = std::lower_bound(m_rows.begin(), m_rows.end(), id, RowIDLess());
+    if(it != m_rows.end() && it->id == id)
+        return;
+
+    Row row;
+    row.id = id;
+    row.stale = true;
+    row.running = false;
+    UpdateThread(row);
+    m_rows.insert(it, row);
+}
+
+void ThreadsContainer::Remove(int id)
+{
+    Rows::iterator it = FindRow(id);
+    if(it != m_rows.end())
+        m_rows.erase(it);
+}
+
+void ThreadsContainer::Synchronize(std::vector<int> const &ids)
+{
+    std::vector<int> sorted(ids);
+    std::sort(sorted.begin(), sorted.end());
+
+    Rows rows;
+    rows.reserve(sorted.size());
+    for(std::vector<int>::const_iterator id = sorted.begin(); id != sorted.end(); ++id)
+    {
+        Rows::iterator it = FindRow(*id);
+        if(it != m_rows.end())
+            rows.push_back(*it);
+        else
+        {
+            Row row;
+            row.id = *id;
+            row.stale = true;
+            row.running = false;
+            UpdateThread(row);
+            rows.push_back(row);
+        }
+    }
+    m_rows.swap(rows);
+    m_synchronized = true;
+}
+
+void ThreadsContainer::SetCurrent(int id)
+{
+    if(id == m_current)
+        return;
+    int const old = m_current;
+    m_current = id;
+
+    Rows::iterator it = FindRow(old);
+    if(it != m_rows.end())
+        UpdateThread(*it);
+    it = FindRow(id);
+    if(it != m_rows.end())
+        UpdateThread(*it);
+}
+
+bool ThreadsContainer::SetInfo(int id, wxString const &target_id, wxString const &frame)
+{
+    Rows::iterator it = FindRow(id);
+    if(it == m_rows.end())
+        return false;
+    it->target_id = target_id;
+    it->frame = frame;
+    it->stale = false;
+    UpdateThread(*it);
+    return true;
+}
+
+void ThreadsContainer::MarkFramesAsStale()
+{
+    for(Rows::iterator it = m_rows.begin(); it != m_rows.end(); ++it)
+    {
+        if(!it->stale)
+        {
+            it->stale = true;
+            UpdateThread(*it);
+        }
+    }
+}
+
+bool ThreadsContainer::IsStale(int id) const
+{
+    Rows::const_iterator it = FindRow(id);
+    return it == m_rows.end() || it->stale;
+}
+
+void ThreadsContainer::SetRunning(int id, bool running)
+{
+    if(id < 0)
+    {
+        for(Rows::iterator it = m_rows.begin(); it != m_rows.end(); ++it)
         {
-            if(expression.length() == it->get()->GetID().length())
-                return *it;
-            else
+            if(it->running != running)
             {
-                cb::shared_ptr<Watch> curr = *it;
-                while(curr)
-                {
-                    cb::shared_ptr<Watch> temp = curr;
-                    curr = cb::shared_ptr<Watch>();
-
-                    for(int child = 0; child < temp->GetChildCount(); ++child)
-                    {
-                        cb::shared_ptr<Watch> p = cb::static_pointer_cast<Watch>(temp->GetChild(child));
-                        if(expression.StartsWith(p->GetID()))
-                        {
-                            if(expression.length() == p->GetID().length())
-                                return p;
-                            else
-                            {
-                                curr = p;
-                                break;
-                            }
-                        }
-                    }
-                }
-                if(curr)
-                    return curr;
+                it->running = running;
+                UpdateThread(*it);
             }
         }
+        return;
+    }
+
+    Rows::iterator it = FindRow(id);
+    if(it != m_rows.end() && it->running != running)
+    {
+        it->running = running;
+        UpdateThread(*it);
+    }
+}
+
+bool ThreadsContainer::IsRunning(int id) const
+{
+    Rows::const_iterator it = FindRow(id);
+    return it != m_rows.end() && it->running;
+}
+
+void ThreadsContainer::GetStaleThreads(int start, int end, std::vector<int> &ids) const
+{
+    end = std::min(end, static_cast<int>(m_rows.size()));
+    for(int row = std::max(start, 0); row < end; ++row)
+    {
+        if(m_rows[row].stale && !m_rows[row].running)
+            ids.push_back(m_rows[row].id);
+    }
+}
+
+cb::shared_ptr<cbStackFrame> MakeMoreFramesPlaceholder(int number, int count)
+{
+    cb::shared_ptr<cbStackFrame> frame(new cbStackFrame);
+    frame->SetNumber(number);
+    frame->SetAddress(0);
+    frame->SetSymbol(wxT("..."));
+    if(count >= 0)
+        frame->SetFile(wxString::Format(_("%d more frames"), count), wxEmptyString);
+    else
+        frame->SetFile(_("more frames"), wxEmptyString);
+    frame->MakeValid(false);
+    return frame;
+}
+
+bool IsMoreFramesPlaceholder(cbStackFrame const &frame)
+{
+    return !frame.IsValid() && frame.GetAddress() == 0 && frame.GetSymbol() == wxT("...");
+}
+
+void BacktraceCache::Store(BacktraceContainer const &frames, int depth, int thread_id)
+{
+    m_frames = frames;
+    m_depth = depth;
+    m_thread_id = thread_id;
+    m_stops = 0;
+}
+
+bool BacktraceCache::Matches(int level, unsigned long address, int depth, int thread_id) const
+{
+    if(thread_id != m_thread_id || level < 0)
+        return false;
+    int const index = level + m_depth - depth;
+    return index >= 0 && index < static_cast<int>(m_frames.size()) && m_frames[index]->GetAddress() == address;
+}
+
+int BacktraceCache::CopyFrames(BacktraceContainer &frames, int start, int end, int depth) const
+{
+    int level = start;
+    for(; level < end; ++level)
+    {
+        int const index = level + m_depth - depth;
+        if(index < 0 || index >= static_cast<int>(m_frames.size()))
+            break;
+        cb::shared_ptr<cbStackFrame> frame(new cbStackFrame(*m_frames[index]));
+        frame->SetNumber(level);
+        frames.push_back(frame);
+    }
+    return level - start;
+}
+
+void BacktraceCache::OnStop(bool stepping)
+{
+    if(!stepping || m_stops > 0)
+        Clear();
+    else
+        ++m_stops;
+    m_stepping = stepping;
+}
+
+void BacktraceCache::Clear()
+{
+    m_frames.clear();
+    m_depth = 0;
+    m_thread_id = -1;
+    m_stops = 0;
+    m_stepping = false;
+}
+
+cb::shared_ptr<Watch> FindWatch(wxString const &expression, WatchesContainer &watches)
+{
+    return watches.Find(expression);
+}
+
+cb::shared_ptr<Watch> TooltipCache::Acquire(wxString const &expression, int thread_id, int frame)
+{
+    for(Entries::iterator it = m_entries.begin(); it != m_entries.end(); ++it)
+    {
+        if(!it->in_use && it->generation == m_generation && it->thread_id == thread_id && it->frame == frame
+           && it->expression == expression && !it->watch->GetID().empty())
+        {
+            Entry entry = *it;
+            entry.in_use = true;
+            m_entries.erase(it);
+            m_entries.push_back(entry);
+            return entry.watch;
+        }
     }
     return cb::shared_ptr<Watch>();
 }
 
+void TooltipCache::Add(cb::shared_ptr<Watch> const &watch, wxString const &expression, int thread_id, int frame)
+{
+    Entry entry;
+    entry.watch = watch;
+    entry.expression = expression;
+    entry.thread_id = thread_id;
+    entry.frame = frame;
+    entry.generation = m_generation;
+    entry.in_use = true;
+    m_entries.push_back(entry);
+}
+
+void TooltipCache::AddPrefetched(cb::shared_ptr<Watch> const &watch, wxString const &expression, int thread_id,
+                                 int frame)
+{
+    Add(watch, expression, thread_id, frame);
+    m_entries.back().in_use = false;
+}
+
+bool TooltipCache::Release(cb::shared_ptr<Watch> const &watch, Watches &evicted)
+{
+    Entries::iterator it = m_entries.begin();
+    while(it != m_entries.end() && it->watch != watch)
+        ++it;
+    if(it == m_entries.end())
+        return false;
+
+    Entry entry = *it;
+    m_entries.erase(it);
+    // the varobj hasn't been created or it belongs to a stop, which is gone
+    if(entry.watch->GetID().empty() || entry.generation != m_generation)
+        return false;
+
+    entry.in_use = false;
+    m_entries.push_back(entry);
+
+    int dismissed = 0;
+    for(Entries::const_iterator it_entry = m_entries.begin(); it_entry != m_entries.end(); ++it_entry)
+    {
+        if(!it_entry->in_use)
+            ++dismissed;
+    }
+    Entries::iterator oldest = m_entries.begin();
+    while(dismissed > c_tooltip_cache_size)
+    {
+        if(!oldest->in_use)
+        {
+            evicted.push_back(oldest->watch);
+            oldest = m_entries.erase(oldest);
+            --dismissed;
+        }
+        else
+            ++oldest;
+    }
+    return true;
+}
+
+void TooltipCache::NewGeneration(Watches &stale)
+{
+    ++m_generation;
+    // the tooltips, which are still shown, are deleted when they are dismissed
+    for(Entries::const_iterator it = m_entries.begin(); it != m_entries.end(); ++it)
+    {
+        if(!it->in_use)
+            stale.push_back(it->watch);
+    }
+    m_entries.clear();
+}
+
 } // namespace dbg_mi
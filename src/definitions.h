@@ -2,8 +2,13 @@
 #define _DEBUGGER_GDB_MI_DEFINITIONS_H_
 
 #include <deque>
+#include <map>
+#include <utility>
+#include <vector>
 #include <tr1/memory>
+#include <tr1/unordered_map>
 
+#include <wx/hashmap.h>
 #include <wx/sizer.h>
 
 #include <debuggermanager.h>
@@ -19,6 +24,8 @@ public:
         m_project(nullptr),
         m_index(-1),
         m_line(-1),
+        m_ignore_count(0),
+        m_hit_count(0),
         m_enabled(true),
         m_temporary(false)
     {
@@ -29,6 +36,8 @@ public:
         m_project(project),
         m_index(-1),
         m_line(line),
+        m_ignore_count(0),
+        m_hit_count(0),
         m_enabled(true),
         m_temporary(false)
     {
@@ -46,10 +55,17 @@ public:
 
     int GetIndex() const { return m_index; }
     const wxString& GetCondition() const { return m_condition; }
-    int GetIgnoreCount() const { return 0; }
+    int GetIgnoreCount() const { return m_ignore_count; }
 
-    bool HasCondition() const { return false; }
-    bool HasIgnoreCount() const { return false; }
+    bool HasCondition() const { return !m_condition.empty(); }
+    bool HasIgnoreCount() const { return m_ignore_count > 0; }
+
+    void SetCondition(wxString const &condition) { m_condition = condition; }
+    void SetIgnoreCount(int count) { m_ignore_count = count; }
+
+    /// The number of times gdb has reached the breakpoint, including the hits skipped by the ignore count.
+    int GetHitCount() const { return m_hit_count; }
+    void SetHitCount(int count) { m_hit_count = count; }
 
     void SetIndex(int index) { m_index = index; }
     void ShiftLine(int linesToShift) { m_line += linesToShift; }
@@ -61,13 +77,165 @@ private:
     cbProject *m_project;
     int m_index;
     int m_line;
+    int m_ignore_count;
+    int m_hit_count;
     bool m_enabled;
     bool m_temporary;
 };
 
+/// The breakpoints in the order they were added, indexed by their normalized location and by their number in gdb,
+/// so the lookups done for the editor and for the notifications of gdb don't scan the whole list.
+class BreakpointsContainer
+{
+public:
+    typedef cb::shared_ptr<Breakpoint> Pointer;
+public:
+    bool empty() const { return m_breakpoints.empty(); }
+    size_t size() const { return m_breakpoints.size(); }
+    Pointer const& operator[](size_t index) const { return m_breakpoints[index]; }
+    Pointer const& back() const { return m_breakpoints.back(); }
+    void clear();
+
+    void Add(Pointer const &breakpoint);
+    /// Returns the removed breakpoint or an empty pointer, if the breakpoint isn't in the container.
+    Pointer Remove(cbBreakpoint const *breakpoint);
+    /// Removes the breakpoints of the project; returns false if there are none.
+    bool RemoveProject(cbProject *project);
+
+    /// Moves the breakpoint at the index by the number of lines.
+    void ShiftLine(int index, int lines_to_shift);
+    /// Sets the number of the breakpoint in gdb, -1 means it isn't set in gdb.
+    void SetNumber(Breakpoint &breakpoint, int number);
+    /// Called when gdb exits, none of the breakpoints is set anymore.
+    void ResetNumbers();
+    /// Sets the hit count reported by gdb for the breakpoint number; returns false if nothing has changed.
+    bool UpdateHitCount(int number, int count);
+
+    Pointer Find(wxString const &filename, int line) const;
+    Pointer FindByNumber(int number) const;
+private:
+    typedef std::pair<wxString, int> Location;
+    typedef std::multimap<Location, Pointer> LocationIndex;
+    typedef std::map<int, Pointer> NumberIndex;
+
+    static Location MakeLocation(cbBreakpoint const &breakpoint);
+    LocationIndex::iterator FindLocation(cbBreakpoint const *breakpoint);
+    void RemoveFromIndex(Breakpoint const &breakpoint);
+private:
+    std::vector<Pointer> m_breakpoints;
+    LocationIndex m_by_location;
+    NumberIndex m_by_number;
+};
+
 
 typedef std::deque<cb::shared_ptr<cbStackFrame> > BacktraceContainer;
-typedef std::deque<cb::shared_ptr<cbThread> > ThreadsContainer;
+
+/// Creates the frame shown at the end of a backtrace, which isn't loaded completely.
+/// Selecting it loads the next page of frames. The count is -1 if the depth of the stack isn't known.
+cb::shared_ptr<cbStackFrame> MakeMoreFramesPlaceholder(int number, int count);
+bool IsMoreFramesPlaceholder(cbStackFrame const &frame);
+
+/// The frames of the last backtrace of a thread, keyed by their address and their distance from the outermost frame.
+/// While the debuggee steps inside a function the frames below it keep their distance from the outermost frame, so
+/// when the deepest of the freshly fetched top frames matches, the frames below it are taken from the cache.
+class BacktraceCache
+{
+public:
+    BacktraceCache() : m_depth(0), m_thread_id(-1), m_stops(0), m_stepping(false) {}
+
+    /// Stores the frames at the levels [0, frames.size()) of a stack with depth frames.
+    void Store(BacktraceContainer const &frames, int depth, int thread_id);
+    /// True if the cache has a frame with this address at the same distance from the outermost frame.
+    bool Matches(int level, unsigned long address, int depth, int thread_id) const;
+    /// Appends copies of the cached frames at the levels [start, end) renumbered for the new depth.
+    /// Returns the number of frames appended, it stops at the first level, which isn't cached.
+    int CopyFrames(BacktraceContainer &frames, int start, int end, int depth) const;
+
+    /// Called when the debuggee stops. The frames survive a single step only if they are stored again before the
+    /// next stop, because the outer frames may have returned and been called again in the meantime.
+    void OnStop(bool stepping);
+    void Clear();
+    bool IsEmpty() const { return m_frames.empty(); }
+    /// True if the last stop was a step, only then the cached frames can be reused by the next backtrace.
+    bool IsStepping() const { return m_stepping; }
+private:
+    BacktraceContainer m_frames;
+    int m_depth;
+    int m_thread_id;
+    int m_stops;
+    bool m_stepping;
+};
+
+/// The threads of the debuggee sorted by their number. The list is kept up to date by the =thread-created and
+/// =thread-exited notifications, so after a stop only the frames of the threads, which are shown, are fetched.
+class ThreadsContainer
+{
+public:
+    ThreadsContainer() : m_current(-1), m_synchronized(false) {}
+
+    bool empty() const { return m_rows.empty(); }
+    size_t size() const { return m_rows.size(); }
+    cb::shared_ptr<cbThread> const& operator[](size_t index) const { return m_rows[index].thread; }
+    void clear();
+
+    /// Adds a thread, its info is empty until its frame is fetched.
+    void Add(int id);
+    void Remove(int id);
+    /// Replaces the threads with the list of thread ids reported by gdb.
+    void Synchronize(std::vector<int> const &ids);
+    /// False until the first list of thread ids has been received, the notifications may have been missed before.
+    bool IsSynchronized() const { return m_synchronized; }
+
+    void SetCurrent(int id);
+    int GetCurrent() const { return m_current; }
+
+    /// Sets the target id and the frame of the thread; returns false for an unknown thread.
+    bool SetInfo(int id, wxString const &target_id, wxString const &frame);
+    /// Called when the debuggee stops, the frames of all threads have to be fetched again.
+    void MarkFramesAsStale();
+    bool IsStale(int id) const;
+    /// Marks the thread as running or stopped, id -1 means all threads. In non-stop mode each thread runs and stops
+    /// on its own, in all-stop mode gdb reports all threads at once.
+    void SetRunning(int id, bool running);
+    bool IsRunning(int id) const;
+    /// Appends the numbers of the threads in the rows [start, end), whose frames are stale; the running threads have
+    /// no frames, so they are skipped.
+    void GetStaleThreads(int start, int end, std::vector<int> &ids) const;
+private:
+    struct Row
+    {
+        int id;
+        wxString target_id, frame;
+        bool stale;
+        bool running;
+        cb::shared_ptr<cbThread> thread;
+    };
+    typedef std::vector<Row> Rows;
+
+    Rows::iterator FindRow(int id);
+    Rows::const_iterator FindRow(int id) const;
+    void UpdateThread(Row &row);
+private:
+    Rows m_rows;
+    int m_current;
+    bool m_synchronized;
+};
+
+/// Sorted list of the disjoint ranges [start, end) of the children, which have been fetched from gdb.
+class FetchedRanges
+{
+public:
+    void Add(int start, int end);
+    bool Contains(int start, int end) const;
+    /// Returns the index of the first child after the range starting at 0.
+    int GetFirstMissing() const;
+    int GetEnd() const { return m_ranges.empty() ? 0 : m_ranges.back().second; }
+    bool IsEmpty() const { return m_ranges.empty(); }
+    void Clear() { m_ranges.clear(); }
+private:
+    typedef std::vector<std::pair<int, int> > Ranges;
+    Ranges m_ranges;
+};
 
 class Watch : public cbWatch
 {
@@ -76,7 +244,9 @@ public:
         m_symbol(symbol),
         m_has_been_expanded(false),
         m_for_tooltip(for_tooltip),
-        m_delete_on_collapse(delete_on_collapse)
+        m_delete_on_collapse(delete_on_collapse),
+        m_more_placeholder(false),
+        m_frozen(false)
     {
     }
 
@@ -84,6 +254,8 @@ public:
     {
         m_id = m_type = m_value = wxEmptyString;
         m_has_been_expanded = false;
+        m_frozen = false;
+        m_fetched.Clear();
 
         RemoveChildren();
         Expand(false);
@@ -97,6 +269,17 @@ public:
     bool ForTooltip() const { return m_for_tooltip; }
     void SetDeleteOnCollapse(bool delete_on_collapse) { m_delete_on_collapse = delete_on_collapse; }
     bool DeleteOnCollapse() const { return m_delete_on_collapse; }
+
+    /// The children of the varobj, which have already been listed; children outside of them are fetched
+    /// on demand, when the "more" placeholder at the end of the children is expanded.
+    FetchedRanges& GetFetchedRanges() { return m_fetched; }
+    FetchedRanges const& GetFetchedRanges() const { return m_fetched; }
+    bool IsMorePlaceholder() const { return m_more_placeholder; }
+    void SetMorePlaceholder(bool placeholder) { m_more_placeholder = placeholder; }
+
+    /// The varobj is frozen with -var-set-frozen, so -var-update * skips it and its children.
+    bool IsFrozen() const { return m_frozen; }
+    void SetFrozen(bool frozen) { m_frozen = frozen; }
 public:
     virtual void GetSymbol(wxString &symbol) const { symbol = m_symbol; }
     virtual void GetValue(wxString &value) const { value = m_value; }
@@ -119,15 +302,105 @@ private:
     wxString m_type;
 
     mutable wxString m_debug_string;
+    FetchedRanges m_fetched;
     bool m_has_been_expanded;
     bool m_for_tooltip;
     bool m_delete_on_collapse;
+    bool m_more_placeholder;
+    bool m_frozen;
 };
 
-typedef std::vector<cb::shared_ptr<Watch> > WatchesContainer;
+/// The top level watches and an index of all the watches in their trees by the name of their varobj.
+/// Children added to a tree must be registered and the children removed from it must be removed with
+/// RemoveChildren/RemoveMarkedChildren, so the index stays in sync.
+class WatchesContainer
+{
+    typedef std::vector<cb::shared_ptr<Watch> > Container;
+public:
+    typedef Container::iterator iterator;
+    typedef Container::const_iterator const_iterator;
+public:
+    iterator begin() { return m_watches.begin(); }
+    iterator end() { return m_watches.end(); }
+    const_iterator begin() const { return m_watches.begin(); }
+    const_iterator end() const { return m_watches.end(); }
+    bool empty() const { return m_watches.empty(); }
+    size_t size() const { return m_watches.size(); }
+    cb::shared_ptr<Watch>& operator[](size_t index) { return m_watches[index]; }
+
+    void push_back(cb::shared_ptr<Watch> const &watch);
+    iterator erase(iterator it);
+    void clear();
+
+    /// Returns the watch of the varobj with the given name, or an empty pointer.
+    cb::shared_ptr<Watch> Find(wxString const &id) const;
+
+    /// Adds the watch and its children to the index; needed when the ID is set after the watch is in a tree.
+    void Register(cb::shared_ptr<Watch> const &watch);
+    /// Removes the watch and its children from the index.
+    void Unregister(cb::shared_ptr<Watch> const &watch);
+
+    /// Removes the children of the watch from the tree and from the index.
+    void RemoveChildren(cb::shared_ptr<Watch> const &watch);
+    /// Removes the children marked as removed from the tree and from the index.
+    void RemoveMarkedChildren(cb::shared_ptr<Watch> const &watch);
+private:
+    void UnregisterChildren(cbWatch &watch);
+private:
+    typedef std::tr1::unordered_map<wxString, std::tr1::weak_ptr<Watch>, wxStringHash> Index;
+
+    Container m_watches;
+    mutable Index m_index;
+};
 
 cb::shared_ptr<Watch> FindWatch(wxString const &expression, WatchesContainer &watches);
 
+/// The maximum number of the dismissed tooltips, whose varobjs are kept for reuse.
+const int c_tooltip_cache_size = 16;
+/// The number of the source lines, starting with the current one, whose identifiers are prefetched.
+const int c_prefetch_lines = 3;
+/// The maximum number of the identifiers prefetched on one stop; less than the cache, so hovers aren't evicted.
+const int c_prefetch_budget = 10;
+
+/// The watches of the value tooltips, keyed by the expression, the thread, the frame and the stop generation.
+/// The varobj of a dismissed tooltip is kept while the debuggee hasn't moved, so hovering the same expression
+/// again shows the value and the children listed before without any commands.
+class TooltipCache
+{
+public:
+    typedef std::vector<cb::shared_ptr<Watch> > Watches;
+public:
+    TooltipCache() : m_generation(0) {}
+
+    /// Returns the dismissed watch of the expression, or an empty pointer. The watch is in use until it is released.
+    cb::shared_ptr<Watch> Acquire(wxString const &expression, int thread_id, int frame);
+    /// Adds the watch of a new tooltip, which is in use.
+    void Add(cb::shared_ptr<Watch> const &watch, wxString const &expression, int thread_id, int frame);
+    /// Adds a watch, which is created before the expression is hovered. It can be acquired once it has a varobj.
+    void AddPrefetched(cb::shared_ptr<Watch> const &watch, wxString const &expression, int thread_id, int frame);
+    /// Called when the tooltip is dismissed. Returns false if the watch isn't kept and must be deleted.
+    /// The watches, which are evicted to make room for it, are added to evicted.
+    bool Release(cb::shared_ptr<Watch> const &watch, Watches &evicted);
+    /// Called when the debuggee stops; the dismissed watches of the old stop are added to stale.
+    void NewGeneration(Watches &stale);
+
+    int GetGeneration() const { return m_generation; }
+    size_t size() const { return m_entries.size(); }
+private:
+    struct Entry
+    {
+        cb::shared_ptr<Watch> watch;
+        wxString expression;
+        int thread_id, frame, generation;
+        bool in_use;
+    };
+    typedef std::vector<Entry> Entries;
+
+    // the entries are ordered by the time they were last used, the oldest dismissed one is evicted first
+    Entries m_entries;
+    int m_generation;
+};
+
 // Custom window to display output of DebuggerInfoCmd
 class TextInfoWindow : public wxScrollingDialog
 {
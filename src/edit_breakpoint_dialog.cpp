@@ -0,0 +1,81 @@
+#include "edit_breakpoint_dialog.h"
+
+//(*InternalHeaders(EditBreakpointDialog)
+#include <wx/sizer.h>
+#include <wx/button.h>
+#include <wx/string.h>
+#include <wx/intl.h>
+#include <wx/stattext.h>
+#include <wx/textctrl.h>
+#include <wx/spinctrl.h>
+//*)
+
+namespace dbg_mi
+{
+
+//(*IdInit(EditBreakpointDialog)
+const long EditBreakpointDialog::ID_TEXTCTRL_CONDITION = wxNewId();
+const long EditBreakpointDialog::ID_SPINCTRL_IGNORE_COUNT = wxNewId();
+//*)
+
+BEGIN_EVENT_TABLE(EditBreakpointDialog,wxDialog)
+	//(*EventTable(EditBreakpointDialog)
+	//*)
+END_EVENT_TABLE()
+
+EditBreakpointDialog::EditBreakpointDialog(wxWindow* parent, wxString const &condition, int ignore_count)
+{
+	//(*Initialize(EditBreakpointDialog)
+	wxBoxSizer* main_sizer;
+	wxStaticText* condition_label;
+	wxBoxSizer* ignore_count_sizer;
+	wxStaticText* ignore_count_label;
+	wxStdDialogButtonSizer* buttons;
+
+	Create(parent, wxID_ANY, _("Edit breakpoint"), wxDefaultPosition, wxDefaultSize, wxDEFAULT_DIALOG_STYLE, _T("wxID_ANY"));
+	main_sizer = new wxBoxSizer(wxVERTICAL);
+	condition_label = new wxStaticText(this, wxID_ANY, _("Stop only if the condition is true (empty for no condition):"), wxDefaultPosition, wxDefaultSize, 0, _T("wxID_ANY"));
+	main_sizer->Add(condition_label, 0, wxTOP|wxLEFT|wxRIGHT|wxEXPAND|wxALIGN_LEFT|wxALIGN_BOTTOM, 5);
+	m_condition = new wxTextCtrl(this, ID_TEXTCTRL_CONDITION, wxEmptyString, wxDefaultPosition, wxSize(300,-1), 0, wxDefaultValidator, _T("ID_TEXTCTRL_CONDITION"));
+	main_sizer->Add(m_condition, 0, wxALL|wxEXPAND|wxALIGN_LEFT|wxALIGN_CENTER_VERTICAL, 5);
+	ignore_count_sizer = new wxBoxSizer(wxHORIZONTAL);
+	ignore_count_label = new wxStaticText(this, wxID_ANY, _("Number of hits to skip before stopping:"), wxDefaultPosition, wxDefaultSize, 0, _T("wxID_ANY"));
+	ignore_count_sizer->Add(ignore_count_label, 1, wxALL|wxALIGN_LEFT|wxALIGN_CENTER_VERTICAL, 5);
+	m_ignore_count = new wxSpinCtrl(this, ID_SPINCTRL_IGNORE_COUNT, _T("0"), wxDefaultPosition, wxDefaultSize, 0, 0, 1000000000, 0, _T("ID_SPINCTRL_IGNORE_COUNT"));
+	m_ignore_count->SetValue(_T("0"));
+	ignore_count_sizer->Add(m_ignore_count, 0, wxALL|wxALIGN_RIGHT|wxALIGN_CENTER_VERTICAL, 5);
+	main_sizer->Add(ignore_count_sizer, 0, wxEXPAND|wxALIGN_LEFT|wxALIGN_CENTER_VERTICAL, 0);
+	buttons = new wxStdDialogButtonSizer();
+	buttons->AddButton(new wxButton(this, wxID_OK, wxEmptyString));
+	buttons->AddButton(new wxButton(this, wxID_CANCEL, wxEmptyString));
+	buttons->Realize();
+	main_sizer->Add(buttons, 0, wxALL|wxEXPAND|wxALIGN_CENTER_HORIZONTAL|wxALIGN_CENTER_VERTICAL, 5);
+	SetSizer(main_sizer);
+	main_sizer->Fit(this);
+	main_sizer->SetSizeHints(this);
+	//*)
+
+    m_condition->SetValue(condition);
+    m_ignore_count->SetValue(ignore_count);
+    m_condition->SetFocus();
+}
+
+EditBreakpointDialog::~EditBreakpointDialog()
+{
+	//(*Destroy(EditBreakpointDialog)
+	//*)
+}
+
+wxString EditBreakpointDialog::GetCondition() const
+{
+    wxString condition = m_condition->GetValue();
+    condition.Trim().Trim(false);
+    return condition;
+}
+
+int EditBreakpointDialog::GetIgnoreCount() const
+{
+    return m_ignore_count->GetValue();
+}
+
+} // namespace dbg_mi
@@ -0,0 +1,47 @@
+#ifndef _DEBUGGER_GDB_MI_EDIT_BREAKPOINT_DIALOG_H_
+#define _DEBUGGER_GDB_MI_EDIT_BREAKPOINT_DIALOG_H_
+
+//(*Headers(EditBreakpointDialog)
+#include <wx/dialog.h>
+class wxTextCtrl;
+class wxSpinCtrl;
+class wxStaticText;
+class wxBoxSizer;
+class wxStdDialogButtonSizer;
+//*)
+
+namespace dbg_mi
+{
+
+/// Edits the condition and the ignore count of a breakpoint at once.
+class EditBreakpointDialog: public wxDialog
+{
+public:
+
+    EditBreakpointDialog(wxWindow* parent, wxString const &condition, int ignore_count);
+    virtual ~EditBreakpointDialog();
+
+    /// The condition without the leading and trailing spaces, empty for no condition.
+    wxString GetCondition() const;
+    int GetIgnoreCount() const;
+private:
+
+    //(*Declarations(EditBreakpointDialog)
+    wxTextCtrl* m_condition;
+    wxSpinCtrl* m_ignore_count;
+    //*)
+
+    //(*Identifiers(EditBreakpointDialog)
+    static const long ID_TEXTCTRL_CONDITION;
+    static const long ID_SPINCTRL_IGNORE_COUNT;
+    //*)
+
+    //(*Handlers(EditBreakpointDialog)
+    //*)
+
+    DECLARE_EVENT_TABLE()
+};
+
+} // namespace dbg_mi
+
+#endif // _DEBUGGER_GDB_MI_EDIT_BREAKPOINT_DIALOG_H_
@@ -5,6 +5,7 @@ namespace dbg_mi
 {
 // Could have been DEFINE_EVENT_TYPE( MyFooCommandEvent )
 const wxEventType NotificationEventType = wxNewEventType();
+const wxEventType OutputReadyEventType = wxNewEventType();
 
 
 } // namespace dbg_mi
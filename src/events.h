@@ -7,6 +7,8 @@ namespace dbg_mi
 {
 
 extern const wxEventType NotificationEventType;
+/// Posted by OutputReader when there is new output of gdb.
+extern const wxEventType OutputReadyEventType;
 
 class ResultParser;
 // TODO (obfusacted#): remove this class, not needed
@@ -50,5 +52,10 @@ typedef void (wxEvtHandler::*NotificationEventFunction)(NotificationEvent &);
                               (wxObjectEventFunction)(wxEventFunction)(dbg_mi::NotificationEventFunction)&fn,     \
                               (wxObject*) NULL),
 
+#define EVT_DBGMI_OUTPUT_READY(id, fn)                                          \
+    DECLARE_EVENT_TABLE_ENTRY(dbg_mi::OutputReadyEventType, id, wxID_ANY,               \
+                              (wxObjectEventFunction)(wxEventFunction)wxStaticCastEvent(wxCommandEventFunction, &fn), \
+                              (wxObject*) NULL),
+
 
 #endif // _DEBUGGER_GDB_MI_EVENTS_H_
@@ -52,7 +52,7 @@ bool Frame::ParseFrame(ResultValue const &frame_value)
     m_filename = filename->GetSimpleValue();
     m_full_filename = full_filename->GetSimpleValue();
     long long_line;
-    if(!line->GetSimpleValue().ToLong(&long_line))
+    if(!line->ToLong(long_line))
         return false;
 
     m_line = long_line;
@@ -83,7 +83,7 @@ int FrameArguments::GetCount() const
 bool FrameArguments::GetFrame(int index, wxString &args) const
 {
     ResultValue const *frame = m_stack_args->GetTupleValueByIndex(index);
-    if(!frame || frame->GetName() != wxT("frame"))
+    if(!frame || !frame->NameEquals("frame"))
         return false;
 
     return ParseFrame(*frame, args);
@@ -134,6 +134,8 @@ StoppedReason StoppedReason::Parse(ResultValue const &value)
         return Exited;
     else if(str == wxT("exited-normally"))
         return ExitedNormally;
+    else if(str == wxT("end-stepping-range"))
+        return EndSteppingRange;
     else if(str == wxT("signal-received"))
         return SignalReceived;
     else
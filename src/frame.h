@@ -66,7 +66,7 @@ struct StoppedReason
 //        FunctionFinished, // An -exec-finish or similar CLI command was accomplished.
 //        LocationReached // An -exec-until or similar CLI command was accomplished.
 //        WatchpointScope, // A watchpoint has gone out of scope.
-//        EndSteppingRange, // An -exec-next, -exec-next-instruction, -exec-step, -exec-step-instruction or similar CLI command was accomplished.
+        EndSteppingRange, // An -exec-next, -exec-next-instruction, -exec-step, -exec-step-instruction or similar CLI command was accomplished.
         ExitedSignalled, // The inferior exited because of a signal.
         Exited, // The inferior exited.
         ExitedNormally, // The inferior exited normally.
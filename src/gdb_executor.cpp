@@ -10,7 +10,11 @@
 #include <debuggermanager.h>
 #include <pipedprocess.h>
 
+#include <wx/stopwatch.h>
+#include <wx/utils.h>
+
 #include "helpers.h"
+#include "output_reader.h"
 
 namespace
 {
@@ -141,6 +145,26 @@ void GetChildPIDs(int parent, std::vector<int> &childs)
 namespace dbg_mi
 {
 
+/// The output of gdb is read by the threads of the executor, they must stop or take over their streams before
+/// PipedProcess deletes them.
+class ReaderProcess : public PipedProcess
+{
+public:
+    ReaderProcess(PipedProcess **pvThis, wxEvtHandler *parent, int id, wxString const &cwd, GDBExecutor &executor) :
+        PipedProcess(pvThis, parent, id, true, cwd),
+        m_executor(executor)
+    {
+    }
+
+    virtual void OnTerminate(int pid, int status)
+    {
+        m_executor.StopReaders(true);
+        PipedProcess::OnTerminate(pid, status);
+    }
+private:
+    GDBExecutor &m_executor;
+};
+
 void LogPaneLogger::Log(wxString const &line, Log::Type type)
 {
     if (m_shutdowned)
@@ -188,18 +212,23 @@ void LogPaneLogger::Debug(wxString const &line, Line::Type type)
 
 GDBExecutor::GDBExecutor() :
     m_process(NULL),
+    m_stdout_reader(NULL),
+    m_stderr_reader(NULL),
     m_pid(-1),
     m_child_pid(-1),
     m_attached_pid(-1),
     m_stopped(true),
     m_interupting(false),
-    m_temporary_interupt(false)
+    m_temporary_interupt(false),
+    m_non_stop(false)
 {
     InitDebuggingFuncs();
 }
 
 GDBExecutor::~GDBExecutor()
 {
+    // the logger may be destroyed already, the output is dropped
+    StopReaders(false);
     FreeDebuggingFuncs();
 }
 
@@ -210,7 +239,7 @@ int GDBExecutor::LaunchProcess(wxString const &cmd, wxString const& cwd, int id_
         return -1;
 
     // start the gdb process
-    m_process = new PipedProcess(&m_process, event_handler, id_gdb_process, true, cwd);
+    m_process = new ReaderProcess(&m_process, event_handler, id_gdb_process, cwd, *this);
     logger.Log(_("Starting debugger: "));
     logger.Debug(wxT("Executing command: ") + cmd);
     m_pid = wxExecute(cmd, wxEXEC_ASYNC | wxEXEC_MAKE_GROUP_LEADER, m_process);
@@ -249,6 +278,15 @@ int GDBExecutor::LaunchProcess(wxString const &cmd, wxString const& cwd, int id_
         logger.Log(_("failed (to get debugger's stderr)"), Logger::Log::Error);
         return -2;
     }
+
+    m_stdout_reader = new OutputReader(*m_process->GetInputStream(), *event_handler, id_gdb_process);
+    m_stderr_reader = new OutputReader(*m_process->GetErrorStream(), *event_handler, id_gdb_process);
+    if(!m_stdout_reader->Start() || !m_stderr_reader->Start())
+    {
+        logger.Log(_("failed (to start the threads reading debugger's output)"), Logger::Log::Error);
+        ForceStop();
+        return -3;
+    }
     logger.Log(_("done"));
 
     return 0;
@@ -275,9 +313,86 @@ long GDBExecutor::GetChildPID()
 }
 
 
-bool GDBExecutor::ProcessHasInput()
+bool GDBExecutor::ReadOutput()
 {
-    return m_process && m_process->HasInput();
+    bool read = false;
+    OutputReader *readers[] = { m_stdout_reader, m_stderr_reader };
+    for(int ii = 0; ii < 2; ++ii)
+    {
+        if(!readers[ii])
+            continue;
+        readers[ii]->ResetWakeUp();
+        while(ParsedOutput *batch = readers[ii]->PopBatch())
+        {
+            ProcessOutput(*batch);
+            delete batch;
+            read = true;
+        }
+    }
+    return read;
+}
+
+void GDBExecutor::DropOutput()
+{
+    OutputReader *readers[] = { m_stdout_reader, m_stderr_reader };
+    for(int ii = 0; ii < 2; ++ii)
+    {
+        if(!readers[ii])
+            continue;
+        readers[ii]->ResetWakeUp();
+        while(ParsedOutput *batch = readers[ii]->PopBatch())
+            delete batch;
+    }
+}
+
+void GDBExecutor::StopReaders(bool read_output)
+{
+    OutputReader *readers[] = { m_stdout_reader, m_stderr_reader };
+    // without the output there is no reason to wait for the end of the pipes
+    for(int ii = 0; ii < 2 && !read_output; ++ii)
+    {
+        if(readers[ii])
+            readers[ii]->Stop();
+    }
+
+    // The threads exit when gdb closes its end of the pipes, but a debuggee, which has inherited them, can keep
+    // them open, so the GUI thread waits only for a while. It takes the batches meanwhile, a full queue would block
+    // the threads.
+    wxStopWatch watch;
+    for(;;)
+    {
+        if(read_output)
+            ReadOutput();
+        else
+            DropOutput();
+        bool const exited = (!m_stdout_reader || m_stdout_reader->HasExited())
+                            && (!m_stderr_reader || m_stderr_reader->HasExited());
+        if(exited || watch.Time() >= c_reader_exit_timeout)
+            break;
+        wxMilliSleep(1);
+    }
+
+    for(int ii = 0; ii < 2; ++ii)
+    {
+        if(!readers[ii])
+            continue;
+        readers[ii]->Stop();
+        if(!readers[ii]->HasExited() && readers[ii]->Abandon())
+        {
+            // The thread is still blocked in a read and it deletes the stream, when the read returns, so the
+            // process mustn't delete it. The reader is leaked, because the thread still uses it.
+            if(m_process)
+            {
+                m_process->SetPipeStreams(ii == 0 ? NULL : m_process->GetInputStream(),
+                                          m_process->GetOutputStream(),
+                                          ii == 1 ? NULL : m_process->GetErrorStream());
+            }
+            continue;
+        }
+        readers[ii]->Join();
+        delete readers[ii];
+    }
+    m_stdout_reader = m_stderr_reader = NULL;
 }
 
 bool GDBExecutor::IsRunning() const
@@ -309,6 +424,15 @@ void GDBExecutor::Interupt(bool temporary)
     if(m_logger)
         m_logger->Debug(wxT("Interupting debugger"));
 
+    if(m_non_stop)
+    {
+        // gdb accepts commands while the threads are running, there is no need for a signal
+        m_temporary_interupt = temporary;
+        m_interupting = true;
+        Execute(wxT("-exec-interrupt --all"));
+        return;
+    }
+
     // FIXME (obfuscated#): do something similar for the windows platform
     // non-windows gdb can interrupt the running process. yay!
     if(m_pid <= 0) // look out for the "fake" PIDs (killall)
@@ -368,19 +492,36 @@ bool GDBExecutor::DoExecute(dbg_mi::CommandID const &id, wxString const &cmd)
 {
     if(!m_process)
         return false;
-    if(!m_stopped && m_logger)
+    if(!AcceptsCommands() && m_logger)
     {
         m_logger->Debug(wxString::Format(wxT("GDBExecutor is not stopped, but command (%s) was executed!"),
                                          cmd.c_str())
                         );
     }
 
-    m_process->SendString(id.ToString() + cmd);
+    if(IsBatching())
+    {
+        if(!m_batch.empty())
+            m_batch += wxT("\n");
+        m_batch += id.ToString() + cmd;
+    }
+    else
+        m_process->SendString(id.ToString() + cmd);
     return true;
 }
+
+void GDBExecutor::DoFlush()
+{
+    // SendString adds the line end of the last command
+    if(m_process && !m_batch.empty())
+        m_process->SendString(m_batch);
+    m_batch.clear();
+}
+
 void GDBExecutor::DoClear()
 {
     m_stopped = true;
+    m_batch.clear();
     delete m_process;
     m_process = NULL;
 }
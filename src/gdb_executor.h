@@ -9,6 +9,11 @@ class wxEvtHandler;
 
 namespace dbg_mi
 {
+class OutputReader;
+
+/// How long the GUI thread waits for the threads reading the output of gdb to exit, in milliseconds.
+const long c_reader_exit_timeout = 200;
+
 class LogPaneLogger : public Logger
 {
 public:
@@ -46,9 +51,16 @@ public:
 
     int LaunchProcess(wxString const &cmd, wxString const& cwd, int id_gdb_process, wxEvtHandler *event_handler, Logger &logger);
 
-    bool ProcessHasInput();
+    /// Takes the records, which the reader threads have parsed; returns false if there were none.
+    bool ReadOutput();
     bool IsRunning() const;
     bool IsStopped() const { return m_stopped; }
+    /// In non-stop mode the threads run and stop on their own and gdb accepts commands while some of them run.
+    /// IsStopped tells whether the current thread is stopped.
+    void SetNonStop(bool flag) { m_non_stop = flag; }
+    bool IsNonStop() const { return m_non_stop; }
+    /// True if the commands of the actions can be sent to gdb.
+    bool AcceptsCommands() const { return m_stopped || m_non_stop; }
     bool Interupting() const { return m_interupting; }
     bool IsTemporaryInterupt() const { return m_temporary_interupt; }
 
@@ -67,15 +79,25 @@ public:
 protected:
     virtual bool DoExecute(dbg_mi::CommandID const &id, wxString const &cmd);
     virtual void DoClear();
+    virtual void DoFlush();
 private:
+    friend class ReaderProcess;
+
     long GetChildPID();
+    /// Stops the threads reading the output of gdb; the GUI thread waits at most c_reader_exit_timeout for them.
+    void StopReaders(bool read_output);
+    /// Takes the batches of the readers and deletes them.
+    void DropOutput();
 private:
     PipedProcess *m_process;
+    OutputReader *m_stdout_reader, *m_stderr_reader;
+    wxString m_batch;
     long m_pid, m_child_pid, m_attached_pid;
 
     bool m_stopped;
     bool m_interupting;
     bool m_temporary_interupt;
+    bool m_non_stop;
 };
 
 } // namespace dbg_mi
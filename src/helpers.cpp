@@ -1,5 +1,6 @@
 #include "helpers.h"
 
+#include <algorithm>
 #include <string.h>
 #include <stdio.h>
 
@@ -34,4 +35,127 @@ int ParseParentPID(const char *line)
     return count == 2 ? ppid : -1;
 }
 
+wxString AddThreadOption(wxString const &command, int thread_id)
+{
+    wxString const option = thread_id < 0 ? wxString(wxT(" --all")) : wxString::Format(wxT(" --thread %d"), thread_id);
+    int const pos = command.Find(wxT(' '));
+    if (pos == wxNOT_FOUND)
+        return command + option;
+    return command.Left(pos) + option + command.Mid(pos);
+}
+
+wxString QuoteString(wxString const &text)
+{
+    wxString result(wxT("\""));
+    for (size_t ii = 0; ii < text.length(); ++ii)
+    {
+        if (text[ii] == wxT('"') || text[ii] == wxT('\\'))
+            result += wxT('\\');
+        result += text[ii];
+    }
+    return result + wxT("\"");
+}
+
+namespace
+{
+bool IsIdentifierStart(wxChar ch)
+{
+    return (ch >= wxT('a') && ch <= wxT('z')) || (ch >= wxT('A') && ch <= wxT('Z')) || ch == wxT('_');
+}
+
+bool IsIdentifierChar(wxChar ch)
+{
+    return IsIdentifierStart(ch) || (ch >= wxT('0') && ch <= wxT('9'));
+}
+
+bool IsKeyword(wxString const &word)
+{
+    static wxChar const *keywords[] =
+    {
+        wxT("auto"), wxT("bool"), wxT("break"), wxT("case"), wxT("catch"), wxT("char"), wxT("class"),
+        wxT("const"), wxT("const_cast"), wxT("continue"), wxT("default"), wxT("delete"), wxT("do"),
+        wxT("double"), wxT("dynamic_cast"), wxT("else"), wxT("enum"), wxT("explicit"), wxT("extern"),
+        wxT("false"), wxT("float"), wxT("for"), wxT("friend"), wxT("goto"), wxT("if"), wxT("inline"),
+        wxT("int"), wxT("long"), wxT("mutable"), wxT("namespace"), wxT("new"), wxT("nullptr"),
+        wxT("operator"), wxT("private"), wxT("protected"), wxT("public"), wxT("register"),
+        wxT("reinterpret_cast"), wxT("return"), wxT("short"), wxT("signed"), wxT("sizeof"), wxT("static"),
+        wxT("static_cast"), wxT("struct"), wxT("switch"), wxT("template"), wxT("throw"), wxT("true"),
+        wxT("try"), wxT("typedef"), wxT("typename"), wxT("union"), wxT("unsigned"), wxT("using"),
+        wxT("virtual"), wxT("void"), wxT("volatile"), wxT("wchar_t"), wxT("while")
+    };
+    for (size_t ii = 0; ii < sizeof(keywords) / sizeof(keywords[0]); ++ii)
+    {
+        if (word == keywords[ii])
+            return true;
+    }
+    return false;
+}
+
+/// Returns the position of the first character after the spaces starting at pos.
+size_t SkipSpaces(wxString const &line, size_t pos)
+{
+    while (pos < line.length() && (line[pos] == wxT(' ') || line[pos] == wxT('\t')))
+        ++pos;
+    return pos;
+}
+} // anonymous namespace
+
+void ExtractIdentifiers(wxString const &line, std::vector<wxString> &identifiers)
+{
+    size_t const length = line.length();
+    size_t pos = SkipSpaces(line, 0);
+    if (pos < length && line[pos] == wxT('#'))
+        return;
+
+    // the position of the last character before the current token, which isn't a space
+    size_t previous = wxString::npos;
+    while (pos < length)
+    {
+        wxChar const ch = line[pos];
+        if (ch == wxT('/') && pos + 1 < length && line[pos + 1] == wxT('/'))
+            return;
+        else if (ch == wxT('/') && pos + 1 < length && line[pos + 1] == wxT('*'))
+        {
+            size_t const end = line.find(wxT("*/"), pos + 2);
+            if (end == wxString::npos)
+                return;
+            pos = end + 2;
+        }
+        else if (ch == wxT('"') || ch == wxT('\''))
+        {
+            ++pos;
+            while (pos < length && line[pos] != ch)
+                pos += line[pos] == wxT('\\') ? 2 : 1;
+            previous = pos;
+            ++pos;
+        }
+        else if (IsIdentifierChar(ch))
+        {
+            size_t const start = pos;
+            while (pos < length && IsIdentifierChar(line[pos]))
+                ++pos;
+            size_t const next = SkipSpaces(line, pos);
+            bool const member = previous != wxString::npos
+                                && (line[previous] == wxT('.')
+                                    || (previous > 0 && line.compare(previous - 1, 2, wxT("->")) == 0)
+                                    || (previous > 0 && line.compare(previous - 1, 2, wxT("::")) == 0));
+            bool const qualifier = next + 1 < length && line[next] == wxT(':') && line[next + 1] == wxT(':');
+            bool const call = next < length && line[next] == wxT('(');
+            wxString const word = line.substr(start, pos - start);
+            if (IsIdentifierStart(ch) && !member && !qualifier && !call && !IsKeyword(word)
+                && std::find(identifiers.begin(), identifiers.end(), word) == identifiers.end())
+            {
+                identifiers.push_back(word);
+            }
+            previous = pos - 1;
+        }
+        else
+        {
+            if (ch != wxT(' ') && ch != wxT('\t'))
+                previous = pos;
+            ++pos;
+        }
+    }
+}
+
 } // namespace dbg_mi
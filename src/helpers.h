@@ -1,10 +1,25 @@
 #ifndef _DEBUGGER_GDB_MI_HELPERS_H_
 #define _DEBUGGER_GDB_MI_HELPERS_H_
 
+#include <vector>
+#include <wx/string.h>
+
 namespace dbg_mi
 {
 int ParseParentPID(const char *line);
 
+/// Adds the thread option of the non-stop mode to an exec command: "--thread <id>" or "--all" if thread_id is -1.
+/// The option has to follow the name of the command.
+wxString AddThreadOption(wxString const &command, int thread_id);
+
+/// Quotes the text as a c-string parameter of a MI command.
+wxString QuoteString(wxString const &text);
+
+/// Appends the identifiers of a line of C/C++ code, which can be evaluated on their own, to identifiers.
+/// The keywords, the names of the called functions, the members and the scope qualifiers are skipped,
+/// as are the literals and the comments. Every identifier is added once.
+void ExtractIdentifiers(wxString const &line, std::vector<wxString> &identifiers);
+
 } // namespace dbg_mi
 
 #endif // _DEBUGGER_GDB_MI_HELPERS_H_
@@ -0,0 +1,133 @@
+#include "output_reader.h"
+
+#include <wx/stream.h>
+
+#include "events.h"
+
+namespace dbg_mi
+{
+
+OutputReader::OutputReader(wxInputStream &stream, wxEvtHandler &handler, int id) :
+    wxThread(wxTHREAD_JOINABLE),
+    m_stream(stream),
+    m_handler(handler),
+    m_id(id),
+    m_started(false),
+    m_wake_up_pending(0),
+    m_stopping(0),
+    m_state(StateRunning)
+{
+}
+
+OutputReader::~OutputReader()
+{
+    ParsedOutput *batch;
+    while(m_batches.Pop(batch))
+        delete batch;
+}
+
+bool OutputReader::Start()
+{
+    m_started = Create() == wxTHREAD_NO_ERROR && Run() == wxTHREAD_NO_ERROR;
+    return m_started;
+}
+
+void OutputReader::Stop()
+{
+    __atomic_store_n(&m_stopping, 1, __ATOMIC_RELEASE);
+}
+
+bool OutputReader::HasExited() const
+{
+    return !m_started || __atomic_load_n(&m_state, __ATOMIC_ACQUIRE) == StateExited;
+}
+
+void OutputReader::Join()
+{
+    if(m_started)
+        Wait();
+    m_started = false;
+}
+
+bool OutputReader::Abandon()
+{
+    return __atomic_exchange_n(&m_state, StateAbandoned, __ATOMIC_ACQ_REL) == StateRunning;
+}
+
+void OutputReader::ResetWakeUp()
+{
+    // an exchange and not a store, so the batches pushed before the last event are visible
+    __atomic_exchange_n(&m_wake_up_pending, 0, __ATOMIC_ACQ_REL);
+}
+
+ParsedOutput* OutputReader::PopBatch()
+{
+    ParsedOutput *batch;
+    return m_batches.Pop(batch) ? batch : NULL;
+}
+
+wxThread::ExitCode OutputReader::Entry()
+{
+    char buffer[4096];
+    ParsedOutput *batch = new ParsedOutput;
+    // the parser keeps the incomplete last line until the next read
+    OutputParser parser(*batch);
+
+    while(!IsStopping())
+    {
+        // blocks until there is some output, returns less than the buffer size if gdb has written less
+        size_t const length = m_stream.Read(buffer, sizeof(buffer)).LastRead();
+        if(IsStopping())
+            break;
+        if(length == 0)
+        {
+            if(m_stream.Eof() || !m_stream.IsOk())
+                break;
+            continue;
+        }
+
+        parser.Feed(buffer, length);
+        if(!batch->Empty())
+        {
+            PushBatch(batch);
+            batch = new ParsedOutput;
+            parser.SetHandler(*batch);
+        }
+    }
+
+    // gdb has exited without ending its last line
+    if(parser.HasPartialLine())
+        parser.Feed("\n", 1);
+    if(!batch->Empty() && !IsStopping())
+        PushBatch(batch);
+    else
+        delete batch;
+
+    // the executor has given up on the thread and detached the stream from the process
+    if(__atomic_exchange_n(&m_state, StateExited, __ATOMIC_ACQ_REL) == StateAbandoned)
+        delete &m_stream;
+    return 0;
+}
+
+void OutputReader::PushBatch(ParsedOutput *batch)
+{
+    // the GUI thread is busy, wait until it takes some of the batches; it doesn't take them while it is stopping
+    // the readers, so the batch is dropped
+    while(!m_batches.Push(batch))
+    {
+        if(IsStopping())
+        {
+            delete batch;
+            return;
+        }
+        Sleep(1);
+    }
+
+    if(!__atomic_exchange_n(&m_wake_up_pending, 1, __ATOMIC_ACQ_REL))
+    {
+        wxCommandEvent event(OutputReadyEventType, m_id);
+        m_handler.AddPendingEvent(event);
+    }
+}
+
+} // namespace dbg_mi
@@ -0,0 +1,70 @@
+#ifndef _DEBUGGER_GDB_MI_OUTPUT_READER_H_
+#define _DEBUGGER_GDB_MI_OUTPUT_READER_H_
+
+#include <wx/thread.h>
+
+#include "cmd_queue.h"
+#include "spsc_queue.h"
+
+class wxEvtHandler;
+class wxInputStream;
+
+namespace dbg_mi
+{
+
+/// Reads and parses one output stream of gdb on its own thread, so the GUI thread neither polls the stream nor
+/// parses the records. The records parsed from every block read from the stream are passed to the GUI thread in
+/// one batch. When the GUI thread has taken all batches, the next batch posts an OutputReadyEventType event to the
+/// handler, so there is one event per batch and not one per line.
+class OutputReader : public wxThread
+{
+public:
+    OutputReader(wxInputStream &stream, wxEvtHandler &handler, int id);
+    virtual ~OutputReader();
+
+    /// Creates and runs the thread.
+    bool Start();
+    /// Asks the thread to exit after its current read; the batches it reads from now on are dropped.
+    void Stop();
+    /// Returns true if the thread has exited; it can be joined without blocking.
+    bool HasExited() const;
+    /// Waits for the thread, must be called only after it has exited.
+    void Join();
+    /// Gives up on the thread, which is still blocked in a read, because something else keeps the pipe open.
+    /// The thread deletes the stream, when the read returns; the caller must not delete the stream or the reader.
+    /// Returns false if the thread has exited in the meantime, then it must be joined as usual.
+    bool Abandon();
+
+    /// Must be called by the GUI thread, before it takes the batches in response to the event.
+    void ResetWakeUp();
+    /// Must be called by the GUI thread, returns NULL if there are no batches. The caller owns the batch.
+    ParsedOutput* PopBatch();
+protected:
+    virtual ExitCode Entry();
+private:
+    void PushBatch(ParsedOutput *batch);
+    bool IsStopping() const { return __atomic_load_n(&m_stopping, __ATOMIC_ACQUIRE); }
+private:
+    enum State
+    {
+        StateRunning = 0,
+        StateExited,
+        StateAbandoned
+    };
+private:
+    typedef SPSCQueue<ParsedOutput*, 256> Batches;
+
+    Batches m_batches;
+    wxInputStream &m_stream;
+    wxEvtHandler &m_handler;
+    int m_id;
+    bool m_started;
+    int m_wake_up_pending;
+    int m_stopping;
+    // the thread and Abandon exchange it, so only one of them owns the stream, when the thread exits
+    int m_state;
+};
+
+} // namespace dbg_mi
+
+#endif // _DEBUGGER_GDB_MI_OUTPUT_READER_H_
@@ -3,16 +3,20 @@
 #include "plugin.h"
 
 #include <algorithm>
+#include <cstring>
 #include <wx/xrc/xmlres.h>
 #include <wx/wxscintilla.h>
 
 #include <cbdebugger_interfaces.h>
+#include <cbeditor.h>
 #include <cbproject.h>
+#include <cbstyledtextctrl.h>
 #include <compilercommandgenerator.h>
 #include <compilerfactory.h>
 #include <configurationpanel.h>
 #include <configmanager.h>
 //#include <editbreakpointdlg.h>
+#include <editormanager.h>
 #include <infowindow.h>
 #include <macrosmanager.h>
 #include <pipedprocess.h>
@@ -21,8 +25,10 @@
 #include "actions.h"
 #include "cmd_result_parser.h"
 #include "config.h"
+#include "edit_breakpoint_dialog.h"
 #include "escape.h"
 #include "frame.h"
+#include "helpers.h"
 
 #ifndef __WX_MSW__
 #include <dirent.h>
@@ -40,8 +46,9 @@ namespace
 namespace
 {
     int const id_gdb_process = wxNewId();
-    int const id_gdb_poll_timer = wxNewId();
     int const id_menu_info_command_stream = wxNewId();
+    int const id_menu_info_performance = wxNewId();
+    int const id_menu_info_threads_snapshot = wxNewId();
 }
 
 
@@ -73,14 +80,14 @@ wxString GetLibraryPath(const wxString &oldLibPath, Compiler *compiler, ProjectB
 // events handling
 BEGIN_EVENT_TABLE(Debugger_GDB_MI, cbDebuggerPlugin)
 
-    EVT_PIPEDPROCESS_STDOUT(id_gdb_process, Debugger_GDB_MI::OnGDBOutput)
-    EVT_PIPEDPROCESS_STDERR(id_gdb_process, Debugger_GDB_MI::OnGDBOutput)
+    EVT_DBGMI_OUTPUT_READY(id_gdb_process, Debugger_GDB_MI::OnGDBOutputReady)
     EVT_PIPEDPROCESS_TERMINATED(id_gdb_process, Debugger_GDB_MI::OnGDBTerminated)
 
     EVT_IDLE(Debugger_GDB_MI::OnIdle)
-    EVT_TIMER(id_gdb_poll_timer, Debugger_GDB_MI::OnTimer)
 
     EVT_MENU(id_menu_info_command_stream, Debugger_GDB_MI::OnMenuInfoCommandStream)
+    EVT_MENU(id_menu_info_performance, Debugger_GDB_MI::OnMenuInfoPerformance)
+    EVT_MENU(id_menu_info_threads_snapshot, Debugger_GDB_MI::OnMenuInfoThreadsSnapshot)
 END_EVENT_TABLE()
 
 // constructor
@@ -89,8 +96,12 @@ Debugger_GDB_MI::Debugger_GDB_MI() :
     m_project(nullptr),
     m_execution_logger(this),
     m_command_stream_dialog(nullptr),
+    m_performance_dialog(nullptr),
+    m_threads_snapshot_dialog(nullptr),
     m_console_pid(-1),
-    m_pid_attached(0)
+    m_pid_attached(0),
+    m_run_generation(0),
+    m_hit_counts_changed(false)
 {
     // Make sure our resources are available.
     // In the generated boilerplate code we have no resources but when
@@ -110,8 +121,6 @@ Debugger_GDB_MI::~Debugger_GDB_MI()
 
 void Debugger_GDB_MI::OnAttachReal()
 {
-    m_timer_poll_debugger.SetOwner(this, id_gdb_poll_timer);
-
     DebuggerManager &dbg_manager = *Manager::Get()->GetDebuggerManager();
     dbg_manager.RegisterDebugger(this);
 }
@@ -131,11 +140,23 @@ void Debugger_GDB_MI::OnReleaseReal(bool appShutDown)
         m_command_stream_dialog->Destroy();
         m_command_stream_dialog = nullptr;
     }
+    if (m_performance_dialog)
+    {
+        m_performance_dialog->Destroy();
+        m_performance_dialog = nullptr;
+    }
+    if (m_threads_snapshot_dialog)
+    {
+        m_threads_snapshot_dialog->Destroy();
+        m_threads_snapshot_dialog = nullptr;
+    }
 }
 
 void Debugger_GDB_MI::SetupToolsMenu(wxMenu &menu)
 {
     menu.Append(id_menu_info_command_stream, _("Show command stream"));
+    menu.Append(id_menu_info_performance, _("Show debugger performance"));
+    menu.Append(id_menu_info_threads_snapshot, _("Show stacks of all threads"));
 }
 
 bool Debugger_GDB_MI::SupportsFeature(cbDebuggerFeature::Flags flag)
@@ -212,20 +233,25 @@ bool Debugger_GDB_MI::SelectCompiler(cbProject &project, Compiler *&compiler,
     return true;
 }
 
-void Debugger_GDB_MI::OnGDBOutput(wxCommandEvent& event)
+void Debugger_GDB_MI::OnGDBOutputReady(wxCommandEvent& /*event*/)
 {
-    wxString const &msg = event.GetString();
-    if (!msg.IsEmpty())
-        ParseOutput(msg);
+    if(m_executor.ReadOutput())
+        RunQueue();
 }
 
 void Debugger_GDB_MI::OnGDBTerminated(wxCommandEvent& /*event*/)
 {
     ClearActiveMarkFromAllEditors();
     Log(_T("debugger terminated!"), Logger::warning);
-    m_timer_poll_debugger.Stop();
     m_actions.Clear();
+    m_run_generation = 0;
     m_executor.Clear();
+    // the varobjs are gone with gdb, only the watches of the dismissed tooltips are removed
+    dbg_mi::TooltipCache::Watches cached_tooltips;
+    m_tooltip_cache.NewGeneration(cached_tooltips);
+    DeleteWatches(cached_tooltips);
+    m_threads.clear();
+    m_backtrace_cache.Clear();
 
     // Notify debugger plugins for end of debug session
     PluginManager *plm = Manager::Get()->GetPluginManager();
@@ -237,26 +263,16 @@ void Debugger_GDB_MI::OnGDBTerminated(wxCommandEvent& /*event*/)
     KillConsole();
     MarkAsStopped();
 
-    for (Breakpoints::iterator it = m_breakpoints.begin(); it != m_breakpoints.end(); ++it)
-        (*it)->SetIndex(-1);
+    m_breakpoints.ResetNumbers();
 }
 
 void Debugger_GDB_MI::OnIdle(wxIdleEvent& event)
 {
-    if(m_executor.IsStopped() && m_executor.IsRunning())
+    if(m_executor.AcceptsCommands() && m_executor.IsRunning())
     {
         m_actions.Run(m_executor);
     }
-    if(m_executor.ProcessHasInput())
-        event.RequestMore();
-    else
-        event.Skip();
-}
-
-void Debugger_GDB_MI::OnTimer(wxTimerEvent& /*event*/)
-{
-    RunQueue();
-    wxWakeUpIdle();
+    event.Skip();
 }
 
 void Debugger_GDB_MI::OnMenuInfoCommandStream(wxCommandEvent& /*event*/)
@@ -276,6 +292,62 @@ void Debugger_GDB_MI::OnMenuInfoCommandStream(wxCommandEvent& /*event*/)
     }
 }
 
+void Debugger_GDB_MI::OnMenuInfoPerformance(wxCommandEvent& /*event*/)
+{
+    // The latencies of the commands are measured from sending them to receiving their result records, so they show
+    // the time spent in gdb; the time the plugin needs to handle the records is in a separate row.
+    wxString const report = m_executor.GetStats().MakeReport();
+    if (m_performance_dialog)
+    {
+        m_performance_dialog->SetText(report);
+        m_performance_dialog->Show();
+    }
+    else
+    {
+        m_performance_dialog = new dbg_mi::TextInfoWindow(Manager::Get()->GetAppWindow(), wxT("Debugger performance"),
+                                                          report);
+        m_performance_dialog->Show();
+    }
+}
+
+namespace
+{
+struct ThreadsSnapshotNotification : dbg_mi::ThreadsSnapshotInvoker
+{
+    ThreadsSnapshotNotification(Debugger_GDB_MI *plugin) : m_plugin(plugin) {}
+
+    virtual void Invoke(dbg_mi::ThreadsSnapshot const &snapshot)
+    {
+        m_plugin->ShowThreadsSnapshot(snapshot.MakeReport());
+    }
+
+    Debugger_GDB_MI *m_plugin;
+};
+} // anonymous namespace
+
+void Debugger_GDB_MI::OnMenuInfoThreadsSnapshot(wxCommandEvent& /*event*/)
+{
+    if (!IsRunning() || !IsStopped())
+        return;
+    m_actions.Add(new dbg_mi::GenerateThreadsSnapshot(new ThreadsSnapshotNotification(this), m_threads,
+                                                      m_execution_logger));
+}
+
+void Debugger_GDB_MI::ShowThreadsSnapshot(wxString const &report)
+{
+    if (m_threads_snapshot_dialog)
+    {
+        m_threads_snapshot_dialog->SetText(report);
+        m_threads_snapshot_dialog->Show();
+    }
+    else
+    {
+        m_threads_snapshot_dialog = new dbg_mi::TextInfoWindow(Manager::Get()->GetAppWindow(),
+                                                               wxT("Stacks of all threads"), report);
+        m_threads_snapshot_dialog->Show();
+    }
+}
+
 void Debugger_GDB_MI::AddStringCommand(wxString const &command)
 {
 //-    Manager::Get()->GetLogManager()->Log(wxT("Queue command: ") + command, m_dbg_page_index);
@@ -302,6 +374,9 @@ struct Notifications
         m_plugin->DebugLog(_T("notification event recieved!"));
         if(m_simple_mode)
         {
+            // the selected thread is stopped, the others may be running in non-stop mode
+            if(m_executor.IsNonStop())
+                m_executor.Stopped(true);
             ParseStateInfo(result_value);
             m_plugin->UpdateWhenStopped();
         }
@@ -309,9 +384,23 @@ struct Notifications
         {
             if (parser.GetResultType() == dbg_mi::ResultParser::NotifyAsyncOutput)
                 ParseNotifyAsyncOutput(parser);
+            else if(parser.GetResultClass() == dbg_mi::ResultParser::ClassRunning)
+            {
+                wxString thread_id;
+                if(dbg_mi::Lookup(result_value, wxT("thread-id"), thread_id))
+                    m_plugin->GetThreadsContainer().SetRunning(ParseThreadID(thread_id), true);
+            }
             else if(parser.GetResultClass() == dbg_mi::ResultParser::ClassStopped)
             {
                 dbg_mi::StoppedReason reason = dbg_mi::StoppedReason::Parse(result_value);
+                ParseStoppedThreads(result_value);
+                if(IsStopOfOtherThread(reason, result_value))
+                {
+                    // In non-stop mode the cursor stays in the thread, which is being inspected; the other stopped
+                    // threads can be selected in the threads window.
+                    m_plugin->DebugLog(wxT("a thread, which is not the current one, has stopped"));
+                    return;
+                }
 
                 switch(reason.GetType())
                 {
@@ -350,7 +439,12 @@ struct Notifications
                         m_executor.Execute(wxT("-gdb-exit"));
                     }
                     break;
+                case dbg_mi::StoppedReason::EndSteppingRange:
+                    m_plugin->GetBacktraceCache().OnStop(true);
+                    UpdateCursor(result_value, !m_executor.IsTemporaryInterupt());
+                    break;
                 default:
+                    m_plugin->GetBacktraceCache().OnStop(false);
                     UpdateCursor(result_value, !m_executor.IsTemporaryInterupt());
                 }
 
@@ -361,12 +455,53 @@ struct Notifications
     }
 
 private:
+    static int ParseThreadID(wxString const &thread_id)
+    {
+        long id;
+        if(thread_id == wxT("all") || !thread_id.ToLong(&id, 10))
+            return -1;
+        return id;
+    }
+
+    void ParseStoppedThreads(dbg_mi::ResultValue const &result_value)
+    {
+        dbg_mi::ThreadsContainer &threads = m_plugin->GetThreadsContainer();
+        dbg_mi::ResultValue const *stopped = result_value.GetTupleValue(wxT("stopped-threads"));
+        if(!stopped || stopped->GetType() == dbg_mi::ResultValue::Simple)
+            threads.SetRunning(-1, false);
+        else
+        {
+            for(int ii = 0; ii < stopped->GetTupleSize(); ++ii)
+                threads.SetRunning(ParseThreadID(stopped->GetTupleValueByIndex(ii)->GetSimpleValue()), false);
+        }
+    }
+
+    bool IsStopOfOtherThread(dbg_mi::StoppedReason const &reason, dbg_mi::ResultValue const &result_value) const
+    {
+        if(!m_executor.IsNonStop() || !m_executor.IsStopped())
+            return false;
+        switch(reason.GetType())
+        {
+        case dbg_mi::StoppedReason::ExitedNormally:
+        case dbg_mi::StoppedReason::ExitedSignalled:
+        case dbg_mi::StoppedReason::Exited:
+            return false;
+        default:
+            break;
+        }
+        int thread_id;
+        return dbg_mi::Lookup(result_value, wxT("thread-id"), thread_id)
+               && thread_id != m_plugin->GetCurrentFrame().GetThreadId();
+    }
+
     void UpdateCursor(dbg_mi::ResultValue const &result_value, bool parse_state_info)
     {
         if(parse_state_info)
             ParseStateInfo(result_value);
 
         m_executor.Stopped(true);
+        // the debuggee has run, so the frames of the threads have changed
+        m_plugin->GetThreadsContainer().MarkFramesAsStale();
 
         // Notify debugger plugins for end of debug session
         PluginManager *plm = Manager::Get()->GetPluginManager();
@@ -392,7 +527,7 @@ private:
             if(thread_id_value)
             {
                 long id;
-                if(!thread_id_value->GetSimpleValue().ToLong(&id, 10))
+                if(!thread_id_value->ToLong(id))
                 {
                     m_plugin->Log(wxString::Format(wxT("Debugger_GDB_MI::OnGDBNotification ")
                                                    wxT(" thread_id parsing failed (%s)"),
@@ -422,6 +557,48 @@ private:
             if (!exec.HasChildPID())
                 exec.SetChildPID(pid);
         }
+        else if (parser.GetAsyncNotifyType() == wxT("thread-created"))
+        {
+            int id;
+            if (dbg_mi::Lookup(parser.GetResultValue(), wxT("id"), id))
+                m_plugin->GetThreadsContainer().Add(id);
+        }
+        else if (parser.GetAsyncNotifyType() == wxT("thread-exited"))
+        {
+            int id;
+            if (dbg_mi::Lookup(parser.GetResultValue(), wxT("id"), id))
+                m_plugin->GetThreadsContainer().Remove(id);
+        }
+        else if (parser.GetAsyncNotifyType() == wxT("breakpoint-deleted"))
+        {
+            // deleted from the console, the breakpoint stays in the list and is set again on the next start
+            int number;
+            if (dbg_mi::Lookup(parser.GetResultValue(), wxT("id"), number))
+            {
+                dbg_mi::BreakpointsContainer &breakpoints = m_plugin->GetBreakpoints();
+                cb::shared_ptr<dbg_mi::Breakpoint> breakpoint = breakpoints.FindByNumber(number);
+                if (breakpoint)
+                    breakpoints.SetNumber(*breakpoint, -1);
+            }
+        }
+        else if (parser.GetAsyncNotifyType() == wxT("breakpoint-modified"))
+        {
+            // gdb reports every hit, also the ones skipped by the ignore count or by the target-side condition
+            int number, times;
+            dbg_mi::ResultValue const &result_value = parser.GetResultValue();
+            if (dbg_mi::Lookup(result_value, wxT("bkpt.number"), number)
+                && dbg_mi::Lookup(result_value, wxT("bkpt.times"), times))
+            {
+                if (m_plugin->GetBreakpoints().UpdateHitCount(number, times))
+                    m_plugin->MarkHitCountsChanged();
+            }
+        }
+        else if (parser.GetAsyncNotifyType() == wxT("thread-selected"))
+        {
+            int id;
+            if (dbg_mi::Lookup(parser.GetResultValue(), wxT("id"), id))
+                m_plugin->GetThreadsContainer().SetCurrent(id);
+        }
 //        else
 //            m_plugin->Log(wxString::Format(wxT("Notification: %s\n"), parser.GetAsyncNotifyType().c_str()));
     }
@@ -444,52 +621,99 @@ void Debugger_GDB_MI::UpdateOnFrameChanged(bool wait)
         for(dbg_mi::WatchesContainer::iterator it = m_watches.begin(); it != m_watches.end(); ++it)
         {
             if((*it)->GetID().empty() && !(*it)->ForTooltip())
-                m_actions.Add(new dbg_mi::WatchCreateAction(*it, m_watches, m_execution_logger));
+                AddRefreshAction(new dbg_mi::WatchCreateAction(*it, m_watches, m_execution_logger));
         }
-        m_actions.Add(new dbg_mi::WatchesUpdateAction(m_watches, m_execution_logger));
+        AddRefreshAction(new dbg_mi::WatchesUpdateAction(m_watches, m_execution_logger));
     }
 }
 
 void Debugger_GDB_MI::UpdateWhenStopped()
 {
+    // the values of the cached tooltips are from the previous stop
+    dbg_mi::TooltipCache::Watches stale_tooltips;
+    m_tooltip_cache.NewGeneration(stale_tooltips);
+    DeleteWatches(stale_tooltips);
+
+    // In non-stop mode gdb doesn't select the thread, which has stopped, but the windows show it.
+    if(m_executor.IsNonStop() && m_current_frame.GetThreadId() >= 0)
+    {
+        dbg_mi::Action *select = new dbg_mi::SimpleAction(wxString::Format(wxT("-thread-select %d"),
+                                                                           m_current_frame.GetThreadId()));
+        // the backtrace has a high priority and it needs the thread
+        select->SetPriority(dbg_mi::Action::PriorityHigh);
+        select->SetSelectsFrame(true);
+        m_actions.Add(select);
+    }
+
     DebuggerManager *dbg_manager = Manager::Get()->GetDebuggerManager();
     if(dbg_manager->UpdateBacktrace())
         RequestUpdate(Backtrace);
 
+    // the hits of a breakpoint in a hot loop are shown once per stop and not once per notification
+    if(m_hit_counts_changed)
+    {
+        m_hit_counts_changed = false;
+        dbg_manager->GetBreakpointDialog()->Reload();
+    }
+
     if(dbg_manager->UpdateThreads())
         RequestUpdate(Threads);
 
     UpdateOnFrameChanged(false);
+    PrefetchTooltips();
 }
 
-void Debugger_GDB_MI::RunQueue()
+void Debugger_GDB_MI::PrefetchTooltips()
 {
-    if(m_executor.IsRunning())
+    if(!GetActiveConfigEx().GetFlag(dbg_mi::Configuration::PrefetchTooltips))
+        return;
+
+    wxString filename;
+    int line;
+    m_current_frame.GetPosition(filename, line);
+    cbEditor *editor = Manager::Get()->GetEditorManager()->GetBuiltinEditor(filename);
+    if(!editor || line <= 0)
+        return;
+
+    cbStyledTextCtrl *control = editor->GetControl();
+    std::vector<wxString> identifiers;
+    for(int ii = line - 1; ii < line - 1 + dbg_mi::c_prefetch_lines && ii < control->GetLineCount(); ++ii)
+        dbg_mi::ExtractIdentifiers(control->GetLine(ii), identifiers);
+
+    // the varobjs are created in one pipelined batch, the budget bounds the commands sent on every stop
+    int const thread_id = m_current_frame.GetThreadId();
+    int const frame = GetTooltipFrame();
+    int const count = std::min<int>(identifiers.size(), dbg_mi::c_prefetch_budget);
+    for(int ii = 0; ii < count; ++ii)
     {
-        Notifications notifications(this, m_executor, false);
-        dbg_mi::DispatchResults(m_executor, m_actions, notifications);
+        cb::shared_ptr<dbg_mi::Watch> w(new dbg_mi::Watch(identifiers[ii], true));
+        m_watches.push_back(w);
+        m_tooltip_cache.AddPrefetched(w, identifiers[ii], thread_id, frame);
 
-        if(m_executor.IsStopped())
-            m_actions.Run(m_executor);
+        dbg_mi::Action *action = new dbg_mi::WatchCreateAction(w, m_watches, m_execution_logger);
+        action->SetPriority(dbg_mi::Action::PriorityLow);
+        AddRefreshAction(action);
     }
 }
 
-void Debugger_GDB_MI::ParseOutput(wxString const &str)
+void Debugger_GDB_MI::RunQueue()
 {
-    if(!str.IsEmpty())
+    if(m_executor.IsRunning())
     {
-        wxArrayString const &lines = GetArrayFromString(str, _T('\n'));
-        for(size_t ii = 0; ii < lines.GetCount(); ++ii)
-            m_executor.ProcessOutput(lines[ii]);
-        m_actions.Run(m_executor);
+        Notifications notifications(this, m_executor, false);
+        dbg_mi::DispatchResults(m_executor, m_actions, notifications);
+
+        if(m_executor.AcceptsCommands())
+            m_actions.Run(m_executor);
     }
 }
 
 struct StopNotification
 {
-    StopNotification(cbDebuggerPlugin *plugin, dbg_mi::GDBExecutor &executor) :
+    StopNotification(Debugger_GDB_MI *plugin, dbg_mi::GDBExecutor &executor, int generation) :
         m_plugin(plugin),
-        m_executor(executor)
+        m_executor(executor),
+        m_generation(generation)
     {
     }
 
@@ -497,13 +721,25 @@ struct StopNotification
     {
         m_executor.Stopped(stopped);
         if(!stopped)
+        {
+            m_plugin->SetRunGeneration(m_generation);
             m_plugin->ClearActiveMarkFromAllEditors();
+        }
     }
 
-    cbDebuggerPlugin *m_plugin;
+    Debugger_GDB_MI *m_plugin;
     dbg_mi::GDBExecutor &m_executor;
+    int m_generation;
 };
 
+void Debugger_GDB_MI::AddRefreshAction(dbg_mi::Action *action)
+{
+    // If another run command is queued, the action refreshes a stop, which is already superseded,
+    // so it is canceled right away.
+    action->SetGeneration(m_run_generation);
+    m_actions.Add(action);
+}
+
 bool Debugger_GDB_MI::Debug(bool breakOnEntry)
 {
     m_hasStartUpError = false;
@@ -549,23 +785,10 @@ void Debugger_GDB_MI::ConvertDirectory(wxString& str, wxString base, bool relati
     dbg_mi::ConvertDirectory(str, base, relative);
 }
 
-struct BreakpointMatchProject
-{
-    BreakpointMatchProject(cbProject *project) : project(project) {}
-    bool operator()(cb::shared_ptr<dbg_mi::Breakpoint> bp) const
-    {
-        return bp->GetProject() == project;
-    }
-    cbProject *project;
-};
-
 void Debugger_GDB_MI::CleanupWhenProjectClosed(cbProject *project)
 {
-    Breakpoints::iterator it = std::remove_if(m_breakpoints.begin(), m_breakpoints.end(),
-                                              BreakpointMatchProject(project));
-    if (it != m_breakpoints.end())
+    if (m_breakpoints.RemoveProject(project))
     {
-        m_breakpoints.erase(it, m_breakpoints.end());
         // FIXME (#obfuscated): Optimize this when multiple projects are closed
         //                      (during workspace close operation for exmaple).
         cbBreakpointsDlg *dlg = Manager::Get()->GetDebuggerManager()->GetBreakpointDialog();
@@ -637,6 +860,7 @@ int Debugger_GDB_MI::LaunchDebugger(wxString const &debugger, wxString const &de
                                     int pid, bool console, StartType start_type)
 {
     m_current_frame.Reset();
+    m_current_frame.SetThreadId(-1);
     if(debugger.IsEmpty())
     {
         Log(_T("no debugger executable found (full path)!"), Logger::error);
@@ -668,7 +892,18 @@ int Debugger_GDB_MI::LaunchDebugger(wxString const &debugger, wxString const &de
         return ret;
 
     m_executor.Stopped(true);
+    m_executor.SetMaxInFlight(GetActiveConfigEx().GetMaxCommandsInFlight());
+    m_executor.SetNonStop(GetActiveConfigEx().GetFlag(dbg_mi::Configuration::NonStop));
+    if (m_executor.IsNonStop())
+    {
+        // non-stop mode needs the asynchronous mode of gdb and must be set before the debuggee is started
+        m_actions.Add(new dbg_mi::SimpleAction(wxT("-gdb-set target-async on")));
+        m_actions.Add(new dbg_mi::SimpleAction(wxT("-gdb-set non-stop on")));
+    }
 //    m_executor.Execute(_T("-enable-timings"));
+    // the conditions are evaluated by the target, if it can, so a false condition doesn't stop gdb
+    if (GetActiveConfigEx().GetFlag(dbg_mi::Configuration::TargetConditions))
+        m_actions.Add(new dbg_mi::SimpleAction(wxT("-gdb-set breakpoint condition-evaluation target")));
     CommitBreakpoints(true);
     CommitWatches();
 
@@ -712,8 +947,6 @@ int Debugger_GDB_MI::LaunchDebugger(wxString const &debugger, wxString const &de
     }
     m_actions.Run(m_executor);
 
-    m_timer_poll_debugger.Start(20);
-
     SwitchToDebuggingLayout();
     m_pid_attached = pid;
     return 0;
@@ -722,14 +955,15 @@ int Debugger_GDB_MI::LaunchDebugger(wxString const &debugger, wxString const &de
 void Debugger_GDB_MI::CommitBreakpoints(bool force)
 {
     DebugLog(wxT("Debugger_GDB_MI::CommitBreakpoints"));
-    for(Breakpoints::iterator it = m_breakpoints.begin(); it != m_breakpoints.end(); ++it)
+    // all breakpoints are inserted by one action, so the inserts are pipelined and not sent one by one
+    dbg_mi::BreakpointAddAction::BreakpointList breakpoints;
+    for(size_t ii = 0; ii < m_breakpoints.size(); ++ii)
     {
-        // FIXME (obfuscated#): pointers inside the vector can be dangerous!!!
-        if((*it)->GetIndex() == -1 || force)
-        {
-            m_actions.Add(new dbg_mi::BreakpointAddAction(*it, m_execution_logger));
-        }
+        if(m_breakpoints[ii]->GetIndex() == -1 || force)
+            breakpoints.push_back(m_breakpoints[ii]);
     }
+    if(!breakpoints.empty())
+        m_actions.Add(new dbg_mi::BreakpointAddAction(breakpoints, m_breakpoints, m_execution_logger));
 
     for(Breakpoints::const_iterator it = m_temporary_breakpoints.begin(); it != m_temporary_breakpoints.end(); ++it)
     {
@@ -743,17 +977,28 @@ void Debugger_GDB_MI::CommitWatches()
 {
     for(dbg_mi::WatchesContainer::iterator it = m_watches.begin(); it != m_watches.end(); ++it)
     {
+        m_watches.Unregister(*it);
         (*it)->Reset();
     }
     if(!m_watches.empty())
         Manager::Get()->GetDebuggerManager()->GetWatchesDialog()->UpdateWatches();
 }
 
-void Debugger_GDB_MI::CommitRunCommand(wxString const &command)
+void Debugger_GDB_MI::CommitRunCommand(wxString const &command, bool all_threads)
 {
     m_current_frame.Reset();
-    m_actions.Add(new dbg_mi::RunAction<StopNotification>(this, command,
-                                                          StopNotification(this, m_executor),
+
+    // In non-stop mode the stepping commands run only the current thread, the other threads keep running.
+    wxString cmd(command);
+    int const thread_id = m_current_frame.GetThreadId();
+    if (m_executor.IsNonStop() && command != wxT("-exec-run") && (all_threads || thread_id >= 0))
+        cmd = dbg_mi::AddThreadOption(command, all_threads ? -1 : thread_id);
+
+    // the refreshes of the current stop, which haven't finished yet, are useless after the run command
+    m_actions.NewGeneration();
+    m_actions.Add(new dbg_mi::RunAction<StopNotification>(this, cmd,
+                                                          StopNotification(this, m_executor,
+                                                                           m_actions.GetGeneration()),
                                                           m_execution_logger)
                   );
 }
@@ -797,7 +1042,7 @@ void Debugger_GDB_MI::Continue()
         return;
     }
     DebugLog(wxT("Debugger_GDB_MI::Continue"));
-    CommitRunCommand(wxT("-exec-continue"));
+    CommitRunCommand(wxT("-exec-continue"), true);
 }
 
 void Debugger_GDB_MI::Next()
@@ -915,7 +1160,12 @@ void Debugger_GDB_MI::SwitchToFrame(int number)
     m_execution_logger.Debug(wxT("Debugger_GDB_MI::SwitchToFrame"));
     if(IsRunning() && IsStopped())
     {
-        if(number < static_cast<int>(m_backtrace.size()))
+        if(number < static_cast<int>(m_backtrace.size()) && dbg_mi::IsMoreFramesPlaceholder(*m_backtrace[number]))
+        {
+            // Selecting the placeholder at the end of the backtrace loads the next page of frames.
+            LoadBacktrace(number);
+        }
+        else if(number < static_cast<int>(m_backtrace.size()))
         {
             m_execution_logger.Debug(wxT("Debugger_GDB_MI::SwitchToFrame - adding commnad"));
 
@@ -935,7 +1185,7 @@ cb::shared_ptr<cbBreakpoint> Debugger_GDB_MI::AddBreakpoint(const wxString& file
 {
     if(IsRunning())
     {
-        if(!IsStopped())
+        if(MustInterrupt())
         {
             DebugLog(wxString::Format(wxT("Debugger_GDB_MI::Addbreakpoint: %s:%d"),
                                       filename.c_str(), line));
@@ -944,8 +1194,8 @@ cb::shared_ptr<cbBreakpoint> Debugger_GDB_MI::AddBreakpoint(const wxString& file
             cbProject *project;
             project = Manager::Get()->GetProjectManager()->FindProjectForFile(filename, nullptr, false, false);
             cb::shared_ptr<dbg_mi::Breakpoint> ptr(new dbg_mi::Breakpoint(filename, line, project));
-            m_breakpoints.push_back(ptr);
-            m_actions.Add(new dbg_mi::BreakpointAddAction(ptr, m_execution_logger));
+            m_breakpoints.Add(ptr);
+            m_actions.Add(new dbg_mi::BreakpointAddAction(ptr, m_breakpoints, m_execution_logger));
             Continue();
         }
         else
@@ -953,15 +1203,15 @@ cb::shared_ptr<cbBreakpoint> Debugger_GDB_MI::AddBreakpoint(const wxString& file
             cbProject *project;
             project = Manager::Get()->GetProjectManager()->FindProjectForFile(filename, nullptr, false, false);
             cb::shared_ptr<dbg_mi::Breakpoint> ptr(new dbg_mi::Breakpoint(filename, line, project));
-            m_breakpoints.push_back(ptr);
-            m_actions.Add(new dbg_mi::BreakpointAddAction(ptr, m_execution_logger));
+            m_breakpoints.Add(ptr);
+            m_actions.Add(new dbg_mi::BreakpointAddAction(ptr, m_breakpoints, m_execution_logger));
         }
     }
     else
     {
         cbProject *project = Manager::Get()->GetProjectManager()->FindProjectForFile(filename, nullptr, false, false);
         cb::shared_ptr<dbg_mi::Breakpoint> ptr(new dbg_mi::Breakpoint(filename, line, project));
-        m_breakpoints.push_back(ptr);
+        m_breakpoints.Add(ptr);
     }
 
     return cb::static_pointer_cast<cbBreakpoint>(m_breakpoints.back());
@@ -989,72 +1239,40 @@ cb::shared_ptr<const cbBreakpoint> Debugger_GDB_MI::GetBreakpoint(int index) con
 
 void Debugger_GDB_MI::UpdateBreakpoint(cb::shared_ptr<cbBreakpoint> breakpoint)
 {
-#warning "not implemented"
-//    for(Breakpoints::iterator it = m_breakpoints.begin(); it != m_breakpoints.end(); ++it)
-//    {
-//        dbg_mi::Breakpoint &current = **it;
-//        if(&current.Get() != breakpoint)
-//            continue;
-//
-//        switch(breakpoint->GetType())
-//        {
-//        case cbBreakpoint::Code:
-//            {
-//                cbBreakpoint temp(*breakpoint);
-//                EditBreakpointDlg dialog(&temp);
-//                PlaceWindow(&dialog);
-//                if(dialog.ShowModal() == wxID_OK)
-//                {
-//                    // if the breakpoint is not sent to debugger, just copy
-//                    if(current.GetIndex() != -1 || !IsRunning())
-//                    {
-//                        current.Get() = temp;
-//                        current.SetIndex(-1);
-//                    }
-//                    else
-//                    {
-////                        bool resume = !m_executor.IsStopped();
-////                        if(resume)
-////                            m_executor.Interupt();
-//#warning "not implemented"
-//                        bool changed = false;
-//                        if(breakpoint->IsEnabled() == temp.IsEnabled())
-//                        {
-//                            if(breakpoint->IsEnabled())
-//                                AddStringCommand(wxString::Format(wxT("-break-enable %d"), current.GetIndex()));
-//                            else
-//                                AddStringCommand(wxString::Format(wxT("-break-disable %d"), current.GetIndex()));
-//                            changed = true;
-//                        }
-//
-//                        if(changed)
-//                        {
-//                            m_executor.Interupt();
-//                            Continue();
-//                        }
-//                    }
-//
-//                }
-//            }
-//            break;
-//        case cbBreakpoint::Data:
-//#warning "not implemented"
-//            break;
-//        }
-//    }
+    cb::shared_ptr<dbg_mi::Breakpoint> bp = cb::static_pointer_cast<dbg_mi::Breakpoint>(breakpoint);
+
+    dbg_mi::EditBreakpointDialog dialog(Manager::Get()->GetAppWindow(), bp->GetCondition(), bp->GetIgnoreCount());
+    PlaceWindow(&dialog);
+    if (dialog.ShowModal() != wxID_OK)
+        return;
+    bp->SetCondition(dialog.GetCondition());
+    bp->SetIgnoreCount(dialog.GetIgnoreCount());
+
+    // a breakpoint, which isn't set in gdb yet, gets the condition and the ignore count with the insert
+    if (IsRunning() && bp->GetIndex() != -1)
+    {
+        bool const interrupt = MustInterrupt();
+        if (interrupt)
+            m_executor.Interupt();
+        AddStringCommand(dbg_mi::MakeBreakpointConditionCommand(*bp));
+        AddStringCommand(wxString::Format(wxT("-break-after %d %d"), bp->GetIndex(), bp->GetIgnoreCount()));
+        if (interrupt)
+            Continue();
+    }
+    Manager::Get()->GetDebuggerManager()->GetBreakpointDialog()->Reload();
 }
 
 void Debugger_GDB_MI::DeleteBreakpoint(cb::shared_ptr<cbBreakpoint> breakpoint)
 {
-    Breakpoints::iterator it = std::find(m_breakpoints.begin(), m_breakpoints.end(), breakpoint);
-    if (it != m_breakpoints.end())
+    cb::shared_ptr<dbg_mi::Breakpoint> removed = m_breakpoints.Remove(breakpoint.get());
+    if (removed)
     {
         DebugLog(wxString::Format(wxT("Debugger_GDB_MI::DeleteBreakpoint: %s:%d"),
                                   breakpoint->GetLocation().c_str(), breakpoint->GetLine()));
-        int index = (*it)->GetIndex();
+        int index = removed->GetIndex();
         if (index != -1)
         {
-            if (!IsStopped())
+            if (MustInterrupt())
             {
                 m_executor.Interupt();
                 AddStringCommand(wxString::Format(wxT("-break-delete %d"), index));
@@ -1063,7 +1281,6 @@ void Debugger_GDB_MI::DeleteBreakpoint(cb::shared_ptr<cbBreakpoint> breakpoint)
             else
                 AddStringCommand(wxString::Format(wxT("-break-delete %d"), index));
         }
-        m_breakpoints.erase(it);
     }
 //    for(Breakpoints::iterator it = m_breakpoints.begin(); it != m_breakpoints.end(); ++it)
 //    {
@@ -1095,16 +1312,16 @@ void Debugger_GDB_MI::DeleteAllBreakpoints()
     if(IsRunning())
     {
         wxString breaklist;
-        for(Breakpoints::iterator it = m_breakpoints.begin(); it != m_breakpoints.end(); ++it)
+        for(size_t ii = 0; ii < m_breakpoints.size(); ++ii)
         {
-            dbg_mi::Breakpoint &current = **it;
+            dbg_mi::Breakpoint const &current = *m_breakpoints[ii];
             if(current.GetIndex() != -1)
                 breaklist += wxString::Format(wxT(" %d"), current.GetIndex());
         }
 
         if(!breaklist.empty())
         {
-            if(!IsStopped())
+            if(MustInterrupt())
             {
                 m_executor.Interupt();
                 AddStringCommand(wxT("-break-delete") + breaklist);
@@ -1122,18 +1339,18 @@ void Debugger_GDB_MI::ShiftBreakpoint(int index, int lines_to_shift)
     if (index < 0 || index >= static_cast<int>(m_breakpoints.size()))
         return;
     cb::shared_ptr<dbg_mi::Breakpoint> bp = m_breakpoints[index];
-    bp->ShiftLine(lines_to_shift);
+    m_breakpoints.ShiftLine(index, lines_to_shift);
 
     if(IsRunning())
     {
         // just remove the breakpoints as they will become invalid
-        if(!IsStopped())
+        if(MustInterrupt())
         {
             m_executor.Interupt();
             if (bp->GetIndex()>=0)
             {
                 AddStringCommand(wxString::Format(wxT("-break-delete %d"), bp->GetIndex()));
-                bp->SetIndex(-1);
+                m_breakpoints.SetNumber(*bp, -1);
             }
             Continue();
         }
@@ -1142,7 +1359,7 @@ void Debugger_GDB_MI::ShiftBreakpoint(int index, int lines_to_shift)
             if (bp->GetIndex()>=0)
             {
                 AddStringCommand(wxString::Format(wxT("-break-delete %d"), bp->GetIndex()));
-                bp->SetIndex(-1);
+                m_breakpoints.SetNumber(*bp, -1);
             }
         }
     }
@@ -1165,7 +1382,8 @@ cb::shared_ptr<const cbThread> Debugger_GDB_MI::GetThread(int index) const
 
 bool Debugger_GDB_MI::SwitchToThread(int thread_number)
 {
-    if(IsStopped())
+    // in non-stop mode a stopped thread can be selected, while the current thread is running
+    if(IsStopped() || (m_executor.IsNonStop() && !m_threads.IsRunning(thread_number)))
     {
         dbg_mi::SwitchToThread<Notifications> *a;
         a = new dbg_mi::SwitchToThread<Notifications>(thread_number, m_execution_logger,
@@ -1189,11 +1407,23 @@ cb::shared_ptr<cbWatch> Debugger_GDB_MI::AddWatch(const wxString& symbol)
 
 void Debugger_GDB_MI::AddTooltipWatch(const wxString &symbol, wxRect const &rect)
 {
+    int const thread_id = m_current_frame.GetThreadId();
+    int const frame = GetTooltipFrame();
+    cb::shared_ptr<dbg_mi::Watch> cached = m_tooltip_cache.Acquire(symbol, thread_id, frame);
+    if(cached)
+    {
+        Manager::Get()->GetDebuggerManager()->GetInterfaceFactory()->ShowValueTooltip(cached, rect);
+        return;
+    }
+
     cb::shared_ptr<dbg_mi::Watch> w(new dbg_mi::Watch(symbol, true));
     m_watches.push_back(w);
 
     if(IsRunning())
+    {
+        m_tooltip_cache.Add(w, symbol, thread_id, frame);
         m_actions.Add(new dbg_mi::WatchCreateTooltipAction(w, m_watches, m_execution_logger, rect));
+    }
 }
 
 void Debugger_GDB_MI::DeleteWatch(cb::shared_ptr<cbWatch> watch)
@@ -1203,18 +1433,38 @@ void Debugger_GDB_MI::DeleteWatch(cb::shared_ptr<cbWatch> watch)
     if(it == m_watches.end())
         return;
 
+    dbg_mi::TooltipCache::Watches watches;
+    // the varobj of a dismissed tooltip is kept for the next hover, until the debuggee moves
+    if(!(*it)->ForTooltip() || !m_tooltip_cache.Release(*it, watches))
+        watches.push_back(*it);
+    DeleteWatches(watches);
+}
+
+void Debugger_GDB_MI::DeleteWatches(dbg_mi::TooltipCache::Watches const &watches)
+{
+    if(watches.empty())
+        return;
+
     if(IsRunning())
     {
-        if(IsStopped())
-            AddStringCommand(wxT("-var-delete ") + (*it)->GetID());
-        else
-        {
+        bool const interrupt = MustInterrupt();
+        if(interrupt)
             m_executor.Interupt();
-            AddStringCommand(wxT("-var-delete ") + (*it)->GetID());
-            Continue();
+        for(dbg_mi::TooltipCache::Watches::const_iterator it = watches.begin(); it != watches.end(); ++it)
+        {
+            // a prefetched expression may have failed to evaluate
+            if(!(*it)->GetID().empty())
+                AddStringCommand(wxT("-var-delete ") + (*it)->GetID());
         }
+        if(interrupt)
+            Continue();
+    }
+    for(dbg_mi::TooltipCache::Watches::const_iterator it = watches.begin(); it != watches.end(); ++it)
+    {
+        dbg_mi::WatchesContainer::iterator it_watch = std::find(m_watches.begin(), m_watches.end(), *it);
+        if(it_watch != m_watches.end())
+            m_watches.erase(it_watch);
     }
-    m_watches.erase(it);
 }
 
 bool Debugger_GDB_MI::HasWatch(cb::shared_ptr<cbWatch> watch)
@@ -1251,6 +1501,19 @@ bool Debugger_GDB_MI::SetWatchValue(cb::shared_ptr<cbWatch> watch, const wxStrin
     return true;
 }
 
+namespace
+{
+bool HasFrozenChildren(cbWatch &watch)
+{
+    for(int ii = 0; ii < watch.GetChildCount(); ++ii)
+    {
+        if(static_cast<dbg_mi::Watch&>(*watch.GetChild(ii)).IsFrozen())
+            return true;
+    }
+    return false;
+}
+} // anonymous namespace
+
 void Debugger_GDB_MI::ExpandWatch(cb::shared_ptr<cbWatch> watch)
 {
     if(!IsStopped() || !IsRunning())
@@ -1260,8 +1523,30 @@ void Debugger_GDB_MI::ExpandWatch(cb::shared_ptr<cbWatch> watch)
     if(it != m_watches.end())
     {
         cb::shared_ptr<dbg_mi::Watch> real_watch = cb::static_pointer_cast<dbg_mi::Watch>(watch);
-        if(!real_watch->HasBeenExpanded())
-            m_actions.Add(new dbg_mi::WatchExpandedAction(*it, real_watch, m_watches, m_execution_logger));
+        if(real_watch->IsMorePlaceholder())
+        {
+            // Expanding the placeholder at the end of the children lists the next page of them.
+            cb::shared_ptr<dbg_mi::Watch> parent = cb::static_pointer_cast<dbg_mi::Watch>(watch->GetParent());
+            if(!parent || real_watch->HasBeenExpanded())
+                return;
+            real_watch->SetHasBeenExpanded(true);
+
+            int start = parent->GetFetchedRanges().GetFirstMissing();
+            if(!parent->GetFetchedRanges().Contains(start, start + dbg_mi::c_watch_page_size))
+            {
+                m_actions.Add(new dbg_mi::WatchExpandedAction(*it, parent, m_watches, m_execution_logger,
+                                                              start));
+            }
+        }
+        else
+        {
+            if(!real_watch->HasBeenExpanded())
+                m_actions.Add(new dbg_mi::WatchExpandedAction(*it, real_watch, m_watches, m_execution_logger));
+            // The children were frozen while the watch was collapsed and gdb doesn't update them, when they are
+            // listed again. The update thaws them, so it refreshes their values.
+            if(!(*it)->ForTooltip() && HasFrozenChildren(*real_watch))
+                m_actions.Add(new dbg_mi::WatchesUpdateAction(m_watches, m_execution_logger));
+        }
     }
 }
 
@@ -1340,6 +1625,34 @@ bool Debugger_GDB_MI::IsAttachedToProcess() const
     return m_pid_attached != 0;
 }
 
+namespace
+{
+struct Switcher : dbg_mi::SwitchToFrameInvoker
+{
+    Switcher(Debugger_GDB_MI *plugin, dbg_mi::ActionsMap &actions) :
+        m_plugin(plugin),
+        m_actions(actions)
+    {
+    }
+
+    virtual void Invoke(int frame_number)
+    {
+        typedef dbg_mi::SwitchToFrame<SwitchToFrameNotification> SwitchType;
+        m_actions.Add(new SwitchType(frame_number, SwitchToFrameNotification(m_plugin), false));
+    }
+
+    Debugger_GDB_MI *m_plugin;
+    dbg_mi::ActionsMap &m_actions;
+};
+} // anonymous namespace
+
+void Debugger_GDB_MI::LoadBacktrace(int first_frame)
+{
+    Switcher *switcher = new Switcher(this, m_actions);
+    AddRefreshAction(new dbg_mi::GenerateBacktrace(switcher, m_backtrace, m_backtrace_cache, m_current_frame,
+                                                   m_execution_logger, first_frame));
+}
+
 void Debugger_GDB_MI::RequestUpdate(DebugWindows window)
 {
     if(!IsStopped())
@@ -1348,32 +1661,12 @@ void Debugger_GDB_MI::RequestUpdate(DebugWindows window)
     switch(window)
     {
     case Backtrace:
-        {
-            struct Switcher : dbg_mi::SwitchToFrameInvoker
-            {
-                Switcher(Debugger_GDB_MI *plugin, dbg_mi::ActionsMap &actions) :
-                    m_plugin(plugin),
-                    m_actions(actions)
-                {
-                }
-
-                virtual void Invoke(int frame_number)
-                {
-                    typedef dbg_mi::SwitchToFrame<SwitchToFrameNotification> SwitchType;
-                    m_actions.Add(new SwitchType(frame_number, SwitchToFrameNotification(m_plugin), false));
-                }
-
-                Debugger_GDB_MI *m_plugin;
-                dbg_mi::ActionsMap &m_actions;
-            };
-
-            Switcher *switcher = new Switcher(this, m_actions);
-            m_actions.Add(new dbg_mi::GenerateBacktrace(switcher, m_backtrace, m_current_frame, m_execution_logger));
-        }
+        LoadBacktrace(0);
         break;
 
     case Threads:
-        m_actions.Add(new dbg_mi::GenerateThreadsList(m_threads, m_current_frame.GetThreadId(), m_execution_logger));
+        AddRefreshAction(new dbg_mi::GenerateThreadsList(m_threads, m_current_frame.GetThreadId(),
+                                                         m_execution_logger));
         break;
     }
 }
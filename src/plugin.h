@@ -17,6 +17,7 @@
     #include <wx/wx.h>
 #endif
 
+#include <algorithm>
 #include <tr1/memory>
 #include <cbplugin.h> // for "class cbPlugin"
 
@@ -148,18 +149,26 @@ class Debugger_GDB_MI : public cbDebuggerPlugin
         void UpdateWhenStopped();
         void UpdateOnFrameChanged(bool wait);
         dbg_mi::CurrentFrame& GetCurrentFrame() { return m_current_frame; }
+        dbg_mi::ThreadsContainer& GetThreadsContainer() { return m_threads; }
+        dbg_mi::BacktraceCache& GetBacktraceCache() { return m_backtrace_cache; }
+        dbg_mi::BreakpointsContainer& GetBreakpoints() { return m_breakpoints; }
+        void MarkHitCountsChanged() { m_hit_counts_changed = true; }
+        /// The generation of the last run command, which gdb has accepted; the next stop is caused by it.
+        void SetRunGeneration(int generation) { m_run_generation = generation; }
+        void ShowThreadsSnapshot(wxString const &report);
 
         dbg_mi::GDBExecutor& GetGDBExecutor() { return m_executor; }
     private:
         DECLARE_EVENT_TABLE();
 
-        void OnGDBOutput(wxCommandEvent& event);
+        void OnGDBOutputReady(wxCommandEvent& event);
         void OnGDBTerminated(wxCommandEvent& event);
 
-        void OnTimer(wxTimerEvent& event);
         void OnIdle(wxIdleEvent& event);
 
         void OnMenuInfoCommandStream(wxCommandEvent& event);
+        void OnMenuInfoPerformance(wxCommandEvent& event);
+        void OnMenuInfoThreadsSnapshot(wxCommandEvent& event);
 
         int LaunchDebugger(wxString const &debugger, wxString const &debuggee, wxString const &args,
                            wxString const &working_dir, int pid, bool console, StartType start_type);
@@ -168,19 +177,28 @@ class Debugger_GDB_MI : public cbDebuggerPlugin
         void AddStringCommand(wxString const &command);
         void DoSendCommand(const wxString& cmd);
         void RunQueue();
-        void ParseOutput(wxString const &str);
 
         bool SelectCompiler(cbProject &project, Compiler *&compiler,
                             ProjectBuildTarget *&target, long pid_to_attach);
         int StartDebugger(cbProject *project, StartType startType);
         void CommitBreakpoints(bool force);
-        void CommitRunCommand(wxString const &command);
+        void CommitRunCommand(wxString const &command, bool all_threads = false);
+        /// In all-stop mode gdb accepts commands only while the debuggee is stopped, so it is interrupted for a moment.
+        bool MustInterrupt() const { return !m_executor.IsStopped() && !m_executor.IsNonStop(); }
         void CommitWatches();
+        void LoadBacktrace(int first_frame);
+        /// Adds an action, which refreshes the UI for the current stop. It is canceled, if a run command is queued.
+        void AddRefreshAction(dbg_mi::Action *action);
+        /// Deletes the varobjs of the watches and removes the watches.
+        void DeleteWatches(dbg_mi::TooltipCache::Watches const &watches);
+        /// Creates the varobjs of the identifiers near the current line, so their tooltips are shown at once.
+        void PrefetchTooltips();
+        /// The frame, in which the tooltips are evaluated; before the backtrace is loaded it is the top one.
+        int GetTooltipFrame() const { return std::max(m_current_frame.GetStackFrame(), 0); }
 
         void KillConsole();
 
     private:
-        wxTimer m_timer_poll_debugger;
         cbProject *m_project;
 
         dbg_mi::GDBExecutor m_executor;
@@ -189,18 +207,23 @@ class Debugger_GDB_MI : public cbDebuggerPlugin
 
         typedef std::vector<cb::shared_ptr<dbg_mi::Breakpoint> > Breakpoints;
 
-        Breakpoints m_breakpoints;
+        dbg_mi::BreakpointsContainer m_breakpoints;
         Breakpoints m_temporary_breakpoints;
         dbg_mi::BacktraceContainer m_backtrace;
+        dbg_mi::BacktraceCache m_backtrace_cache;
         dbg_mi::ThreadsContainer m_threads;
         dbg_mi::WatchesContainer m_watches;
 
         dbg_mi::TextInfoWindow *m_command_stream_dialog;
+        dbg_mi::TextInfoWindow *m_performance_dialog;
+        dbg_mi::TextInfoWindow *m_threads_snapshot_dialog;
 
         dbg_mi::CurrentFrame m_current_frame;
         int m_exit_code;
         int m_console_pid;
         int m_pid_attached;
+        int m_run_generation;
         bool m_hasStartUpError;
+        bool m_hit_counts_changed;
 };
 #endif // _DEBUGGER_GDB_MI_PLUGIN_H_
@@ -0,0 +1,56 @@
+#ifndef _DEBUGGER_GDB_MI_SPSC_QUEUE_H_
+#define _DEBUGGER_GDB_MI_SPSC_QUEUE_H_
+
+namespace dbg_mi
+{
+
+/// Bounded lock-free queue for exactly one producer thread and one consumer thread.
+/// Push must be called only by the producer and Pop only by the consumer; Capacity must be a power of two.
+template<typename T, unsigned Capacity>
+class SPSCQueue
+{
+    SPSCQueue(SPSCQueue const &);
+    SPSCQueue& operator =(SPSCQueue const &);
+public:
+    SPSCQueue() : m_head(0), m_tail(0) {}
+
+    /// Returns false if the queue is full.
+    bool Push(T const &value)
+    {
+        unsigned const tail = m_tail;
+        if(tail - __atomic_load_n(&m_head, __ATOMIC_ACQUIRE) == Capacity)
+            return false;
+
+        m_items[tail & (Capacity - 1)] = value;
+        // the item must be written before the consumer can see the new tail
+        __atomic_store_n(&m_tail, tail + 1, __ATOMIC_RELEASE);
+        return true;
+    }
+
+    /// Returns false if the queue is empty.
+    bool Pop(T &value)
+    {
+        unsigned const head = m_head;
+        if(__atomic_load_n(&m_tail, __ATOMIC_ACQUIRE) == head)
+            return false;
+
+        value = m_items[head & (Capacity - 1)];
+        // the item must be read before the producer can reuse its slot
+        __atomic_store_n(&m_head, head + 1, __ATOMIC_RELEASE);
+        return true;
+    }
+
+    bool Empty() const
+    {
+        return __atomic_load_n(&m_tail, __ATOMIC_ACQUIRE) == __atomic_load_n(&m_head, __ATOMIC_ACQUIRE);
+    }
+private:
+    T m_items[Capacity];
+    // the indices grow without bounds and wrap around, only their difference matters
+    unsigned m_head;
+    unsigned m_tail;
+};
+
+} // namespace dbg_mi
+
+#endif // _DEBUGGER_GDB_MI_SPSC_QUEUE_H_
@@ -0,0 +1,132 @@
+#include "threads_snapshot.h"
+
+#include <algorithm>
+#include <stdint.h>
+
+#include "cmd_result_parser.h"
+#include "frame.h"
+
+namespace dbg_mi
+{
+
+namespace
+{
+wxString MakeFrameLine(int level, Frame const &frame)
+{
+    wxString line = wxString::Format(wxT("#%-3d 0x%016lx in %s"), level, frame.GetAddress(),
+                                     frame.GetFunction().c_str());
+    if(frame.HasValidSource())
+        line += wxString::Format(wxT(" at %s:%d"), frame.GetFilename().c_str(), frame.GetLine());
+    else if(!frame.GetFrom().empty())
+        line += wxT(" from ") + frame.GetFrom();
+    return line;
+}
+
+struct MoreThreads
+{
+    bool operator()(ThreadsSnapshot::Group const &a, ThreadsSnapshot::Group const &b) const
+    {
+        return a.threads.size() > b.threads.size();
+    }
+};
+
+/// Formats the sorted thread ids as ranges: "1-4, 7, 9-12".
+wxString MakeThreadRanges(std::vector<int> const &ids)
+{
+    wxString ranges;
+    for(size_t start = 0; start < ids.size();)
+    {
+        size_t end = start + 1;
+        while(end < ids.size() && ids[end] == ids[end - 1] + 1)
+            ++end;
+
+        if(!ranges.empty())
+            ranges += wxT(", ");
+        if(end - start == 1)
+            ranges += wxString::Format(wxT("%d"), ids[start]);
+        else
+            ranges += wxString::Format(wxT("%d-%d"), ids[start], ids[end - 1]);
+        start = end;
+    }
+    return ranges;
+}
+} // anonymous namespace
+
+size_t ThreadsSnapshot::AddressesHash::operator()(Addresses const &addresses) const
+{
+    // FNV-1a over the addresses
+    uint64_t hash = 14695981039346656037ULL;
+    for(Addresses::const_iterator it = addresses.begin(); it != addresses.end(); ++it)
+    {
+        hash ^= *it;
+        hash *= 1099511628211ULL;
+    }
+    return static_cast<size_t>(hash);
+}
+
+bool ThreadsSnapshot::AddThread(int thread_id, ResultValue const &output)
+{
+    ResultValue const *stack = output.GetTupleValue(wxT("stack"));
+    if(!stack)
+        return false;
+
+    int const size = stack->GetTupleSize();
+    Addresses addresses;
+    addresses.reserve(size);
+    std::vector<Frame> frames(size);
+    for(int ii = 0; ii < size; ++ii)
+    {
+        ResultValue const *frame_value = stack->GetTupleValueByIndex(ii);
+        frames[ii].ParseFrame(*frame_value);
+        addresses.push_back(frames[ii].GetAddress());
+    }
+
+    ++m_thread_count;
+    std::pair<GroupIndex::iterator, bool> inserted;
+    inserted = m_index.insert(GroupIndex::value_type(addresses, static_cast<int>(m_groups.size())));
+    if(inserted.second)
+    {
+        // the frames are formatted only for the first thread in the stack
+        m_groups.push_back(Group());
+        Group &group = m_groups.back();
+        group.frames.reserve(size);
+        for(int ii = 0; ii < size; ++ii)
+            group.frames.push_back(MakeFrameLine(ii, frames[ii]));
+    }
+    m_groups[inserted.first->second].threads.push_back(thread_id);
+    return true;
+}
+
+ThreadsSnapshot::Groups ThreadsSnapshot::GetGroups() const
+{
+    Groups groups(m_groups);
+    std::stable_sort(groups.begin(), groups.end(), MoreThreads());
+    for(Groups::iterator it = groups.begin(); it != groups.end(); ++it)
+        std::sort(it->threads.begin(), it->threads.end());
+    return groups;
+}
+
+wxString ThreadsSnapshot::MakeReport() const
+{
+    wxString report = wxString::Format(wxT("%d threads in %d different stacks\n"),
+                                       m_thread_count, static_cast<int>(m_groups.size()));
+
+    Groups const groups = GetGroups();
+    for(Groups::const_iterator it = groups.begin(); it != groups.end(); ++it)
+    {
+        report += wxString::Format(wxT("\n%d threads in this stack: "), static_cast<int>(it->threads.size()));
+        report += MakeThreadRanges(it->threads) + wxT("\n");
+        for(std::vector<wxString>::const_iterator frame = it->frames.begin(); frame != it->frames.end(); ++frame)
+            report += *frame + wxT("\n");
+    }
+    return report;
+}
+
+void ThreadsSnapshot::Clear()
+{
+    m_groups.clear();
+    m_index.clear();
+    m_thread_count = 0;
+}
+
+} // namespace dbg_mi
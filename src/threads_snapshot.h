@@ -0,0 +1,54 @@
+#ifndef _DEBUGGER_GDB_MI_THREADS_SNAPSHOT_H_
+#define _DEBUGGER_GDB_MI_THREADS_SNAPSHOT_H_
+
+#include <vector>
+#include <tr1/unordered_map>
+
+#include <wx/string.h>
+
+namespace dbg_mi
+{
+
+class ResultValue;
+
+/// The stacks of all threads of the debuggee. The threads with identical stacks are grouped the way pstack and
+/// eu-stack aggregate them, so a deadlock in a large thread pool shows up as a few groups instead of thousands of
+/// backtraces. Two stacks are identical if their frames have the same addresses.
+class ThreadsSnapshot
+{
+public:
+    struct Group
+    {
+        std::vector<int> threads;
+        /// The frames of the first thread of the group, one line per frame.
+        std::vector<wxString> frames;
+    };
+    typedef std::vector<Group> Groups;
+public:
+    ThreadsSnapshot() : m_thread_count(0) {}
+
+    /// Adds the stack of a thread from the output of -stack-list-frames; returns false if there is no stack in it.
+    bool AddThread(int thread_id, ResultValue const &output);
+
+    int GetThreadCount() const { return m_thread_count; }
+    /// Returns the groups sorted by the number of their threads, the largest group first.
+    Groups GetGroups() const;
+    wxString MakeReport() const;
+    void Clear();
+private:
+    typedef std::vector<unsigned long> Addresses;
+
+    struct AddressesHash
+    {
+        size_t operator()(Addresses const &addresses) const;
+    };
+    typedef std::tr1::unordered_map<Addresses, int, AddressesHash> GroupIndex;
+private:
+    Groups m_groups;
+    GroupIndex m_index;
+    int m_thread_count;
+};
+
+} // namespace dbg_mi
+
+#endif // _DEBUGGER_GDB_MI_THREADS_SNAPSHOT_H_
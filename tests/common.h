@@ -3,6 +3,8 @@
 
 #include <wx/string.h>
 
+#include "cmd_result_parser.h"
+
 inline std::ostream& operator<<(std::ostream &stream, wxString const &s)
 {
     return stream << s.utf8_str().data();
@@ -13,6 +15,15 @@ inline std::ostream& operator<<(std::ostream &stream, wxChar const *s)
     return stream << wxString(s).utf8_str().data();
 }
 
+/// Parses a line of gdb output, the parser is empty if the line isn't valid.
+inline dbg_mi::ResultParser MakeParser(wxString const &str)
+{
+    dbg_mi::ResultParser p;
+    if (!p.Parse(str))
+        return dbg_mi::ResultParser();
+    return p;
+}
+
 
 class cbWatch;
 std::ostream& operator<<(std::ostream &stream, cbWatch const &w);
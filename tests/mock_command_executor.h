@@ -9,6 +9,8 @@ class MockCommandExecutor : public dbg_mi::CommandExecutor
 {
 public:
     MockCommandExecutor(bool auto_process_output = true) :
+        m_timestamp(0),
+        m_flush_count(0),
         m_auto_process_output(auto_process_output),
         m_has_been_cleared(false)
     {
@@ -17,29 +19,30 @@ public:
     virtual wxString GetOutput() { return m_result; }
 
     bool HasBeenCleared() const { return m_has_been_cleared; }
+    int GetFlushCount() const { return m_flush_count; }
+    void SetTimestamp(int64_t timestamp) { m_timestamp = timestamp; }
 
 protected:
     bool DoExecute(dbg_mi::CommandID const &id, wxString const &cmd)
     {
-        Result r;
-        r.id = id;
+        wxString output;
         if(cmd == wxT("-exec-run"))
         {
-            r.output = wxT("^running");
+            output = wxT("^running");
         }
         else if(cmd.StartsWith(wxT("-break-insert")))
         {
-            r.output = wxT("^done,bkpt={number=\"1\",addr=\"0x0001072c\",file=\"main.cpp\",")
-                       wxT("fullname=\"/home/foo/main.cpp\",line=\"4\",times=\"0\"}");
+            output = wxT("^done,bkpt={number=\"1\",addr=\"0x0001072c\",file=\"main.cpp\",")
+                     wxT("fullname=\"/home/foo/main.cpp\",line=\"4\",times=\"0\"}");
 
         }
 
-        if(!r.output.empty())
+        if(!output.empty())
         {
             if(m_auto_process_output)
             {
-                ProcessOutput(r.id.ToString() + r.output);
-                m_result = r.id.ToString() + r.output;
+                ProcessOutput(id.ToString() + output);
+                m_result = id.ToString() + output;
             }
             return true;
         }
@@ -51,8 +54,15 @@ protected:
     {
         m_has_been_cleared = true;
     }
+    virtual void DoFlush()
+    {
+        ++m_flush_count;
+    }
+    virtual int64_t GetTimestamp() const { return m_timestamp; }
 private:
     wxString m_result;
+    int64_t m_timestamp;
+    int m_flush_count;
 
     bool m_auto_process_output;
     bool m_has_been_cleared;
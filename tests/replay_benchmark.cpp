@@ -0,0 +1,762 @@
+// Replays a recorded debugging session through ActionsMap and DispatchResults, without gdb and without the GUI.
+//
+// usage: replay_benchmark <debug log> [repeat]
+//        replay_benchmark <command stream> <gdb output> [repeat]
+//        replay_benchmark --synthetic
+//
+// The debug log is the content of the "GDB/MI debug" log pane, it contains both the commands and the output.
+// The command stream is the content of the "Command stream" window and the output is the raw output of gdb.
+//
+// Every stop is refreshed by the real actions like in the plugin: GenerateBacktrace, GenerateThreadsList and
+// WatchesUpdateAction, if the recorded session has their commands. The recorded watches are created by
+// WatchCreateAction and expanded by WatchExpandedAction. The other commands (run, step, breakpoints and so on) are
+// executed by generic actions, which ignore their results. Like the tests it is built with TEST_PROJECT, so the
+// actions don't touch the debugger windows.
+//
+// The synthetic benchmarks measure single operations on generated input; they are kept out of the unit tests, so the
+// tests stay quiet and fast.
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <deque>
+#include <fstream>
+#include <map>
+#include <new>
+#include <string>
+#include <vector>
+
+#include "actions.h"
+#include "frame.h"
+#include "replay_command_executor.h"
+#include "updated_variable.h"
+
+namespace
+{
+size_t g_allocations = 0;
+size_t g_allocated_bytes = 0;
+} // anonymous namespace
+
+// The replaced delete operators aren't inlined, otherwise gcc sees free() called on memory from operator new and warns
+// with -Wmismatched-new-delete.
+#if defined(__GNUC__)
+    #define REPLAY_NOINLINE __attribute__((noinline))
+#else
+    #define REPLAY_NOINLINE
+#endif
+
+void* operator new(size_t size)
+{
+    ++g_allocations;
+    g_allocated_bytes += size;
+    void *p = std::malloc(size > 0 ? size : 1);
+    if(!p)
+        throw std::bad_alloc();
+    return p;
+}
+
+void* operator new[](size_t size)
+{
+    return operator new(size);
+}
+
+REPLAY_NOINLINE void operator delete(void *p) throw()
+{
+    std::free(p);
+}
+
+REPLAY_NOINLINE void operator delete[](void *p) throw()
+{
+    std::free(p);
+}
+
+void operator delete(void *p, size_t /*size*/) throw()
+{
+    operator delete(p);
+}
+
+void operator delete[](void *p, size_t /*size*/) throw()
+{
+    operator delete[](p);
+}
+
+namespace
+{
+
+/// Executes the commands of one recorded action and finishes when all their results have arrived.
+class ReplayAction : public dbg_mi::Action
+{
+public:
+    ReplayAction() : m_results_left(0) {}
+
+    void AddCommand(wxString const &command) { m_commands.push_back(command); }
+
+    virtual void OnCommandOutput(dbg_mi::CommandID const &/*id*/, dbg_mi::ResultParser const &/*result*/)
+    {
+        if(--m_results_left == 0)
+            Finish();
+    }
+protected:
+    virtual void OnStart()
+    {
+        for(Commands::const_iterator it = m_commands.begin(); it != m_commands.end(); ++it)
+            Execute(*it);
+        m_results_left = m_commands.size();
+        if(m_results_left == 0)
+            Finish();
+    }
+private:
+    typedef std::vector<wxString> Commands;
+    Commands m_commands;
+    int m_results_left;
+};
+
+/// The output of the replayed actions isn't shown anywhere.
+class NullLogger : public dbg_mi::Logger
+{
+public:
+    virtual void Log(wxString const &/*line*/, Log::Type /*type*/) {}
+    virtual void Debug(wxString const &/*line*/, Line::Type /*type*/) {}
+    virtual Line const* GetDebugLine(int /*index*/) const { return NULL; }
+
+    virtual void AddCommand(wxString const &/*command*/) {}
+    virtual int GetCommandCount() const { return 0; }
+    virtual wxString const& GetCommand(int /*index*/) const { return m_empty; }
+    virtual void ClearCommand() {}
+private:
+    wxString m_empty;
+};
+
+/// The windows of the debugger, which are refreshed by the replayed actions.
+struct Session
+{
+    Session() : refresh_backtrace(false), refresh_threads(false), created_watches(0), expanded_watches(0) {}
+
+    dbg_mi::BacktraceContainer backtrace;
+    dbg_mi::BacktraceCache backtrace_cache;
+    dbg_mi::CurrentFrame current_frame;
+    dbg_mi::ThreadsContainer threads;
+    dbg_mi::WatchesContainer watches;
+    NullLogger logger;
+
+    /// The windows, which were shown in the recorded session.
+    bool refresh_backtrace, refresh_threads;
+    /// The varobjs expanded in the recorded session, in the order of the expansions.
+    std::deque<wxString> expansions;
+    int created_watches, expanded_watches;
+};
+
+struct IgnoreSwitchToFrame
+{
+    void operator()(dbg_mi::ResultParser const &/*result*/, int /*frame*/, bool /*user_action*/) {}
+};
+
+class Switcher : public dbg_mi::SwitchToFrameInvoker
+{
+public:
+    explicit Switcher(dbg_mi::ActionsMap &actions) : m_actions(actions) {}
+
+    virtual void Invoke(int frame_number)
+    {
+        m_actions.Add(new dbg_mi::SwitchToFrame<IgnoreSwitchToFrame>(frame_number, IgnoreSwitchToFrame(), false));
+    }
+private:
+    dbg_mi::ActionsMap &m_actions;
+};
+
+/// Handles the notifications like the plugin does: every stop refreshes the backtrace, the threads and the watches.
+struct OnNotify
+{
+    OnNotify(Session &session, dbg_mi::ActionsMap &actions) :
+        notifications(0),
+        stops(0),
+        m_session(session),
+        m_actions(actions)
+    {
+    }
+
+    void operator()(dbg_mi::ResultParser const &parser)
+    {
+        ++notifications;
+        dbg_mi::ResultValue const &value = parser.GetResultValue();
+        int id;
+        if(parser.GetResultType() == dbg_mi::ResultParser::NotifyAsyncOutput)
+        {
+            if(parser.GetAsyncNotifyType() == wxT("thread-created") && dbg_mi::Lookup(value, wxT("id"), id))
+                m_session.threads.Add(id);
+            else if(parser.GetAsyncNotifyType() == wxT("thread-exited") && dbg_mi::Lookup(value, wxT("id"), id))
+                m_session.threads.Remove(id);
+            return;
+        }
+        if(parser.GetResultClass() != dbg_mi::ResultParser::ClassStopped)
+            return;
+
+        ++stops;
+        dbg_mi::StoppedReason const reason = dbg_mi::StoppedReason::Parse(value);
+        switch(reason.GetType())
+        {
+        case dbg_mi::StoppedReason::ExitedNormally:
+        case dbg_mi::StoppedReason::ExitedSignalled:
+        case dbg_mi::StoppedReason::Exited:
+            return;
+        default:
+            break;
+        }
+
+        m_session.backtrace_cache.OnStop(reason.GetType() == dbg_mi::StoppedReason::EndSteppingRange);
+        if(dbg_mi::Lookup(value, wxT("thread-id"), id))
+            m_session.current_frame.SetThreadId(id);
+        m_session.threads.MarkFramesAsStale();
+
+        if(m_session.refresh_backtrace)
+        {
+            m_actions.Add(new dbg_mi::GenerateBacktrace(new Switcher(m_actions), m_session.backtrace,
+                                                        m_session.backtrace_cache, m_session.current_frame,
+                                                        m_session.logger));
+        }
+        if(m_session.refresh_threads)
+        {
+            m_actions.Add(new dbg_mi::GenerateThreadsList(m_session.threads, m_session.current_frame.GetThreadId(),
+                                                          m_session.logger));
+        }
+        if(!m_session.watches.empty())
+            m_actions.Add(new dbg_mi::WatchesUpdateAction(m_session.watches, m_session.logger));
+    }
+
+    int notifications;
+    int stops;
+private:
+    Session &m_session;
+    dbg_mi::ActionsMap &m_actions;
+};
+
+bool Load(ReplayCommandExecutor &exec, std::vector<char const*> const &files)
+{
+    if(files.size() == 1)
+    {
+        std::ifstream log(files[0], std::ios::binary);
+        if(!log)
+            return false;
+        exec.LoadDebugLog(log);
+        return true;
+    }
+
+    std::ifstream commands(files[0], std::ios::binary), output(files[1], std::ios::binary);
+    if(!commands || !output)
+        return false;
+
+    std::string line;
+    while(std::getline(commands, line))
+        exec.AddCommand(line);
+    while(std::getline(output, line))
+        exec.AddOutput(line);
+    return true;
+}
+
+/// The frames of the other threads are listed by the threads snapshot, which isn't replayed.
+bool IsBacktraceCommand(wxString const &command)
+{
+    return command.StartsWith(wxT("-stack-list-frames ")) && !command.StartsWith(wxT("-stack-list-frames --thread"));
+}
+
+/// True for the commands, which are executed by the actions refreshing a stop.
+bool IsRefreshCommand(wxString const &command)
+{
+    static wxChar const *prefixes[] = {
+        wxT("-stack-info-frame"), wxT("-stack-info-depth"), wxT("-stack-list-arguments "),
+        wxT("-stack-select-frame "), wxT("-thread-list-ids"), wxT("-thread-info "), wxT("-var-create "),
+        wxT("-var-list-children "), wxT("-var-update "), wxT("-var-set-frozen "), wxT("-var-set-update-range ")
+    };
+    for(size_t ii = 0; ii < sizeof(prefixes) / sizeof(prefixes[0]); ++ii)
+    {
+        if(command.StartsWith(prefixes[ii]))
+            return true;
+    }
+    return IsBacktraceCommand(command);
+}
+
+/// The commands of a recorded action are replayed by one action; the plugin's own commands have the action id 0,
+/// each of them gets an action. The commands of the refresh actions are left to the real actions, the recorded
+/// watches are created by WatchCreateAction.
+void AddActions(dbg_mi::ActionsMap &actions, Session &session,
+                ReplayCommandExecutor::RecordedCommands const &commands)
+{
+    ReplayAction *action = NULL;
+    int last_action = -1;
+    wxString const create_prefix(wxT("-var-create - @ \""));
+    for(ReplayCommandExecutor::RecordedCommands::const_iterator it = commands.begin(); it != commands.end(); ++it)
+    {
+        bool const new_action = it->action == 0 || it->action != last_action;
+        last_action = it->action;
+        wxString const &command = it->command;
+        wxString rest;
+        if(IsBacktraceCommand(command))
+            session.refresh_backtrace = true;
+        else if(command.StartsWith(wxT("-thread-info ")) || command.StartsWith(wxT("-thread-list-ids")))
+            session.refresh_threads = true;
+        else if(command.StartsWith(create_prefix, &rest) && rest.EndsWith(wxT("\"")))
+        {
+            wxString symbol = rest.Left(rest.length() - 1);
+            symbol.Replace(wxT("\\\""), wxT("\""));
+            cb::shared_ptr<dbg_mi::Watch> watch(new dbg_mi::Watch(symbol, false));
+            session.watches.push_back(watch);
+            actions.Add(new dbg_mi::WatchCreateAction(watch, session.watches, session.logger));
+            ++session.created_watches;
+        }
+        // WatchExpandedAction starts with the update of the expanded varobj
+        else if(new_action && command.StartsWith(wxT("-var-update "), &rest) && !rest.StartsWith(wxT("1 ")))
+            session.expansions.push_back(rest);
+
+        if(IsRefreshCommand(command))
+            continue;
+        if(!action || new_action)
+        {
+            action = new ReplayAction;
+            actions.Add(action);
+        }
+        action->AddCommand(command);
+    }
+}
+
+/// Expands the recorded watches, whose varobjs have been created.
+void ExpandWatches(dbg_mi::ActionsMap &actions, Session &session)
+{
+    while(!session.expansions.empty())
+    {
+        cb::shared_ptr<dbg_mi::Watch> watch = session.watches.Find(session.expansions.front());
+        if(!watch)
+            break;
+        session.expansions.pop_front();
+        watch->Expand(true);
+        cb::shared_ptr<dbg_mi::Watch> root = cb::static_pointer_cast<dbg_mi::Watch>(cbGetRootWatch(watch));
+        actions.Add(new dbg_mi::WatchExpandedAction(root, watch, session.watches, session.logger));
+        ++session.expanded_watches;
+    }
+}
+
+double ElapsedMs(std::clock_t start)
+{
+    return (std::clock() - start) * 1000.0 / CLOCKS_PER_SEC;
+}
+
+std::string MakeWideTuple(int count)
+{
+    std::string s;
+    char buf[64];
+    for(int ii = 0; ii < count; ++ii)
+    {
+        std::sprintf(buf, "%svar%d=\"%d\"", ii > 0 ? "," : "", ii, ii);
+        s += buf;
+    }
+    return s;
+}
+
+/// A value of the tree before the arena: the tuples were vectors of separately allocated values.
+struct OldValue
+{
+    wxString name;
+    wxString simple;
+};
+
+/// The search of the old GetTupleValue: the key was checked for a dot and then compared as a C string with every
+/// name, like the old FindTupleValue(wxChar const *name) did. The benchmarks have no dotted keys.
+OldValue const* OldGetTupleValue(std::vector<OldValue*> const &tuple, wxString const &key)
+{
+    if(key.find(wxT('.')) != wxString::npos)
+        return NULL;
+    wxChar const *name = static_cast<wxChar const*>(key.c_str());
+    for(size_t ii = 0; ii < tuple.size(); ++ii)
+    {
+        if(tuple[ii]->name == name)
+            return tuple[ii];
+    }
+    return NULL;
+}
+
+std::vector<OldValue*> MakeOldTuple(dbg_mi::ResultValue const &tuple)
+{
+    std::vector<OldValue*> result;
+    for(int ii = 0; ii < tuple.GetTupleSize(); ++ii)
+    {
+        dbg_mi::ResultValue const &value = *tuple.GetTupleValueByIndex(ii);
+        OldValue *old_value = new OldValue;
+        old_value->name = value.GetName();
+        if(value.GetType() == dbg_mi::ResultValue::Simple)
+            old_value->simple = value.GetSimpleValue();
+        result.push_back(old_value);
+    }
+    return result;
+}
+
+void DeleteOldTuple(std::vector<OldValue*> &tuple)
+{
+    for(size_t ii = 0; ii < tuple.size(); ++ii)
+        delete tuple[ii];
+    tuple.clear();
+}
+
+/// Looks up every name of tuples of growing width. The old search runs on a copy of the tuple in the old layout,
+/// built before the timing. The narrow tuples are searched linearly in the arena too, the wide ones through the index.
+void BenchmarkTupleLookup()
+{
+    std::printf("tuple lookup: every name looked up, ms per 100000 lookups\n");
+    std::printf("  %8s %14s %14s\n", "values", "old wxString", "arena");
+    int const widths[] = { 4, 8, 15, 16, 64, 1024, 10000 };
+    for(size_t ww = 0; ww < sizeof(widths) / sizeof(widths[0]); ++ww)
+    {
+        int const width = widths[ww];
+        std::string const tuple = MakeWideTuple(width);
+        dbg_mi::ResultValue result;
+        if(!dbg_mi::ParseValue(tuple.c_str(), tuple.length(), result))
+        {
+            std::fprintf(stderr, "can't parse the tuple\n");
+            return;
+        }
+        std::vector<wxString> keys;
+        for(int ii = 0; ii < width; ++ii)
+            keys.push_back(wxString::Format(wxT("var%d"), ii));
+        std::vector<OldValue*> old_tuple = MakeOldTuple(result);
+        int const rounds = std::max(1, 100000 / width);
+
+        int found_old = 0;
+        std::clock_t start = std::clock();
+        for(int round = 0; round < rounds; ++round)
+        {
+            for(int ii = 0; ii < width; ++ii)
+            {
+                if(OldGetTupleValue(old_tuple, keys[ii]))
+                    ++found_old;
+            }
+        }
+        double const old_ms = ElapsedMs(start);
+        DeleteOldTuple(old_tuple);
+
+        int found_arena = 0;
+        start = std::clock();
+        for(int round = 0; round < rounds; ++round)
+        {
+            for(int ii = 0; ii < width; ++ii)
+            {
+                if(result.GetTupleValue(keys[ii]))
+                    ++found_arena;
+            }
+        }
+        double const arena_ms = ElapsedMs(start);
+
+        double const scale = 100000.0 / (double(rounds) * width);
+        std::printf("  %8d %14.3f %14.3f%s\n", width, old_ms * scale, arena_ms * scale,
+                    found_old == found_arena && found_arena == rounds * width ? "" : "  (lookups failed)");
+    }
+}
+
+/// Parses a -var-update changelist with 10000 entries and reads every entry with UpdatedVariable::Parse and
+/// ParseWatchInfo. Their lookups are timed against the old search too.
+void BenchmarkChangelist()
+{
+    int const count = 10000;
+    std::string changelist("changelist=[");
+    char buf[256];
+    for(int ii = 0; ii < count; ++ii)
+    {
+        std::sprintf(buf, "%s{name=\"var1.public.m_%d\",value=\"%d\",in_scope=\"true\","
+                     "type_changed=\"false\",has_more=\"0\"}", ii > 0 ? "," : "", ii, ii);
+        changelist += buf;
+    }
+    changelist += "]";
+
+    std::clock_t start = std::clock();
+    dbg_mi::ResultValue result;
+    dbg_mi::ResultValue const *list = NULL;
+    if(dbg_mi::ParseValue(changelist.c_str(), changelist.length(), result))
+        list = result.GetTupleValue(wxT("changelist"));
+    double const parse_ms = ElapsedMs(start);
+    if(!list || list->GetTupleSize() != count)
+    {
+        std::fprintf(stderr, "can't parse the changelist\n");
+        return;
+    }
+
+    int parsed = 0;
+    start = std::clock();
+    for(int ii = 0; ii < count; ++ii)
+    {
+        dbg_mi::ResultValue const &entry = *list->GetTupleValueByIndex(ii);
+        dbg_mi::UpdatedVariable var;
+        int children;
+        bool dynamic, has_more;
+        if(var.Parse(entry))
+            ++parsed;
+        dbg_mi::ParseWatchInfo(entry, children, dynamic, has_more);
+    }
+    double const read_ms = ElapsedMs(start);
+
+    // the names UpdatedVariable::Parse and ParseWatchInfo look up in every entry
+    wxChar const *names[] = { wxT("in_scope"), wxT("name"), wxT("type_changed"), wxT("value"), wxT("new_type"),
+                              wxT("new_num_children"), wxT("has_more"), wxT("dynamic"), wxT("numchild") };
+    int const name_count = sizeof(names) / sizeof(names[0]);
+    std::vector<wxString> keys(names, names + name_count);
+    std::vector<std::vector<OldValue*> > old_entries;
+    for(int ii = 0; ii < count; ++ii)
+        old_entries.push_back(MakeOldTuple(*list->GetTupleValueByIndex(ii)));
+
+    int found_old = 0;
+    start = std::clock();
+    for(int ii = 0; ii < count; ++ii)
+    {
+        for(int jj = 0; jj < name_count; ++jj)
+        {
+            if(OldGetTupleValue(old_entries[ii], keys[jj]))
+                ++found_old;
+        }
+    }
+    double const old_ms = ElapsedMs(start);
+    for(int ii = 0; ii < count; ++ii)
+        DeleteOldTuple(old_entries[ii]);
+
+    int found_arena = 0;
+    start = std::clock();
+    for(int ii = 0; ii < count; ++ii)
+    {
+        dbg_mi::ResultValue const &entry = *list->GetTupleValueByIndex(ii);
+        for(int jj = 0; jj < name_count; ++jj)
+        {
+            if(entry.GetTupleValue(keys[jj]))
+                ++found_arena;
+        }
+    }
+    double const arena_ms = ElapsedMs(start);
+
+    std::printf("changelist: %d entries parsed in %.3f ms, read in %.3f ms%s\n", count, parse_ms, read_ms,
+                parsed == count ? "" : " (entries not parsed)");
+    std::printf("  their %d lookups: old wxString %.3f ms, arena %.3f ms%s\n", count * name_count, old_ms, arena_ms,
+                found_old == found_arena ? "" : " (lookups differ)");
+}
+
+/// Counts the results dispatched to it, it never finishes.
+class CountingAction : public dbg_mi::Action
+{
+public:
+    CountingAction() : count(0) {}
+
+    virtual void OnCommandOutput(dbg_mi::CommandID const &/*id*/, dbg_mi::ResultParser const &/*result*/)
+    {
+        ++count;
+    }
+protected:
+    virtual void OnStart() {}
+public:
+    int count;
+};
+
+struct IgnoreNotifications
+{
+    void operator()(dbg_mi::ResultParser const &/*parser*/) {}
+};
+
+/// Dispatches the results to many live actions, they are found by their id.
+void BenchmarkDispatchResults()
+{
+    int const action_count = 1000;
+    int const result_count = 100000;
+
+    dbg_mi::ActionsMap actions_map;
+    std::vector<CountingAction*> actions;
+    for(int ii = 0; ii < action_count; ++ii)
+    {
+        actions.push_back(new CountingAction);
+        actions_map.Add(actions.back());
+    }
+
+    std::string output;
+    for(int ii = 0; ii < result_count; ++ii)
+    {
+        dbg_mi::CommandID id(actions[(ii * 7919) % action_count]->GetID(), ii);
+        output += id.ToString().utf8_str().data();
+        output += "^done\n";
+    }
+
+    ReplayCommandExecutor exec;
+    IgnoreNotifications on_notify;
+    exec.ProcessOutput(output.c_str(), output.length());
+
+    std::clock_t const start = std::clock();
+    dbg_mi::DispatchResults(exec, actions_map, on_notify);
+    double const ms = ElapsedMs(start);
+
+    int total = 0;
+    for(int ii = 0; ii < action_count; ++ii)
+        total += actions[ii]->count;
+    std::printf("dispatch: %d results to %d actions in %.3f ms%s\n", result_count, action_count, ms,
+                total == result_count ? "" : " (results lost)");
+}
+
+dbg_mi::ResultParser MakeParser(wxString const &str)
+{
+    dbg_mi::ResultParser p;
+    if(!p.Parse(str))
+        return dbg_mi::ResultParser();
+    return p;
+}
+
+/// Expands a watch with 100 children without a type, like the access specifiers of a class. Every one of them is
+/// listed by a separate command and adds 100 children to the watch.
+void BenchmarkExpandRecursive()
+{
+    int const group_count = 100;
+    int const group_size = 100;
+
+    wxString groups = wxString::Format(wxT("^done,numchild=\"%d\",children=["), group_count);
+    std::map<wxString, dbg_mi::ResultParser> outputs;
+    for(int group = 0; group < group_count; ++group)
+    {
+        if(group > 0)
+            groups += wxT(",");
+        groups += wxString::Format(wxT("child={name=\"var1.g%d\",exp=\"g%d\",numchild=\"%d\"}"),
+                                   group, group, group_size);
+
+        wxString children = wxString::Format(wxT("^done,numchild=\"%d\",children=["), group_size);
+        for(int child = 0; child < group_size; ++child)
+        {
+            if(child > 0)
+                children += wxT(",");
+            children += wxString::Format(wxT("child={name=\"var1.g%d.%d\",exp=\"m%d_%d\",numchild=\"0\",")
+                                         wxT("value=\"%d\",type=\"int\"}"), group, child, group, child, child);
+        }
+        children += wxT("],has_more=\"0\"");
+        outputs[wxString::Format(wxT("var1.g%d"), group)] = MakeParser(children);
+    }
+    groups += wxT("],has_more=\"0\"");
+    outputs[wxT("var1")] = MakeParser(groups);
+    dbg_mi::ResultParser const update = MakeParser(wxT("^done,changelist=[]"));
+
+    dbg_mi::WatchesContainer watches;
+    cb::shared_ptr<dbg_mi::Watch> w(new dbg_mi::Watch(wxT("v"), false));
+    w->SetID(wxT("var1"));
+    watches.push_back(w);
+    NullLogger logger;
+    dbg_mi::WatchExpandedAction action(w, w, watches, logger);
+    action.SetID(1);
+
+    std::clock_t const start = std::clock();
+    action.Start();
+    int commands = 0;
+    while(action.HasPendingCommands())
+    {
+        dbg_mi::CommandID id;
+        wxString const command = action.PopPendingCommand(id);
+        ++commands;
+        if(command.StartsWith(wxT("-var-update")))
+        {
+            action.OnCommandOutput(id, update);
+            continue;
+        }
+        wxString const name = command.AfterFirst(wxT('"')).BeforeFirst(wxT('"'));
+        std::map<wxString, dbg_mi::ResultParser>::const_iterator it = outputs.find(name);
+        if(it != outputs.end())
+            action.OnCommandOutput(id, it->second);
+    }
+    double const ms = ElapsedMs(start);
+
+    std::printf("expand: %d children listed by %d commands in %.3f ms%s\n", w->GetChildCount(), commands, ms,
+                action.Finished() && w->GetChildCount() == group_count * group_size ? "" : " (not finished)");
+}
+
+void RunSyntheticBenchmarks()
+{
+    BenchmarkTupleLookup();
+    BenchmarkChangelist();
+    BenchmarkDispatchResults();
+    BenchmarkExpandRecursive();
+}
+
+} // anonymous namespace
+
+int main(int argc, char **argv)
+{
+    if(argc == 2 && std::strcmp(argv[1], "--synthetic") == 0)
+    {
+        RunSyntheticBenchmarks();
+        return 0;
+    }
+
+    std::vector<char const*> files;
+    int repeat = 1;
+    for(int ii = 1; ii < argc; ++ii)
+    {
+        int const n = std::atoi(argv[ii]);
+        if(n > 0 && ii == argc - 1 && ii > 1)
+            repeat = n;
+        else
+            files.push_back(argv[ii]);
+    }
+    if(files.empty() || files.size() > 2)
+    {
+        std::fprintf(stderr, "usage: %s <debug log> [repeat]\n"
+                             "       %s <command stream> <gdb output> [repeat]\n"
+                             "       %s --synthetic\n", argv[0], argv[0], argv[0]);
+        return 1;
+    }
+
+    for(int run = 0; run < repeat; ++run)
+    {
+        ReplayCommandExecutor exec;
+        if(!Load(exec, files))
+        {
+            std::fprintf(stderr, "can't read the recorded session\n");
+            return 1;
+        }
+
+        dbg_mi::ActionsMap actions;
+        Session session;
+        AddActions(actions, session, exec.GetRecordedCommands());
+        OnNotify on_notify(session, actions);
+        int unparsable = 0;
+
+        size_t const allocations = g_allocations;
+        size_t const allocated_bytes = g_allocated_bytes;
+        int64_t const start = exec.GetTimestamp();
+
+        for(;;)
+        {
+            actions.Run(exec);
+            int const fed = exec.Replay();
+            if(!dbg_mi::DispatchResults(exec, actions, on_notify))
+                ++unparsable;
+            ExpandWatches(actions, session);
+
+            if(fed == 0 && !exec.HasOutput())
+            {
+                if(exec.IsFinished())
+                    break;
+                exec.SkipBlockedLine();
+            }
+        }
+
+        double const elapsed = (exec.GetTimestamp() - start) / 1000.0;
+        size_t const run_allocations = g_allocations - allocations;
+        size_t const run_allocated_bytes = g_allocated_bytes - allocated_bytes;
+        int const lines = exec.GetOutputLineCount();
+        double const seconds = elapsed > 0.0 ? elapsed / 1000.0 : 1e-9;
+
+        std::printf("run %d: %d commands, %d output lines, %.1f KB in %.3f ms\n", run + 1,
+                    int(exec.GetRecordedCommands().size()), lines, exec.GetReplayedBytes() / 1024.0, elapsed);
+        std::printf("  throughput: %.0f lines/s, %.2f MB/s\n",
+                    lines / seconds, exec.GetReplayedBytes() / seconds / (1024.0 * 1024.0));
+        std::printf("  stops: %d, %.3f ms per stop\n", on_notify.stops,
+                    on_notify.stops > 0 ? elapsed / on_notify.stops : 0.0);
+        std::printf("  allocations: %lu (%.1f per line), %lu bytes\n", static_cast<unsigned long>(run_allocations),
+                    lines > 0 ? double(run_allocations) / lines : 0.0, static_cast<unsigned long>(run_allocated_bytes));
+        std::printf("  unmatched commands: %d, skipped lines: %d, unparsable records: %d, unfinished actions: %s\n",
+                    exec.GetUnmatchedCommands(), exec.GetSkippedLines(), unparsable, actions.Empty() ? "no" : "yes");
+        std::printf("  refreshed by the real actions: backtrace %s, threads %s, watches: %d created, %d of %d "
+                    "expansions; the other commands are replayed by generic actions\n",
+                    session.refresh_backtrace ? "yes" : "no", session.refresh_threads ? "yes" : "no",
+                    session.created_watches, session.expanded_watches,
+                    session.expanded_watches + int(session.expansions.size()));
+
+        if(run == repeat - 1)
+            std::printf("\n%s", static_cast<char const*>(exec.GetStats().MakeReport().utf8_str()));
+    }
+    return 0;
+}
@@ -0,0 +1,176 @@
+#ifndef _TESTS_REPLAY_COMMAND_EXECUTOR_H_
+#define _TESTS_REPLAY_COMMAND_EXECUTOR_H_
+
+#include <deque>
+#include <istream>
+#include <string>
+#include <tr1/unordered_map>
+
+#include "cmd_queue.h"
+
+/// Answers the commands with the output recorded in a real debugging session, so the actions can be run without gdb.
+/// A session is the command stream (the lines passed to Logger::AddCommand) and the raw output of gdb.
+/// The output lines are replayed in the recorded order, but a line with a token waits until the command it belongs to
+/// is executed again; then its token is replaced with the token of the new command.
+class ReplayCommandExecutor : public dbg_mi::CommandExecutor
+{
+public:
+    struct RecordedCommand
+    {
+        std::string token;
+        wxString command;
+        int action;
+        bool executed;
+    };
+    typedef std::deque<RecordedCommand> RecordedCommands;
+public:
+    ReplayCommandExecutor() :
+        m_next_command(0),
+        m_next_output(0),
+        m_unmatched_commands(0),
+        m_skipped_lines(0),
+        m_replayed_bytes(0)
+    {
+    }
+
+    virtual wxString GetOutput() { return wxEmptyString; }
+
+    /// Adds a line of the command stream: the token followed by the command.
+    bool AddCommand(std::string const &line)
+    {
+        size_t const token_length = GetTokenLength(line);
+        if(token_length == 0 || token_length == line.length())
+            return false;
+
+        RecordedCommand command;
+        command.token = line.substr(0, token_length);
+        command.command = wxString(line.c_str() + token_length, wxConvUTF8);
+        // the last ten digits of the token are the index of the command in its action
+        command.action = 0;
+        for(size_t ii = 0; ii + 10 < token_length; ++ii)
+            command.action = command.action * 10 + (line[ii] - '0');
+        command.executed = false;
+        m_commands.push_back(command);
+        return true;
+    }
+
+    /// Adds a line of the raw output of gdb; it must be encoded in UTF-8 like the output of gdb.
+    void AddOutput(std::string const &line)
+    {
+        m_output.push_back(line);
+    }
+
+    /// Reads the debug log of the plugin, which contains both the commands and the output.
+    void LoadDebugLog(std::istream &stream)
+    {
+        std::string line;
+        while(std::getline(stream, line))
+        {
+            if(!line.empty() && line[line.length() - 1] == '\r')
+                line.erase(line.length() - 1);
+
+            size_t pos;
+            if((pos = line.find("unparsable_output==>")) != std::string::npos)
+                AddOutput(line.substr(pos + 20));
+            else if((pos = line.find("output==>")) != std::string::npos)
+                AddOutput(line.substr(pos + 9));
+            else if((pos = line.find("cmd==>")) != std::string::npos)
+                AddCommand(line.substr(pos + 6));
+        }
+    }
+
+    /// Feeds the recorded output until a line waits for a command, which hasn't been executed yet.
+    /// Returns the number of lines fed.
+    int Replay()
+    {
+        int count = 0;
+        for(; m_next_output < m_output.size(); ++m_next_output, ++count)
+        {
+            std::string const &line = m_output[m_next_output];
+            size_t const token_length = GetTokenLength(line);
+            if(token_length == 0)
+                Feed(line.data(), line.length());
+            else
+            {
+                Tokens::const_iterator it = m_tokens.find(line.substr(0, token_length));
+                if(it == m_tokens.end())
+                    break;
+                std::string const replayed = it->second + line.substr(token_length);
+                Feed(replayed.data(), replayed.length());
+            }
+        }
+        return count;
+    }
+
+    /// Skips the line which waits for a command, that the replayed actions haven't executed.
+    bool SkipBlockedLine()
+    {
+        if(IsFinished())
+            return false;
+        ++m_next_output;
+        ++m_skipped_lines;
+        return true;
+    }
+
+    bool IsFinished() const { return m_next_output >= m_output.size(); }
+
+    RecordedCommands const& GetRecordedCommands() const { return m_commands; }
+    int GetOutputLineCount() const { return m_output.size(); }
+    int GetUnmatchedCommands() const { return m_unmatched_commands; }
+    int GetSkippedLines() const { return m_skipped_lines; }
+    int64_t GetReplayedBytes() const { return m_replayed_bytes; }
+protected:
+    virtual bool DoExecute(dbg_mi::CommandID const &id, wxString const &cmd)
+    {
+        while(m_next_command < m_commands.size() && m_commands[m_next_command].executed)
+            ++m_next_command;
+
+        for(size_t ii = m_next_command; ii < m_commands.size(); ++ii)
+        {
+            RecordedCommand &recorded = m_commands[ii];
+            if(!recorded.executed && recorded.command == cmd)
+            {
+                recorded.executed = true;
+                m_tokens[recorded.token] = std::string(id.ToString().utf8_str().data());
+                return true;
+            }
+        }
+        // the command has no recorded output, it will never get a result
+        ++m_unmatched_commands;
+        return true;
+    }
+
+    virtual void DoClear()
+    {
+        m_tokens.clear();
+    }
+private:
+    static size_t GetTokenLength(std::string const &line)
+    {
+        size_t length = 0;
+        while(length < line.length() && line[length] >= '0' && line[length] <= '9')
+            ++length;
+        return length;
+    }
+
+    void Feed(char const *data, size_t length)
+    {
+        ProcessOutput(data, length);
+        ProcessOutput("\n", 1);
+        m_replayed_bytes += length + 1;
+    }
+private:
+    typedef std::deque<std::string> Output;
+    typedef std::tr1::unordered_map<std::string, std::string> Tokens;
+
+    RecordedCommands m_commands;
+    Output m_output;
+    Tokens m_tokens;
+    size_t m_next_command;
+    size_t m_next_output;
+    int m_unmatched_commands;
+    int m_skipped_lines;
+    int64_t m_replayed_bytes;
+};
+
+#endif // _TESTS_REPLAY_COMMAND_EXECUTOR_H_
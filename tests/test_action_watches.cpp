@@ -1,3 +1,4 @@
+#include <map>
 #include <UnitTest++.h>
 
 #include "actions.h"
@@ -43,14 +44,6 @@ bool operator == (wxString const &s, cbWatch const &w)
     return s == WatchToString(w);
 }
 
-dbg_mi::ResultParser MakeParser(wxString const &str)
-{
-    dbg_mi::ResultParser p;
-    if (!p.Parse(str))
-        return dbg_mi::ResultParser();
-    return p;
-}
-
 TEST(UpdateSimple)
 {
     dbg_mi::WatchesContainer watches;
@@ -70,3 +63,184 @@ TEST(UpdateSimple)
     CHECK_EQUAL(wxT("a=5"), *watches[0]);
     CHECK(watches[0]->IsChanged());
 }
+
+TEST(UpdateFreezesTooltips)
+{
+    dbg_mi::WatchesContainer watches;
+    cb::shared_ptr<dbg_mi::Watch> w(new dbg_mi::Watch(wxT("a"), true));
+    w->SetID(wxT("var1"));
+    watches.push_back(w);
+    MockLogger logger;
+    dbg_mi::WatchesUpdateAction action(watches, logger);
+    action.SetID(1);
+    action.Start();
+
+    // nothing is live, so there is no -var-update
+    dbg_mi::CommandID id;
+    CHECK_EQUAL(wxT("-var-set-frozen \"var1\" 1"), action.PopPendingCommand(id));
+    CHECK(!action.HasPendingCommands());
+    action.OnCommandOutput(id, MakeParser(wxT("^done")));
+    CHECK(action.Finished());
+    CHECK(w->IsFrozen());
+
+    // the second update has nothing to do
+    dbg_mi::WatchesUpdateAction second(watches, logger);
+    second.SetID(2);
+    second.Start();
+    CHECK(second.Finished());
+    CHECK(!second.HasPendingCommands());
+}
+
+TEST(UpdateFreezesChildrenOfCollapsedWatch)
+{
+    dbg_mi::WatchesContainer watches;
+    cb::shared_ptr<dbg_mi::Watch> w(new dbg_mi::Watch(wxT("v"), false));
+    w->SetID(wxT("var1"));
+    watches.push_back(w);
+    for (int ii = 0; ii < 2; ++ii)
+    {
+        cb::shared_ptr<dbg_mi::Watch> child(new dbg_mi::Watch(wxString::Format(wxT("%d"), ii), false, false));
+        child->SetID(wxString::Format(wxT("var1.%d"), ii));
+        cbWatch::AddChild(w, child);
+    }
+    MockLogger logger;
+
+    dbg_mi::WatchesUpdateAction collapsed(watches, logger);
+    collapsed.SetID(1);
+    collapsed.Start();
+    dbg_mi::CommandID id;
+    CHECK_EQUAL(wxT("-var-set-frozen \"var1.0\" 1"), collapsed.PopPendingCommand(id));
+    CHECK_EQUAL(wxT("-var-set-frozen \"var1.1\" 1"), collapsed.PopPendingCommand(id));
+    CHECK_EQUAL(wxT("-var-update 1 *"), collapsed.PopPendingCommand(id));
+    CHECK(!collapsed.HasPendingCommands());
+
+    w->Expand(true);
+    dbg_mi::WatchesUpdateAction expanded(watches, logger);
+    expanded.SetID(2);
+    expanded.Start();
+    CHECK_EQUAL(wxT("-var-set-frozen \"var1.0\" 0"), expanded.PopPendingCommand(id));
+    CHECK_EQUAL(wxT("-var-set-frozen \"var1.1\" 0"), expanded.PopPendingCommand(id));
+    CHECK_EQUAL(wxT("-var-update 1 *"), expanded.PopPendingCommand(id));
+    CHECK(!static_cast<dbg_mi::Watch const&>(*w->GetChild(0)).IsFrozen());
+
+    // the results of -var-set-frozen are skipped
+    expanded.OnCommandOutput(dbg_mi::CommandID(2, 0), MakeParser(wxT("^done")));
+    expanded.OnCommandOutput(dbg_mi::CommandID(2, 1), MakeParser(wxT("^done")));
+    CHECK(!expanded.Finished());
+    expanded.OnCommandOutput(dbg_mi::CommandID(2, 2), MakeParser(wxT("^done,changelist=[]")));
+    CHECK(expanded.Finished());
+}
+
+TEST(ExpandFirstPage)
+{
+    dbg_mi::WatchesContainer watches;
+    cb::shared_ptr<dbg_mi::Watch> w(new dbg_mi::Watch(wxT("v"), false));
+    w->SetID(wxT("var1"));
+    watches.push_back(w);
+    MockLogger logger;
+    dbg_mi::WatchExpandedAction action(w, w, watches, logger);
+    action.SetID(1);
+    action.Start();
+
+    action.OnCommandOutput(dbg_mi::CommandID(1, 1),
+                           MakeParser(wxT("^done,numchild=\"2\",children=[")
+                                      wxT("child={name=\"var1.0\",exp=\"0\",numchild=\"0\",value=\"1\",type=\"int\"},")
+                                      wxT("child={name=\"var1.1\",exp=\"1\",numchild=\"0\",value=\"2\",type=\"int\"}],")
+                                      wxT("has_more=\"1\"")));
+
+    CHECK_EQUAL(wxT("v= {0=1,1=2,...=expand to show more children {updating...=}}"), *watches[0]);
+    CHECK(w->GetFetchedRanges().Contains(0, dbg_mi::c_watch_page_size));
+    CHECK(static_cast<dbg_mi::Watch const&>(*w->GetChild(2)).IsMorePlaceholder());
+}
+
+TEST(ExpandNextPage)
+{
+    dbg_mi::WatchesContainer watches;
+    cb::shared_ptr<dbg_mi::Watch> w(new dbg_mi::Watch(wxT("v"), false));
+    w->SetID(wxT("var1"));
+    w->SetHasBeenExpanded(true);
+    watches.push_back(w);
+
+    cb::shared_ptr<dbg_mi::Watch> more(new dbg_mi::Watch(wxT("..."), false, false));
+    more->SetMorePlaceholder(true);
+    cbWatch::AddChild(w, more);
+    w->GetFetchedRanges().Add(0, dbg_mi::c_watch_page_size);
+
+    MockLogger logger;
+    dbg_mi::WatchExpandedAction action(w, w, watches, logger, dbg_mi::c_watch_page_size);
+    action.SetID(1);
+    action.Start();
+
+    // Only the list command is executed for the next page.
+    action.OnCommandOutput(dbg_mi::CommandID(1, 0),
+                           MakeParser(wxT("^done,numchild=\"1\",children=[")
+                                      wxT("child={name=\"var1.50\",exp=\"50\",numchild=\"0\",value=\"7\",type=\"int\"}],")
+                                      wxT("has_more=\"0\"")));
+
+    CHECK_EQUAL(wxT("v= {50=7}"), *watches[0]);
+    CHECK_EQUAL(2 * dbg_mi::c_watch_page_size, w->GetFetchedRanges().GetFirstMissing());
+}
+
+TEST(ExpandRecursive)
+{
+    // The watch has 10 children without a type, like the access specifiers of a class. Every one of them is listed
+    // by a separate command and adds 10 children to the watch, so the action issues 11 list commands.
+    int const group_count = 10;
+    int const group_size = 10;
+
+    wxString groups = wxString::Format(wxT("^done,numchild=\"%d\",children=["), group_count);
+    std::map<wxString, dbg_mi::ResultParser> outputs;
+    for(int group = 0; group < group_count; ++group)
+    {
+        if(group > 0)
+            groups += wxT(",");
+        groups += wxString::Format(wxT("child={name=\"var1.g%d\",exp=\"g%d\",numchild=\"%d\"}"),
+                                   group, group, group_size);
+
+        wxString children = wxString::Format(wxT("^done,numchild=\"%d\",children=["), group_size);
+        for(int child = 0; child < group_size; ++child)
+        {
+            if(child > 0)
+                children += wxT(",");
+            children += wxString::Format(wxT("child={name=\"var1.g%d.%d\",exp=\"m%d_%d\",numchild=\"0\",")
+                                         wxT("value=\"%d\",type=\"int\"}"), group, child, group, child, child);
+        }
+        children += wxT("],has_more=\"0\"");
+        outputs[wxString::Format(wxT("var1.g%d"), group)] = MakeParser(children);
+    }
+    groups += wxT("],has_more=\"0\"");
+    outputs[wxT("var1")] = MakeParser(groups);
+    dbg_mi::ResultParser const update = MakeParser(wxT("^done,changelist=[]"));
+
+    dbg_mi::WatchesContainer watches;
+    cb::shared_ptr<dbg_mi::Watch> w(new dbg_mi::Watch(wxT("v"), false));
+    w->SetID(wxT("var1"));
+    watches.push_back(w);
+    MockLogger logger;
+    dbg_mi::WatchExpandedAction action(w, w, watches, logger);
+    action.SetID(1);
+
+    action.Start();
+    int commands = 0;
+    while(action.HasPendingCommands())
+    {
+        dbg_mi::CommandID id;
+        wxString const command = action.PopPendingCommand(id);
+        ++commands;
+        if(command.StartsWith(wxT("-var-update")))
+        {
+            action.OnCommandOutput(id, update);
+            continue;
+        }
+        wxString const name = command.AfterFirst(wxT('"')).BeforeFirst(wxT('"'));
+        std::map<wxString, dbg_mi::ResultParser>::const_iterator it = outputs.find(name);
+        CHECK(it != outputs.end());
+        if(it != outputs.end())
+            action.OnCommandOutput(id, it->second);
+    }
+
+    CHECK(action.Finished());
+    CHECK_EQUAL(group_count + 2, commands);
+    CHECK_EQUAL(group_count * group_size, w->GetChildCount());
+    CHECK(watches.Find(wxT("var1.g9.9")));
+}
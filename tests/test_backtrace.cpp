@@ -0,0 +1,215 @@
+#include <UnitTest++.h>
+
+#include <algorithm>
+
+#include "actions.h"
+
+#include "common.h"
+#include "mock_logger.h"
+
+namespace
+{
+/// The output of -stack-list-frames for the levels [start, end]; the address of a frame is its distance from the
+/// outermost frame, so the frames below the top stay the same, when the depth changes.
+wxString MakeFrames(int start, int end, int depth)
+{
+    wxString output(wxT("^done,stack=["));
+    for (int level = start; level <= end; ++level)
+    {
+        if (level > start)
+            output += wxT(",");
+        output += wxString::Format(wxT("frame={level=\"%d\",addr=\"0x%x\",func=\"f\",")
+                                   wxT("file=\"a.cpp\",fullname=\"/a.cpp\",line=\"%d\"}"),
+                                   level, 0x1000 + depth - level, 10 + level);
+    }
+    return output + wxT("]");
+}
+
+wxString MakeArguments(int start, int end)
+{
+    wxString output(wxT("^done,stack-args=["));
+    for (int level = start; level <= end; ++level)
+    {
+        if (level > start)
+            output += wxT(",");
+        output += wxString::Format(wxT("frame={level=\"%d\",args=[{name=\"n\",value=\"%d\"}]}"), level, level);
+    }
+    return output + wxT("]");
+}
+
+bool ParseRange(wxString const &command, wxString const &prefix, long &start, long &end)
+{
+    wxString range;
+    return command.StartsWith(prefix, &range)
+           && range.BeforeFirst(wxT(' ')).ToLong(&start) && range.AfterFirst(wxT(' ')).ToLong(&end);
+}
+
+struct MockSwitcher : dbg_mi::SwitchToFrameInvoker
+{
+    virtual void Invoke(int /*frame_number*/) {}
+};
+
+struct BacktraceFixture
+{
+    BacktraceFixture() : full_depth_commands(0)
+    {
+        current_frame.SetThreadId(1);
+    }
+
+    /// Answers the commands of a GenerateBacktrace for a stack with the given depth.
+    /// Returns the number of -stack-list-frames commands.
+    int Run(int depth, int first_frame = 0)
+    {
+        dbg_mi::GenerateBacktrace action(new MockSwitcher, backtrace, cache, current_frame, logger, first_frame);
+        action.SetID(1);
+        action.Start();
+
+        int list_commands = 0;
+        while (action.HasPendingCommands())
+        {
+            dbg_mi::CommandID id;
+            wxString const command = action.PopPendingCommand(id);
+            wxString output, rest;
+            long start, end, max_depth;
+            if (command == wxT("-stack-info-frame"))
+                output = wxT("^done,frame={level=\"0\",addr=\"0x1\"}");
+            else if (command == wxT("-stack-info-depth"))
+            {
+                ++full_depth_commands;
+                output = wxString::Format(wxT("^done,depth=\"%d\""), depth);
+            }
+            else if (command.StartsWith(wxT("-stack-info-depth "), &rest) && rest.ToLong(&max_depth))
+                output = wxString::Format(wxT("^done,depth=\"%d\""), std::min<int>(depth, max_depth));
+            else if (ParseRange(command, wxT("-stack-list-frames "), start, end))
+            {
+                ++list_commands;
+                output = MakeFrames(start, std::min<int>(end, depth - 1), depth);
+            }
+            else if (ParseRange(command, wxT("-stack-list-arguments 1 "), start, end))
+                output = MakeArguments(start, std::min<int>(end, depth - 1));
+            action.OnCommandOutput(id, MakeParser(output));
+        }
+        CHECK(action.Finished());
+        return list_commands;
+    }
+
+    dbg_mi::BacktraceContainer backtrace;
+    dbg_mi::BacktraceCache cache;
+    dbg_mi::CurrentFrame current_frame;
+    MockLogger logger;
+    int full_depth_commands;
+};
+} // anonymous namespace
+
+TEST(BacktraceCacheMatchesByDistanceFromOutermostFrame)
+{
+    BacktraceFixture f;
+    f.Run(5);
+    CHECK(f.cache.Matches(2, 0x1000 + 5 - 2, 5, 1));
+    // two frames were pushed on top of the stack
+    CHECK(f.cache.Matches(4, 0x1000 + 5 - 2, 7, 1));
+    CHECK(!f.cache.Matches(2, 0x1000 + 5 - 2, 7, 1));
+    CHECK(!f.cache.Matches(2, 0x1000 + 5 - 2, 5, 2));
+
+    dbg_mi::BacktraceContainer frames;
+    CHECK_EQUAL(3, f.cache.CopyFrames(frames, 4, 10, 7));
+    CHECK_EQUAL(3u, frames.size());
+    CHECK_EQUAL(4, frames[0]->GetNumber());
+    CHECK_EQUAL(0x1000ul + 5 - 2, frames[0]->GetAddress());
+    CHECK_EQUAL(wxT("f(n=2)"), frames[0]->GetSymbol());
+}
+
+TEST(BacktraceCacheSurvivesOnlyOneStep)
+{
+    BacktraceFixture f;
+    f.Run(5);
+    f.cache.OnStop(true);
+    CHECK(!f.cache.IsEmpty());
+    f.cache.OnStop(true);
+    CHECK(f.cache.IsEmpty());
+
+    f.Run(5);
+    f.cache.OnStop(false);
+    CHECK(f.cache.IsEmpty());
+}
+
+TEST(GenerateBacktraceFirstPage)
+{
+    BacktraceFixture f;
+    dbg_mi::GenerateBacktrace action(new MockSwitcher, f.backtrace, f.cache, f.current_frame, f.logger);
+    action.SetID(1);
+    action.Start();
+
+    dbg_mi::CommandID id;
+    CHECK_EQUAL(wxT("-stack-info-frame"), action.PopPendingCommand(id));
+    CHECK_EQUAL(wxString::Format(wxT("-stack-info-depth %d"), dbg_mi::c_backtrace_page_size + 1),
+                action.PopPendingCommand(id));
+    CHECK_EQUAL(wxString::Format(wxT("-stack-list-frames 0 %d"), dbg_mi::c_backtrace_top_frames - 1),
+                action.PopPendingCommand(id));
+    CHECK_EQUAL(wxString::Format(wxT("-stack-list-arguments 1 0 %d"), dbg_mi::c_backtrace_top_frames - 1),
+                action.PopPendingCommand(id));
+
+    CHECK_EQUAL(2, f.Run(100));
+    CHECK_EQUAL(dbg_mi::c_backtrace_page_size + 1, static_cast<int>(f.backtrace.size()));
+    CHECK_EQUAL(wxT("f(n=29)"), f.backtrace[29]->GetSymbol());
+    CHECK(dbg_mi::IsMoreFramesPlaceholder(*f.backtrace.back()));
+    CHECK_EQUAL(dbg_mi::c_backtrace_page_size, f.backtrace.back()->GetNumber());
+    CHECK_EQUAL(0, f.full_depth_commands);
+}
+
+TEST(GenerateBacktraceCountsAllFramesOnlyWhenStepping)
+{
+    BacktraceFixture f;
+    f.Run(100);
+    CHECK_EQUAL(0, f.full_depth_commands);
+    // the depth isn't known, so the deep stack can't be cached
+    CHECK(f.cache.IsEmpty());
+    CHECK_EQUAL(wxT("more frames"), f.backtrace.back()->GetFilename());
+
+    f.cache.OnStop(true);
+    f.Run(100);
+    CHECK_EQUAL(1, f.full_depth_commands);
+    CHECK(!f.cache.IsEmpty());
+    CHECK_EQUAL(wxString::Format(wxT("%d more frames"), 100 - dbg_mi::c_backtrace_page_size),
+                f.backtrace.back()->GetFilename());
+
+    // the next step takes the outer frames of the page from the cache
+    f.cache.OnStop(true);
+    CHECK_EQUAL(1, f.Run(101));
+    CHECK_EQUAL(2, f.full_depth_commands);
+}
+
+TEST(GenerateBacktraceNextPage)
+{
+    BacktraceFixture f;
+    f.Run(100);
+    CHECK_EQUAL(1, f.Run(100, dbg_mi::c_backtrace_page_size));
+    CHECK_EQUAL(2 * dbg_mi::c_backtrace_page_size + 1, static_cast<int>(f.backtrace.size()));
+    CHECK(!dbg_mi::IsMoreFramesPlaceholder(*f.backtrace[dbg_mi::c_backtrace_page_size]));
+    CHECK_EQUAL(dbg_mi::c_backtrace_page_size, f.backtrace[dbg_mi::c_backtrace_page_size]->GetNumber());
+    CHECK(dbg_mi::IsMoreFramesPlaceholder(*f.backtrace.back()));
+
+    CHECK_EQUAL(1, f.Run(100, 2 * dbg_mi::c_backtrace_page_size));
+    CHECK_EQUAL(1, f.Run(100, 3 * dbg_mi::c_backtrace_page_size));
+    CHECK_EQUAL(100u, f.backtrace.size());
+    CHECK(!dbg_mi::IsMoreFramesPlaceholder(*f.backtrace.back()));
+}
+
+TEST(GenerateBacktraceTakesOuterFramesFromCache)
+{
+    BacktraceFixture f;
+    f.Run(20);
+    f.cache.OnStop(true);
+
+    // a step into a function: only the top frames are listed, the rest is copied
+    CHECK_EQUAL(1, f.Run(21));
+    CHECK_EQUAL(21u, f.backtrace.size());
+    CHECK_EQUAL(20, f.backtrace[20]->GetNumber());
+    CHECK_EQUAL(wxT("f(n=19)"), f.backtrace[20]->GetSymbol());
+    CHECK_EQUAL(0x1000ul + 1, f.backtrace[20]->GetAddress());
+
+    // after a continue everything is listed again
+    f.cache.OnStop(false);
+    CHECK_EQUAL(2, f.Run(21));
+    CHECK_EQUAL(wxT("f(n=20)"), f.backtrace[20]->GetSymbol());
+}
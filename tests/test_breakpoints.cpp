@@ -0,0 +1,226 @@
+#include <UnitTest++.h>
+
+#include "actions.h"
+
+#include "common.h"
+#include "mock_command_executor.h"
+#include "mock_logger.h"
+
+namespace
+{
+wxString MakeInsertOutput(int number)
+{
+    return wxString::Format(wxT("^done,bkpt={number=\"%d\",type=\"breakpoint\",disp=\"keep\",enabled=\"y\"}"),
+                            number);
+}
+} // anonymous namespace
+
+TEST(BreakpointInsertCommand)
+{
+    dbg_mi::Breakpoint breakpoint(wxT("/src/a.cpp"), 10, nullptr);
+    CHECK_EQUAL(wxT("-break-insert -f /src/a.cpp:10"), dbg_mi::MakeBreakpointInsertCommand(breakpoint));
+
+    breakpoint.SetEnabled(false);
+    CHECK_EQUAL(wxT("-break-insert -f -d /src/a.cpp:10"), dbg_mi::MakeBreakpointInsertCommand(breakpoint));
+
+    breakpoint.SetEnabled(true);
+    breakpoint.SetCondition(wxT("s == \"a\""));
+    breakpoint.SetIgnoreCount(100);
+    CHECK_EQUAL(wxT("-break-insert -f -c \"s == \\\"a\\\"\" -i 100 /src/a.cpp:10"),
+                dbg_mi::MakeBreakpointInsertCommand(breakpoint));
+}
+
+TEST(BreakpointConditionCommand)
+{
+    dbg_mi::Breakpoint breakpoint(wxT("/src/a.cpp"), 10, nullptr);
+    breakpoint.SetIndex(3);
+    CHECK_EQUAL(wxT("-break-condition 3"), dbg_mi::MakeBreakpointConditionCommand(breakpoint));
+
+    breakpoint.SetCondition(wxT("s == \"a b\""));
+    CHECK_EQUAL(wxT("-break-condition 3 \"s == \\\"a b\\\"\""), dbg_mi::MakeBreakpointConditionCommand(breakpoint));
+}
+
+TEST(BreakpointInfo)
+{
+    dbg_mi::Breakpoint breakpoint(wxT("a.cpp"), 10, nullptr);
+    CHECK_EQUAL(wxT(""), breakpoint.GetInfo());
+
+    breakpoint.SetCondition(wxT("i > 5"));
+    CHECK_EQUAL(wxT("condition: i > 5"), breakpoint.GetInfo());
+
+    breakpoint.SetIgnoreCount(3);
+    breakpoint.SetHitCount(12);
+    CHECK_EQUAL(wxT("condition: i > 5; ignore count: 3; hits: 12"), breakpoint.GetInfo());
+}
+
+TEST(BreakpointAddActionSendsAllInsertsAtOnce)
+{
+    MockLogger logger;
+    dbg_mi::BreakpointAddAction::BreakpointList breakpoints;
+    for (int ii = 0; ii < 100; ++ii)
+        breakpoints.push_back(cb::shared_ptr<dbg_mi::Breakpoint>(new dbg_mi::Breakpoint(wxT("a.cpp"), ii, nullptr)));
+    breakpoints[50]->SetEnabled(false);
+
+    dbg_mi::BreakpointsContainer container;
+    for (size_t ii = 0; ii < breakpoints.size(); ++ii)
+        container.Add(breakpoints[ii]);
+    dbg_mi::BreakpointAddAction action(breakpoints, container, logger);
+    action.SetID(1);
+    action.Start();
+    CHECK_EQUAL(100, action.GetPendingCommandsCount());
+
+    std::vector<dbg_mi::CommandID> ids;
+    for (int ii = 0; ii < 100; ++ii)
+    {
+        dbg_mi::CommandID id;
+        wxString const command = action.PopPendingCommand(id);
+        if (ii == 50)
+            CHECK_EQUAL(wxT("-break-insert -f -d a.cpp:50"), command);
+        ids.push_back(id);
+    }
+
+    // the results of the pipelined commands can arrive in any order
+    for (int ii = 99; ii >= 0; --ii)
+    {
+        CHECK(!action.Finished());
+        action.OnCommandOutput(ids[ii], MakeParser(MakeInsertOutput(ii + 1)));
+    }
+    CHECK(action.Finished());
+    CHECK_EQUAL(0, action.GetFailedCount());
+    CHECK_EQUAL(1, breakpoints[0]->GetIndex());
+    CHECK_EQUAL(100, breakpoints[99]->GetIndex());
+    CHECK(container.FindByNumber(51) == breakpoints[50]);
+}
+
+TEST(BreakpointAddActionFillsTheWholeWindow)
+{
+    MockLogger logger;
+    dbg_mi::BreakpointAddAction::BreakpointList breakpoints;
+    dbg_mi::BreakpointsContainer container;
+    for (int ii = 0; ii < 100; ++ii)
+    {
+        breakpoints.push_back(cb::shared_ptr<dbg_mi::Breakpoint>(new dbg_mi::Breakpoint(wxT("a.cpp"), ii, nullptr)));
+        container.Add(breakpoints.back());
+    }
+
+    dbg_mi::ActionsMap actions;
+    MockCommandExecutor exec(false);
+    exec.SetMaxInFlight(64);
+    actions.Add(new dbg_mi::BreakpointAddAction(breakpoints, container, logger));
+    actions.Run(exec);
+    CHECK_EQUAL(64, exec.GetInFlightCount());
+}
+
+TEST(BreakpointAddActionFailureDoesntBlockTheRest)
+{
+    MockLogger logger;
+    dbg_mi::BreakpointAddAction::BreakpointList breakpoints;
+    for (int ii = 0; ii < 3; ++ii)
+        breakpoints.push_back(cb::shared_ptr<dbg_mi::Breakpoint>(new dbg_mi::Breakpoint(wxT("a.cpp"), ii, nullptr)));
+
+    dbg_mi::BreakpointsContainer container;
+    for (size_t ii = 0; ii < breakpoints.size(); ++ii)
+        container.Add(breakpoints[ii]);
+    dbg_mi::BreakpointAddAction action(breakpoints, container, logger);
+    action.SetID(1);
+    action.Start();
+
+    dbg_mi::CommandID ids[3];
+    for (int ii = 0; ii < 3; ++ii)
+        action.PopPendingCommand(ids[ii]);
+
+    action.OnCommandOutput(ids[0], MakeParser(MakeInsertOutput(1)));
+    action.OnCommandOutput(ids[1], MakeParser(wxT("^error,msg=\"No line 1 in file \\\"a.cpp\\\".\"")));
+    CHECK(!action.Finished());
+    action.OnCommandOutput(ids[2], MakeParser(MakeInsertOutput(2)));
+
+    CHECK(action.Finished());
+    CHECK_EQUAL(1, action.GetFailedCount());
+    CHECK_EQUAL(1, breakpoints[0]->GetIndex());
+    CHECK_EQUAL(-1, breakpoints[1]->GetIndex());
+    CHECK_EQUAL(2, breakpoints[2]->GetIndex());
+    CHECK(!container.FindByNumber(3));
+}
+
+TEST(BreakpointAddActionWithoutBreakpoints)
+{
+    MockLogger logger;
+    dbg_mi::BreakpointsContainer container;
+    dbg_mi::BreakpointAddAction action(dbg_mi::BreakpointAddAction::BreakpointList(), container, logger);
+    action.SetID(1);
+    action.Start();
+    CHECK(action.Finished());
+    CHECK(!action.HasPendingCommands());
+}
+
+TEST(BreakpointsContainerFindByLocation)
+{
+    dbg_mi::BreakpointsContainer container;
+    cb::shared_ptr<dbg_mi::Breakpoint> a(new dbg_mi::Breakpoint(wxT("/src/a.cpp"), 10, nullptr));
+    cb::shared_ptr<dbg_mi::Breakpoint> b(new dbg_mi::Breakpoint(wxT("/src/b.cpp"), 10, nullptr));
+    container.Add(a);
+    container.Add(b);
+
+    CHECK(container.Find(wxT("/src/a.cpp"), 10) == a);
+    CHECK(container.Find(wxT("\\src\\b.cpp"), 10) == b);
+    CHECK(!container.Find(wxT("/src/a.cpp"), 11));
+
+    container.ShiftLine(0, 5);
+    CHECK(!container.Find(wxT("/src/a.cpp"), 10));
+    CHECK(container.Find(wxT("/src/a.cpp"), 15) == a);
+    CHECK_EQUAL(15, a->GetLine());
+}
+
+TEST(BreakpointsContainerRemove)
+{
+    dbg_mi::BreakpointsContainer container;
+    cb::shared_ptr<dbg_mi::Breakpoint> a(new dbg_mi::Breakpoint(wxT("a.cpp"), 1, nullptr));
+    cb::shared_ptr<dbg_mi::Breakpoint> b(new dbg_mi::Breakpoint(wxT("a.cpp"), 2, nullptr));
+    cb::shared_ptr<dbg_mi::Breakpoint> c(new dbg_mi::Breakpoint(wxT("a.cpp"), 3, nullptr));
+    container.Add(a);
+    container.Add(b);
+    container.Add(c);
+    container.SetNumber(*b, 7);
+
+    CHECK(container.Remove(b.get()) == b);
+    CHECK(!container.Remove(b.get()));
+    CHECK_EQUAL(2u, container.size());
+    CHECK(container[0] == a);
+    CHECK(container[1] == c);
+    CHECK(!container.FindByNumber(7));
+    CHECK(!container.Find(wxT("a.cpp"), 2));
+
+    // the insert of a removed breakpoint finishes later, it mustn't be indexed again
+    container.SetNumber(*b, 8);
+    CHECK(!container.FindByNumber(8));
+}
+
+TEST(BreakpointsContainerNumbers)
+{
+    dbg_mi::BreakpointsContainer container;
+    cb::shared_ptr<dbg_mi::Breakpoint> a(new dbg_mi::Breakpoint(wxT("a.cpp"), 1, nullptr));
+    container.Add(a);
+    container.SetNumber(*a, 4);
+    CHECK(container.FindByNumber(4) == a);
+
+    container.SetNumber(*a, 5);
+    CHECK(!container.FindByNumber(4));
+    CHECK(container.FindByNumber(5) == a);
+
+    container.ResetNumbers();
+    CHECK(!container.FindByNumber(5));
+    CHECK_EQUAL(-1, a->GetIndex());
+}
+
+TEST(BreakpointsContainerHitCount)
+{
+    dbg_mi::BreakpointsContainer container;
+    cb::shared_ptr<dbg_mi::Breakpoint> a(new dbg_mi::Breakpoint(wxT("a.cpp"), 1, nullptr));
+    container.Add(a);
+    container.SetNumber(*a, 2);
+
+    CHECK(container.UpdateHitCount(2, 10));
+    CHECK(!container.UpdateHitCount(2, 10));
+    CHECK(!container.UpdateHitCount(3, 11));
+    CHECK_EQUAL(10, a->GetHitCount());
+}
@@ -1,10 +1,17 @@
+#include <cstring>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
 #include <UnitTest++.h>
 
 #include "cmd_queue.h"
 #include "cmd_result_parser.h"
+#include "command_id_map.h"
 
 #include "mock_command_executor.h"
 #include "mock_logger.h"
+#include "replay_command_executor.h"
 
 // Test List
 //--------------------------------
@@ -95,12 +102,81 @@ TEST(CommandIDGetCommandID)
 TEST(CommandIDGetFullID)
 {
     dbg_mi::CommandID  id(12, 345);
-    int64_t r = (static_cast<int64_t>(id.GetActionID()) >> 32) + id.GetCommandID();
+    int64_t r = (static_cast<int64_t>(id.GetActionID()) << 32) + id.GetCommandID();
 
     CHECK_EQUAL(r, id.GetFullID());
     CHECK_EQUAL(wxT("120000000345"), id.ToString());
 }
 
+TEST(CommandIDGetFullIDUnique)
+{
+    CHECK(dbg_mi::CommandID(1, 5).GetFullID() != dbg_mi::CommandID(2, 5).GetFullID());
+    CHECK(dbg_mi::CommandID(0, 1).GetFullID() != dbg_mi::CommandID(1, 0).GetFullID());
+    CHECK(dbg_mi::CommandID().GetFullID() != dbg_mi::CommandID(0, -1).GetFullID());
+    CHECK_EQUAL(-1, dbg_mi::CommandID().GetFullID());
+}
+
+TEST(CommandIDMapInsertFind)
+{
+    dbg_mi::CommandIDMap<int> map;
+    CHECK(map.empty());
+    CHECK(map.find(dbg_mi::CommandID(1, 0)) == map.end());
+
+    map[dbg_mi::CommandID(1, 0)] = 10;
+    map[dbg_mi::CommandID(2, 0)] = 20;
+    CHECK_EQUAL(2, map.size());
+    CHECK(map.find(dbg_mi::CommandID(1, 0)) != map.end());
+    CHECK_EQUAL(20, map.find(dbg_mi::CommandID(2, 0))->second);
+    CHECK(map.find(dbg_mi::CommandID(3, 0)) == map.end());
+
+    // an existing entry is not inserted again
+    map[dbg_mi::CommandID(1, 0)] = 11;
+    CHECK_EQUAL(2, map.size());
+    CHECK_EQUAL(11, map.find(dbg_mi::CommandID(1, 0))->second);
+}
+
+TEST(CommandIDMapEraseKeepsProbeSequences)
+{
+    // compares the map to std::map while many entries are inserted and erased
+    dbg_mi::CommandIDMap<int> map;
+    std::map<int64_t, int> reference;
+    unsigned random = 12345;
+    for(int ii = 0; ii < 20000; ++ii)
+    {
+        random = random * 1103515245 + 12345;
+        dbg_mi::CommandID const id((random >> 8) % 40, (random >> 16) % 50);
+        if(random % 3 == 0)
+        {
+            dbg_mi::CommandIDMap<int>::iterator it = map.find(id);
+            CHECK_EQUAL(reference.count(id.GetFullID()) == 1, it != map.end());
+            if(it != map.end())
+                map.erase(it);
+            reference.erase(id.GetFullID());
+        }
+        else
+            map[id] = reference[id.GetFullID()] = ii;
+    }
+
+    CHECK_EQUAL(int(reference.size()), map.size());
+    for(int action = 0; action < 40; ++action)
+    {
+        for(int command = 0; command < 50; ++command)
+        {
+            dbg_mi::CommandID const id(action, command);
+            std::map<int64_t, int>::const_iterator expected = reference.find(id.GetFullID());
+            dbg_mi::CommandIDMap<int>::const_iterator it = map.find(id);
+            if(expected == reference.end())
+                CHECK(it == map.end());
+            else
+                CHECK(it != map.end() && it->second == expected->second);
+        }
+    }
+
+    map.clear();
+    CHECK(map.empty());
+    CHECK(map.find(dbg_mi::CommandID(1, 1)) == map.end());
+}
+
 TEST(ExecuteCommand)
 {
     MockCommandExecutor exec;
@@ -165,6 +241,94 @@ TEST(TestParseDebuggerOutputLineNoID)
     CHECK(wxT("*stopped") == result_str);
 }
 
+TEST(TestParseDebuggerOutputLineUTF8)
+{
+    char const *line = "10000000005^running";
+
+    dbg_mi::CommandID id;
+    int record_start;
+
+    CHECK(dbg_mi::ParseGDBOutputLine(line, strlen(line), id, record_start));
+    CHECK_EQUAL(dbg_mi::CommandID(1, 5), id);
+    CHECK_EQUAL(11, record_start);
+    CHECK(!dbg_mi::ParseGDBOutputLine("~\"text\"", 7, id, record_start));
+}
+
+struct OutputParserHandler : dbg_mi::OutputParser::Handler
+{
+    OutputParserHandler() : unknown(0) {}
+    ~OutputParserHandler()
+    {
+        for(size_t ii = 0; ii < parsers.size(); ++ii)
+            delete parsers[ii];
+    }
+
+    virtual void OnRecord(dbg_mi::CommandID const &id, dbg_mi::ResultParser *parser, char const * /*line*/,
+                          int /*length*/)
+    {
+        ids.push_back(id);
+        parsers.push_back(parser);
+    }
+    virtual void OnUnknownLine(char const * /*line*/, int /*length*/) { ++unknown; }
+
+    std::vector<dbg_mi::CommandID> ids;
+    std::vector<dbg_mi::ResultParser*> parsers;
+    int unknown;
+};
+
+TEST(OutputParserSplitChunks)
+{
+    std::string const output = "10000000005^done,a={b=\"1\",c=[1,2]}\r\n~\"console\"\n*stopped,reason=\"end\"\n"
+                               "20000000000^running\n";
+
+    // split the output in two chunks at every possible position
+    for(size_t split = 0; split <= output.length(); ++split)
+    {
+        OutputParserHandler handler;
+        dbg_mi::OutputParser parser(handler);
+        parser.Feed(output.c_str(), split);
+        parser.Feed(output.c_str() + split, output.length() - split);
+
+        CHECK(!parser.HasPartialLine());
+        CHECK_EQUAL(1, handler.unknown);
+        CHECK_EQUAL(3u, handler.parsers.size());
+        if(handler.parsers.size() == 3)
+        {
+            CHECK_EQUAL(dbg_mi::CommandID(1, 5), handler.ids[0]);
+            CHECK(handler.parsers[0]
+                  && handler.parsers[0]->GetResultValue().MakeDebugString() == wxT("{a={b=1,c=[1,2]}}"));
+            CHECK(handler.parsers[1] && handler.parsers[1]->GetResultClass() == dbg_mi::ResultParser::ClassStopped);
+            CHECK_EQUAL(dbg_mi::CommandID(2, 0), handler.ids[2]);
+        }
+    }
+}
+
+TEST(OutputParserByteByByte)
+{
+    std::string const output = "10000000001^done,value=\"\xd0\xb0\xd0\xb1\"\n10000000002^error,msg=\"x\"\n";
+    OutputParserHandler handler;
+    dbg_mi::OutputParser parser(handler);
+    for(size_t ii = 0; ii < output.length(); ++ii)
+        parser.Feed(output.c_str() + ii, 1);
+
+    CHECK_EQUAL(2u, handler.parsers.size());
+    CHECK(handler.parsers[0]
+          && handler.parsers[0]->GetResultValue().GetTupleValue(wxT("value"))->GetSimpleValue() == wxT("\x0430\x0431"));
+    CHECK(handler.parsers[1] && handler.parsers[1]->GetResultClass() == dbg_mi::ResultParser::ClassError);
+}
+
+TEST(OutputParserPartialLine)
+{
+    OutputParserHandler handler;
+    dbg_mi::OutputParser parser(handler);
+    parser.Feed("10000000001^do", 14);
+    CHECK(parser.HasPartialLine());
+    CHECK(handler.parsers.empty());
+    parser.Feed("ne\n", 3);
+    CHECK(!parser.HasPartialLine());
+    CHECK_EQUAL(1u, handler.parsers.size());
+}
+
 bool ProcessOutputTestHelper(dbg_mi::CommandExecutor &exec, dbg_mi::CommandID const &id, wxString const &command)
 {
     if(!exec.ProcessOutput(id.ToString() + command))
@@ -235,6 +399,63 @@ TEST(DebuggerOutputSequential)
           );
 }
 
+TEST(ExecutorProcessOutputChunks)
+{
+    MockCommandExecutor exec(false);
+    std::string const output = "10000000001^running\n10000000002^done,a=";
+    exec.ProcessOutput(output.c_str(), output.length());
+    CHECK(ProcessOutputTestResult(exec, dbg_mi::CommandID(1, 1), wxT("^running")));
+    CHECK(!exec.HasOutput());
+
+    exec.ProcessOutput("\"5\"\n", 4);
+    CHECK(ProcessOutputTestResult(exec, dbg_mi::CommandID(1, 2), wxT("^done,a=\"5\"")));
+}
+
+TEST(ParsedOutputKeepsOrder)
+{
+    dbg_mi::ParsedOutput first, second;
+    dbg_mi::OutputParser parser(first);
+    std::string const output = "10000000001^done\n~\"console\"\n*stopped,reason=\"end\"\n10000000002^do";
+    parser.Feed(output.c_str(), output.length());
+    // the line split between the batches goes to the second one
+    parser.SetHandler(second);
+    parser.Feed("ne\n", 3);
+
+    CHECK_EQUAL(3, first.GetCount());
+    CHECK_EQUAL(1, second.GetCount());
+
+    OutputParserHandler handler;
+    first.Deliver(handler);
+    second.Deliver(handler);
+    CHECK(first.Empty());
+    CHECK_EQUAL(1, handler.unknown);
+    CHECK_EQUAL(3u, handler.parsers.size());
+    if(handler.parsers.size() == 3)
+    {
+        CHECK_EQUAL(dbg_mi::CommandID(1, 1), handler.ids[0]);
+        CHECK(handler.parsers[1] && handler.parsers[1]->GetResultClass() == dbg_mi::ResultParser::ClassStopped);
+        CHECK_EQUAL(dbg_mi::CommandID(1, 2), handler.ids[2]);
+        CHECK(handler.parsers[2] && handler.parsers[2]->GetResultClass() == dbg_mi::ResultParser::ClassDone);
+    }
+}
+
+TEST(ExecutorProcessParsedOutput)
+{
+    MockCommandExecutor exec(false);
+    dbg_mi::CommandID const id = exec.Execute(wxT("-exec-run"));
+
+    dbg_mi::ParsedOutput batch;
+    dbg_mi::OutputParser parser(batch);
+    std::string const output = id.ToString().utf8_str().data() + std::string("^running\n*running,thread-id=\"all\"\n");
+    parser.Feed(output.c_str(), output.length());
+    exec.ProcessOutput(batch);
+
+    CHECK(batch.Empty());
+    CHECK_EQUAL(0, exec.GetInFlightCount());
+    CHECK(ProcessOutputTestResult(exec, id, wxT("^running")));
+    CHECK(exec.HasOutput());
+}
+
 struct TestAction : public dbg_mi::Action
 {
     TestAction(bool *destroyed = NULL) :
@@ -394,6 +615,20 @@ TEST_FIXTURE(ActionsMapFixture, ActionDestroyed)
     CHECK(action_destroyed);
 }
 
+TEST_FIXTURE(ActionsMapFixture, FindAfterDestroyed)
+{
+    CHECK(actions_map.Find(actions_id) == action);
+    action->Finish();
+    actions_map.Run(exec);
+    CHECK(actions_map.Find(actions_id) == NULL);
+}
+
+TEST_FIXTURE(ActionsMapFixture, FindAfterClear)
+{
+    actions_map.Clear();
+    CHECK(actions_map.Find(actions_id) == NULL);
+}
+
 struct TestAction2 : dbg_mi::Action
 {
     TestAction2(bool correct_start, int32_t &last_started, int &executed) :
@@ -569,6 +804,25 @@ TEST_FIXTURE(DispatcherFixture, AsyncNotifications)
     CHECK(on_notify.notify_async);
 }
 
+TEST(DispatchResultsSkipsUnparsedRecords)
+{
+    dbg_mi::ActionsMap actions_map;
+    MockCommandExecutor exec;
+    DispatchOnNotify on_notify;
+
+    DispatchedAction *action = new DispatchedAction;
+    actions_map.Add(action);
+    action->Execute(wxT("-exec-run"));
+    dbg_mi::CommandID const id = action->Execute(wxT("-exec-run"));
+    actions_map.Run(exec);
+
+    exec.ProcessOutput(dbg_mi::CommandID(action->GetID(), 0).ToString() + wxT("^done,a={"));
+    exec.ProcessOutput(id.ToString() + wxT("^done"));
+    CHECK(!dbg_mi::DispatchResults(exec, actions_map, on_notify));
+    CHECK_EQUAL(id, action->dispatched_id);
+    CHECK(!exec.HasOutput());
+}
+
 struct DelayedDependencyAction : public dbg_mi::Action
 {
 public:
@@ -648,6 +902,390 @@ TEST(DelayedAction)
     CHECK(dependency_finished);
 }
 
+struct CountingAction : public dbg_mi::Action
+{
+    CountingAction() : count(0) {}
+    virtual void OnCommandOutput(dbg_mi::CommandID const &/*id*/, dbg_mi::ResultParser const &/*result*/)
+    {
+        ++count;
+    }
+protected:
+    virtual void OnStart() {}
+public:
+    int count;
+};
+
+struct MultiCommandAction : public dbg_mi::Action
+{
+    MultiCommandAction(int count) : m_count(count) {}
+    virtual void OnCommandOutput(dbg_mi::CommandID const &/*id*/, dbg_mi::ResultParser const &/*result*/) {}
+protected:
+    virtual void OnStart()
+    {
+        for(int ii = 0; ii < m_count; ++ii)
+            Execute(wxT("-break-insert main.cpp:10"));
+        Finish();
+    }
+private:
+    int m_count;
+};
+
+TEST(ActionsMapInFlightWindow)
+{
+    dbg_mi::ActionsMap actions_map;
+    MockCommandExecutor exec(false);
+    exec.SetMaxInFlight(2);
+
+    MultiCommandAction *action = new MultiCommandAction(3);
+    actions_map.Add(action);
+    int const action_id = action->GetID();
+    actions_map.Add(new MultiCommandAction(1));
+
+    actions_map.Run(exec);
+    CHECK_EQUAL(2, exec.GetInFlightCount());
+    CHECK(!exec.CanExecute());
+    // the finished action must stay until all its commands are sent
+    CHECK(actions_map.Find(action_id) != NULL);
+
+    CHECK(exec.ProcessOutput(dbg_mi::CommandID(action_id, 0).ToString() + wxT("^done")));
+    CHECK_EQUAL(1, exec.GetInFlightCount());
+    actions_map.Run(exec);
+    CHECK_EQUAL(2, exec.GetInFlightCount());
+    CHECK(actions_map.Find(action_id) == NULL);
+
+    CHECK(exec.ProcessOutput(dbg_mi::CommandID(action_id, 1).ToString() + wxT("^done")));
+    actions_map.Run(exec);
+    CHECK_EQUAL(2, exec.GetInFlightCount());
+    CHECK(actions_map.Empty());
+}
+
+TEST(ActionsMapRunSingleBatch)
+{
+    dbg_mi::ActionsMap actions_map;
+    MockCommandExecutor exec(false);
+    actions_map.Add(new MultiCommandAction(2));
+    actions_map.Add(new MultiCommandAction(3));
+
+    actions_map.Run(exec);
+    CHECK_EQUAL(1, exec.GetFlushCount());
+    CHECK_EQUAL(5, exec.GetInFlightCount());
+}
+
+TEST(ActionsMapHighPriorityFirst)
+{
+    dbg_mi::ActionsMap actions_map;
+    MockCommandExecutor exec(false);
+    exec.SetMaxInFlight(4);
+
+    MultiCommandAction *low = new MultiCommandAction(4);
+    low->SetPriority(dbg_mi::Action::PriorityLow);
+    actions_map.Add(low);
+    MultiCommandAction *high = new MultiCommandAction(1);
+    high->SetPriority(dbg_mi::Action::PriorityHigh);
+    actions_map.Add(high);
+    int const high_id = high->GetID();
+
+    // the high priority action is sent first and the low one leaves the last quarter of the window free
+    actions_map.Run(exec);
+    CHECK(actions_map.Find(high_id) == NULL);
+    CHECK_EQUAL(3, exec.GetInFlightCount());
+    CHECK_EQUAL(2, low->GetPendingCommandsCount());
+
+    MultiCommandAction *user = new MultiCommandAction(1);
+    user->SetPriority(dbg_mi::Action::PriorityHigh);
+    actions_map.Add(user);
+    actions_map.Run(exec);
+    CHECK_EQUAL(4, exec.GetInFlightCount());
+    CHECK_EQUAL(2, low->GetPendingCommandsCount());
+}
+
+TEST(ActionsMapPriorityStopsAtBarrier)
+{
+    dbg_mi::ActionsMap actions_map;
+    MockCommandExecutor exec(false);
+
+    CountingAction *normal = new CountingAction;
+    actions_map.Add(normal);
+    CountingAction *barrier = new CountingAction;
+    barrier->SetWaitPrevious(true);
+    actions_map.Add(barrier);
+    CountingAction *high = new CountingAction;
+    high->SetPriority(dbg_mi::Action::PriorityHigh);
+    actions_map.Add(high);
+
+    actions_map.Run(exec);
+    CHECK(normal->Started());
+    CHECK(!barrier->Started());
+    CHECK(!high->Started());
+
+    normal->Finish();
+    actions_map.Run(exec);
+    CHECK(barrier->Started());
+    CHECK(high->Started());
+}
+
+TEST(ActionsMapUnlimitedWindowDoesntLimitPriorities)
+{
+    dbg_mi::ActionsMap actions_map;
+    MockCommandExecutor exec(false);
+
+    MultiCommandAction *low = new MultiCommandAction(200);
+    low->SetPriority(dbg_mi::Action::PriorityLow);
+    actions_map.Add(low);
+
+    actions_map.Run(exec);
+    CHECK_EQUAL(200, exec.GetInFlightCount());
+    CHECK(actions_map.Empty());
+}
+
+TEST(ActionsMapSelectionWaitsForFrameCommands)
+{
+    dbg_mi::ActionsMap actions_map;
+    MockCommandExecutor exec(false);
+    exec.SetMaxInFlight(4);
+
+    MultiCommandAction *create = new MultiCommandAction(4);
+    create->SetUsesFrame(true);
+    actions_map.Add(create);
+    int const create_id = create->GetID();
+    CountingAction *select = new CountingAction;
+    select->SetPriority(dbg_mi::Action::PriorityHigh);
+    select->SetSelectsFrame(true);
+    actions_map.Add(select);
+    MultiCommandAction *update = new MultiCommandAction(1);
+    update->SetUsesFrame(true);
+    actions_map.Add(update);
+
+    // the last command of the earlier action would be evaluated in the new frame, if the selection went first
+    actions_map.Run(exec);
+    CHECK_EQUAL(3, exec.GetInFlightCount());
+    CHECK(!select->Started());
+    CHECK(!update->Started());
+
+    CHECK(exec.ProcessOutput(dbg_mi::CommandID(create_id, 0).ToString() + wxT("^done")));
+    actions_map.Run(exec);
+    CHECK(actions_map.Find(create_id) == NULL);
+    CHECK(select->Started());
+    CHECK(update->Started());
+}
+
+struct CancelableAction : MultiCommandAction
+{
+    CancelableAction(int count) : MultiCommandAction(count), output_count(0) {}
+    virtual void OnCommandOutput(dbg_mi::CommandID const &/*id*/, dbg_mi::ResultParser const &/*result*/)
+    {
+        ++output_count;
+    }
+    virtual bool CanCancelStarted() const { return true; }
+
+    int output_count;
+};
+
+TEST(ActionsMapNewGenerationDropsUnstartedActions)
+{
+    dbg_mi::ActionsMap actions_map;
+    MockCommandExecutor exec(false);
+
+    CountingAction *barrier = new CountingAction;
+    actions_map.Add(barrier);
+    MultiCommandAction *refresh = new MultiCommandAction(2);
+    refresh->SetWaitPrevious(true);
+    refresh->SetGeneration(actions_map.GetGeneration());
+    actions_map.Add(refresh);
+    MultiCommandAction *other = new MultiCommandAction(1);
+    actions_map.Add(other);
+    int const refresh_id = refresh->GetID();
+
+    actions_map.Run(exec);
+    CHECK(!refresh->Started());
+    actions_map.NewGeneration();
+    CHECK(refresh->Canceled());
+    CHECK(!other->Canceled());
+
+    barrier->Finish();
+    actions_map.Run(exec);
+    CHECK(actions_map.Find(refresh_id) == NULL);
+    CHECK(actions_map.Empty());
+    // only the command of the action, which isn't tied to a stop
+    CHECK_EQUAL(1, exec.GetInFlightCount());
+}
+
+TEST(ActionsMapNewGenerationDiscardsResults)
+{
+    dbg_mi::ActionsMap actions_map;
+    MockCommandExecutor exec(false);
+    exec.SetMaxInFlight(2);
+    DispatchOnNotify on_notify;
+
+    CountingAction *started = new CountingAction;
+    started->SetGeneration(actions_map.GetGeneration());
+    actions_map.Add(started);
+    CancelableAction *refresh = new CancelableAction(3);
+    refresh->SetGeneration(actions_map.GetGeneration());
+    actions_map.Add(refresh);
+    int const refresh_id = refresh->GetID();
+
+    actions_map.Run(exec);
+    CHECK_EQUAL(2, exec.GetInFlightCount());
+    actions_map.NewGeneration();
+    CHECK(refresh->Canceled());
+    // the actions, which can't be canceled after they have started, are left to finish
+    CHECK(!started->Canceled());
+
+    CHECK(exec.ProcessOutput(dbg_mi::CommandID(refresh_id, 0).ToString() + wxT("^done")));
+    CHECK(dbg_mi::DispatchResults(exec, actions_map, on_notify));
+    CHECK_EQUAL(0, refresh->output_count);
+
+    actions_map.Run(exec);
+    CHECK(actions_map.Find(refresh_id) == NULL);
+    // the third command isn't sent
+    CHECK_EQUAL(1, exec.GetInFlightCount());
+    CHECK(exec.ProcessOutput(dbg_mi::CommandID(refresh_id, 1).ToString() + wxT("^done")));
+    CHECK(dbg_mi::DispatchResults(exec, actions_map, on_notify));
+    CHECK_EQUAL(0, exec.GetInFlightCount());
+    CHECK(actions_map.Find(started->GetID()) != NULL);
+}
+
+TEST(ActionsMapStaleActionIsCanceledWhenAdded)
+{
+    dbg_mi::ActionsMap actions_map;
+    MockCommandExecutor exec(false);
+    int const generation = actions_map.GetGeneration();
+    actions_map.NewGeneration();
+
+    MultiCommandAction *stale = new MultiCommandAction(1);
+    stale->SetGeneration(generation);
+    actions_map.Add(stale);
+    MultiCommandAction *current = new MultiCommandAction(1);
+    current->SetGeneration(actions_map.GetGeneration());
+    actions_map.Add(current);
+
+    CHECK(stale->Canceled());
+    CHECK(!current->Canceled());
+    actions_map.Run(exec);
+    CHECK(actions_map.Empty());
+    CHECK_EQUAL(1, exec.GetInFlightCount());
+}
+
+TEST(CommandExecutorLatency)
+{
+    MockCommandExecutor exec(false);
+    exec.SetTimestamp(100);
+    dbg_mi::CommandID id1 = exec.Execute(wxT("-exec-run"));
+    dbg_mi::CommandID id2 = exec.Execute(wxT("-exec-run"));
+
+    exec.SetTimestamp(130);
+    CHECK(exec.ProcessOutput(id1.ToString() + wxT("^running")));
+    // async records with the same token don't finish the command again
+    CHECK(exec.ProcessOutput(id1.ToString() + wxT("*stopped")));
+    exec.SetTimestamp(150);
+    CHECK(exec.ProcessOutput(id2.ToString() + wxT("^done")));
+
+    dbg_mi::CommandExecutor::LatencyStats const &stats = exec.GetLatencyStats();
+    CHECK_EQUAL(2, stats.count);
+    CHECK_EQUAL(80, stats.total);
+    CHECK_EQUAL(50, stats.max);
+    CHECK_EQUAL(50, stats.last);
+    CHECK_EQUAL(0, exec.GetInFlightCount());
+}
+
+TEST(CommandExecutorStatsPerClass)
+{
+    MockCommandExecutor exec(false);
+    exec.SetTimestamp(1000);
+    dbg_mi::CommandID id1 = exec.Execute(wxT("-break-insert main.cpp:10"));
+    dbg_mi::CommandID id2 = exec.Execute(wxT("-exec-run"));
+
+    exec.SetTimestamp(1200);
+    CHECK(exec.ProcessOutput(id1.ToString() + wxT("^done")));
+    exec.SetTimestamp(1700);
+    CHECK(exec.ProcessOutput(id2.ToString() + wxT("^running")));
+    CHECK(exec.ProcessOutput(wxT("*stopped")));
+
+    dbg_mi::CommandStats::Classes const &classes = exec.GetStats().GetClasses();
+    dbg_mi::CommandStats::Classes::const_iterator it = classes.find(wxT("-break-insert"));
+    CHECK(it != classes.end());
+    CHECK_EQUAL(1, it->second.latency.GetCount());
+    CHECK_EQUAL(200, it->second.latency.GetMax());
+    CHECK_EQUAL(int64_t((id1.ToString() + wxT("-break-insert main.cpp:10")).length() + 1), it->second.bytes_out);
+    CHECK_EQUAL(int64_t((id1.ToString() + wxT("^done")).length() + 1), it->second.bytes_in);
+
+    it = classes.find(wxT("-exec-run"));
+    CHECK(it != classes.end());
+    CHECK_EQUAL(700, it->second.latency.GetMax());
+
+    it = classes.find(dbg_mi::CommandStats::c_async_class);
+    CHECK(it != classes.end());
+    CHECK_EQUAL(int64_t(wxString(wxT("*stopped")).length() + 1), it->second.bytes_in);
+
+    exec.Clear();
+    CHECK(exec.GetStats().GetClasses().empty());
+}
+
+TEST(ReplayCommandExecutorTokens)
+{
+    std::istringstream log("[12:00:00.000] cmd==>70000000003-var-update 1 *\n"
+                           "[12:00:00.001] output==>*stopped,reason=\"end-stepping-range\"\n"
+                           "[12:00:00.002] output==>70000000003^done,changelist=[]\n");
+    ReplayCommandExecutor exec;
+    exec.LoadDebugLog(log);
+    CHECK_EQUAL(1u, exec.GetRecordedCommands().size());
+    CHECK_EQUAL(7, exec.GetRecordedCommands()[0].action);
+    CHECK_EQUAL(2, exec.GetOutputLineCount());
+
+    // the result waits for its command
+    CHECK_EQUAL(1, exec.Replay());
+    CHECK(!exec.IsFinished());
+
+    dbg_mi::ActionsMap actions_map;
+    TestAction *action = new TestAction;
+    action->Execute(wxT("-var-update 1 *"));
+    actions_map.Add(action);
+    actions_map.Run(exec);
+
+    CHECK_EQUAL(1, exec.Replay());
+    CHECK(exec.IsFinished());
+
+    dbg_mi::CommandID id;
+    delete exec.GetResult(id);
+    CHECK_EQUAL(dbg_mi::CommandID(), id);
+
+    dbg_mi::ResultParser *result = exec.GetResult(id);
+    CHECK_EQUAL(dbg_mi::CommandID(action->GetID(), 0), id);
+    CHECK(result && result->GetResultClass() == dbg_mi::ResultParser::ClassDone);
+    delete result;
+}
+
+TEST(DispatchResultsToManyActions)
+{
+    int const action_count = 100;
+    int const result_count = 1000;
+
+    dbg_mi::ActionsMap actions_map;
+    std::vector<CountingAction*> actions;
+    for(int ii = 0; ii < action_count; ++ii)
+    {
+        actions.push_back(new CountingAction);
+        actions_map.Add(actions.back());
+    }
+
+    std::string output;
+    for(int ii = 0; ii < result_count; ++ii)
+    {
+        dbg_mi::CommandID id(actions[(ii * 7) % action_count]->GetID(), ii);
+        output += id.ToString().utf8_str().data();
+        output += "^done\n";
+    }
+
+    MockCommandExecutor exec(false);
+    DispatchOnNotify on_notify;
+    exec.ProcessOutput(output.c_str(), output.length());
+    CHECK(dbg_mi::DispatchResults(exec, actions_map, on_notify));
+
+    for(int ii = 0; ii < action_count; ++ii)
+        CHECK_EQUAL(result_count / action_count, actions[ii]->count);
+}
+
 struct LoggingFixture
 {
     LoggingFixture()
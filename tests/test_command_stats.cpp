@@ -0,0 +1,64 @@
+#include <UnitTest++.h>
+
+#include "command_stats.h"
+
+#include "common.h"
+
+TEST(LatencyHistogramEmpty)
+{
+    dbg_mi::LatencyHistogram histogram;
+    CHECK_EQUAL(0, histogram.GetCount());
+    CHECK_EQUAL(0, histogram.GetPercentile(50));
+    CHECK_EQUAL(0, histogram.GetPercentile(99));
+}
+
+TEST(LatencyHistogramSmallValuesAreExact)
+{
+    dbg_mi::LatencyHistogram histogram;
+    for(int ii = 0; ii < 8; ++ii)
+        histogram.Add(ii);
+
+    CHECK_EQUAL(8, histogram.GetCount());
+    CHECK_EQUAL(28, histogram.GetTotal());
+    CHECK_EQUAL(3, histogram.GetPercentile(50));
+    CHECK_EQUAL(7, histogram.GetPercentile(99));
+    CHECK_EQUAL(7, histogram.GetMax());
+}
+
+TEST(LatencyHistogramPercentiles)
+{
+    dbg_mi::LatencyHistogram histogram;
+    for(int ii = 1; ii <= 1000; ++ii)
+        histogram.Add(ii * 100);
+
+    int64_t const p50 = histogram.GetPercentile(50);
+    int64_t const p99 = histogram.GetPercentile(99);
+    CHECK(p50 >= 50000 && p50 <= 50000 * 5 / 4);
+    CHECK(p99 >= 99000 && p99 <= 100000);
+    CHECK_EQUAL(100000, histogram.GetPercentile(100));
+}
+
+TEST(LatencyHistogramHugeValue)
+{
+    dbg_mi::LatencyHistogram histogram;
+    histogram.Add(int64_t(1) << 50);
+    CHECK_EQUAL(int64_t(1) << 50, histogram.GetPercentile(50));
+}
+
+TEST(CommandStatsCommandClass)
+{
+    CHECK_EQUAL(wxT("-var-update"), dbg_mi::CommandStats::GetCommandClass(wxT("-var-update 1 *")));
+    CHECK_EQUAL(wxT("-exec-next"), dbg_mi::CommandStats::GetCommandClass(wxT("-exec-next")));
+}
+
+TEST(CommandStatsReport)
+{
+    dbg_mi::CommandStats stats;
+    stats.Get(wxT("-exec-next")).latency.Add(1500);
+    stats.Get(wxT("-var-update")).bytes_out = 20;
+
+    wxString const report = stats.MakeReport();
+    CHECK(report.find(wxT("-exec-next")) != wxString::npos);
+    CHECK(report.find(wxT("1.500")) != wxString::npos);
+    CHECK(report.find(wxT("-var-update")) != wxString::npos);
+}
@@ -95,3 +95,157 @@ TEST_FIXTURE(FindWatchFixture, Var1_public_b_private_b)
     cb::shared_ptr<dbg_mi::Watch> w = dbg_mi::FindWatch(wxT("var2.public.b.private.b"), watches);
     CHECK(w && w->GetID() == wxT("var2.public.b.private.b"));
 }
+
+TEST_FIXTURE(FindWatchFixture, AddedChild)
+{
+    cb::shared_ptr<dbg_mi::Watch> parent = dbg_mi::FindWatch(wxT("var3"), watches);
+    cb::shared_ptr<dbg_mi::Watch> child = MakeWatch(wxT("var3.x"), wxT("var3.x"));
+    cbWatch::AddChild(parent, child);
+    watches.Register(child);
+
+    CHECK(dbg_mi::FindWatch(wxT("var3.x"), watches) == child);
+}
+
+TEST_FIXTURE(FindWatchFixture, RemovedChildren)
+{
+    cb::shared_ptr<dbg_mi::Watch> w = dbg_mi::FindWatch(wxT("var2.public.b"), watches);
+    watches.RemoveChildren(w);
+
+    CHECK(!dbg_mi::FindWatch(wxT("var2.public.b.private.a"), watches));
+    CHECK(!dbg_mi::FindWatch(wxT("var2.public.b.private.b"), watches));
+    CHECK(dbg_mi::FindWatch(wxT("var2.public.b"), watches) == w);
+}
+
+TEST_FIXTURE(FindWatchFixture, RemovedMarkedChildren)
+{
+    cb::shared_ptr<dbg_mi::Watch> w = dbg_mi::FindWatch(wxT("var2.public.b"), watches);
+    w->GetChild(0)->MarkAsRemoved(true);
+    watches.RemoveMarkedChildren(w);
+
+    CHECK(!dbg_mi::FindWatch(wxT("var2.public.b.private.a"), watches));
+    CHECK(dbg_mi::FindWatch(wxT("var2.public.b.private.b"), watches));
+}
+
+TEST_FIXTURE(FindWatchFixture, Erased)
+{
+    watches.erase(watches.begin());
+
+    CHECK(!dbg_mi::FindWatch(wxT("var1"), watches));
+    CHECK(!dbg_mi::FindWatch(wxT("var1.public.c.private.a"), watches));
+    CHECK(dbg_mi::FindWatch(wxT("var2.public.b"), watches));
+}
+
+TEST_FIXTURE(FindWatchFixture, ResetWatch)
+{
+    cb::shared_ptr<dbg_mi::Watch> w = dbg_mi::FindWatch(wxT("var3"), watches);
+    w->Reset();
+    CHECK(!dbg_mi::FindWatch(wxT("var3"), watches));
+}
+
+TEST(FetchedRanges_Merge)
+{
+    dbg_mi::FetchedRanges ranges;
+    ranges.Add(100, 150);
+    ranges.Add(0, 50);
+    CHECK_EQUAL(50, ranges.GetFirstMissing());
+    CHECK(!ranges.Contains(50, 100));
+
+    ranges.Add(50, 100);
+    CHECK_EQUAL(150, ranges.GetFirstMissing());
+    CHECK(ranges.Contains(20, 140));
+    CHECK_EQUAL(150, ranges.GetEnd());
+}
+
+TEST(FetchedRanges_Gap)
+{
+    dbg_mi::FetchedRanges ranges;
+    CHECK_EQUAL(0, ranges.GetFirstMissing());
+
+    ranges.Add(50, 100);
+    CHECK_EQUAL(0, ranges.GetFirstMissing());
+    CHECK(ranges.Contains(60, 100));
+    CHECK(!ranges.Contains(40, 60));
+    CHECK(!ranges.Contains(60, 101));
+
+    ranges.Clear();
+    CHECK(ranges.IsEmpty());
+}
+
+TEST(TooltipCache_ReuseWhileStopped)
+{
+    dbg_mi::TooltipCache cache;
+    cb::shared_ptr<dbg_mi::Watch> w(MakeWatch(wxT("a"), wxT("var1")));
+    cache.Add(w, wxT("a"), 1, 0);
+    // the tooltip is still shown
+    CHECK(!cache.Acquire(wxT("a"), 1, 0));
+
+    dbg_mi::TooltipCache::Watches evicted;
+    CHECK(cache.Release(w, evicted));
+    CHECK(evicted.empty());
+    CHECK(!cache.Acquire(wxT("a"), 2, 0));
+    CHECK(!cache.Acquire(wxT("a"), 1, 1));
+    CHECK(!cache.Acquire(wxT("b"), 1, 0));
+    CHECK(cache.Acquire(wxT("a"), 1, 0) == w);
+    CHECK(!cache.Acquire(wxT("a"), 1, 0));
+}
+
+TEST(TooltipCache_NewGeneration)
+{
+    dbg_mi::TooltipCache cache;
+    cb::shared_ptr<dbg_mi::Watch> dismissed(MakeWatch(wxT("a"), wxT("var1")));
+    cb::shared_ptr<dbg_mi::Watch> shown(MakeWatch(wxT("b"), wxT("var2")));
+    cache.Add(dismissed, wxT("a"), 1, 0);
+    cache.Add(shown, wxT("b"), 1, 0);
+    dbg_mi::TooltipCache::Watches evicted;
+    CHECK(cache.Release(dismissed, evicted));
+
+    dbg_mi::TooltipCache::Watches stale;
+    cache.NewGeneration(stale);
+    CHECK_EQUAL(1u, stale.size());
+    CHECK(stale[0] == dismissed);
+    CHECK(!cache.Acquire(wxT("a"), 1, 0));
+    // the tooltip of the old stop is deleted, when it is dismissed
+    CHECK(!cache.Release(shown, evicted));
+}
+
+TEST(TooltipCache_ReleaseWithoutVarObject)
+{
+    dbg_mi::TooltipCache cache;
+    cb::shared_ptr<dbg_mi::Watch> w(new dbg_mi::Watch(wxT("a"), true));
+    cache.Add(w, wxT("a"), 1, 0);
+    dbg_mi::TooltipCache::Watches evicted;
+    CHECK(!cache.Release(w, evicted));
+    CHECK_EQUAL(0u, cache.size());
+}
+
+TEST(TooltipCache_EvictsOldest)
+{
+    dbg_mi::TooltipCache cache;
+    dbg_mi::TooltipCache::Watches watches, evicted;
+    for (int ii = 0; ii <= dbg_mi::c_tooltip_cache_size; ++ii)
+    {
+        wxString const symbol = wxString::Format(wxT("s%d"), ii);
+        watches.push_back(MakeWatch(symbol, wxString::Format(wxT("var%d"), ii)));
+        cache.Add(watches.back(), symbol, 1, 0);
+        CHECK(cache.Release(watches.back(), evicted));
+    }
+    CHECK_EQUAL(1u, evicted.size());
+    CHECK(evicted[0] == watches[0]);
+    CHECK(!cache.Acquire(wxT("s0"), 1, 0));
+    CHECK(cache.Acquire(wxT("s1"), 1, 0) == watches[1]);
+}
+
+TEST(TooltipCache_Prefetched)
+{
+    dbg_mi::TooltipCache cache;
+    cb::shared_ptr<dbg_mi::Watch> w(new dbg_mi::Watch(wxT("a"), true));
+    cache.AddPrefetched(w, wxT("a"), 1, 0);
+    // the varobj hasn't been created yet
+    CHECK(!cache.Acquire(wxT("a"), 1, 0));
+
+    w->SetID(wxT("var1"));
+    CHECK(cache.Acquire(wxT("a"), 1, 0) == w);
+    dbg_mi::TooltipCache::Watches evicted;
+    CHECK(cache.Release(w, evicted));
+    CHECK(cache.Acquire(wxT("a"), 1, 0) == w);
+}
@@ -25,3 +25,43 @@ TEST(ParseParentPID_parens)
                   "140737340978176 0 0 16781312 0 0 0 0 17 2 0 0 0 0 0";
     CHECK_EQUAL(6961, dbg_mi::ParseParentPID(line));
 }
+
+TEST(AddThreadOption)
+{
+    CHECK_EQUAL(wxT("-exec-next --thread 3"), dbg_mi::AddThreadOption(wxT("-exec-next"), 3));
+    CHECK_EQUAL(wxT("-exec-continue --all"), dbg_mi::AddThreadOption(wxT("-exec-continue"), -1));
+    CHECK_EQUAL(wxT("-exec-until --thread 12 main.cpp:10"), dbg_mi::AddThreadOption(wxT("-exec-until main.cpp:10"), 12));
+}
+
+TEST(QuoteString)
+{
+    CHECK_EQUAL(wxT("\"i > 5\""), dbg_mi::QuoteString(wxT("i > 5")));
+    CHECK_EQUAL(wxT("\"s == \\\"a\\\\b\\\"\""), dbg_mi::QuoteString(wxT("s == \"a\\b\"")));
+}
+
+TEST(ExtractIdentifiers)
+{
+    std::vector<wxString> identifiers;
+    dbg_mi::ExtractIdentifiers(wxT("    for (int ii = 0; ii < count; ++ii) // the rest"), identifiers);
+    CHECK_EQUAL(2u, identifiers.size());
+    CHECK_EQUAL(wxT("ii"), identifiers[0]);
+    CHECK_EQUAL(wxT("count"), identifiers[1]);
+
+    identifiers.clear();
+    dbg_mi::ExtractIdentifiers(wxT("total += std::max(a.value, ptr->size) + Get(\"str x\", 'c') /* y */ + 0x1f;"),
+                               identifiers);
+    CHECK_EQUAL(3u, identifiers.size());
+    CHECK_EQUAL(wxT("total"), identifiers[0]);
+    CHECK_EQUAL(wxT("a"), identifiers[1]);
+    CHECK_EQUAL(wxT("ptr"), identifiers[2]);
+
+    // the identifiers, which are already in the list, aren't added again
+    dbg_mi::ExtractIdentifiers(wxT("total = a > b;"), identifiers);
+    CHECK_EQUAL(4u, identifiers.size());
+    CHECK_EQUAL(wxT("b"), identifiers[3]);
+
+    identifiers.clear();
+    dbg_mi::ExtractIdentifiers(wxT("#include \"x.h\""), identifiers);
+    dbg_mi::ExtractIdentifiers(wxT("/* a comment, which doesn't end"), identifiers);
+    CHECK(identifiers.empty());
+}
@@ -1,3 +1,6 @@
+#include <cstdio>
+#include <cstring>
+#include <string>
 #include <tr1/memory>
 #include <UnitTest++.h>
 
@@ -152,6 +155,36 @@ TEST(TestGetNextToken15)
     CHECK(r && t == dbg_mi::Token(4, 15, dbg_mi::Token::String));
     CHECK(r && t.ExtractString(s) == _T("\"-\\\"ast\\\"-\""));
 }
+
+TEST(TestGetNextTokenUTF8)
+{
+    char const *s = "a = [5,\"sert\", 6],bdb={a = \"str\", b = 5}";
+    int length = strlen(s);
+    dbg_mi::Token t;
+    int pos = 0;
+    for(int ii = 0; ii < 6; ++ii)
+    {
+        CHECK(dbg_mi::GetNextToken(s, length, pos, t));
+        pos = t.end;
+    }
+    CHECK(t == dbg_mi::Token(7, 13, dbg_mi::Token::String));
+    CHECK(t.ExtractString(s) == _T("\"sert\""));
+}
+TEST(TestGetNextTokenUTF8_MultiByte)
+{
+    // "\xd0\xb0\xd0\xb1" is the UTF-8 encoding of two cyrillic letters
+    char const *s = "name=\"\xd0\xb0\xd0\xb1\",b=1";
+    dbg_mi::Token t;
+    CHECK(dbg_mi::GetNextToken(s, strlen(s), 5, t));
+    CHECK(t == dbg_mi::Token(5, 11, dbg_mi::Token::String));
+    CHECK(t.ExtractString(s) == wxString(wxT("\"\x0430\x0431\"")));
+}
+TEST(TestGetNextTokenUTF8_UnterminatedQuote)
+{
+    char const *s = "a=\"str";
+    dbg_mi::Token t;
+    CHECK(!dbg_mi::GetNextToken(s, strlen(s), 2, t));
+}
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 TEST(ResultValueMakeDebugString_Simple)
@@ -797,6 +830,36 @@ TEST(TestResultParser_NotifyAsync)
     CHECK_EQUAL(wxT(""), parser.GetResultValue().MakeDebugString());
 }
 
+TEST(TestResultParser_UTF8)
+{
+    char const *s = "^done,a=\"te\\\"st\",b={c=[1,2]}";
+    dbg_mi::ResultParser utf8_parser, parser;
+
+    CHECK(utf8_parser.Parse(s, strlen(s)));
+    CHECK(parser.Parse(wxString(s, wxConvUTF8)));
+    CHECK_EQUAL(dbg_mi::ResultParser::ClassDone, utf8_parser.GetResultClass());
+    CHECK(utf8_parser == parser);
+    CHECK_EQUAL(wxT("{a=te\"st,b={c=[1,2]}}"), utf8_parser.GetResultValue().MakeDebugString());
+}
+
+TEST(TestResultParser_UTF8NotifyAsync)
+{
+    char const *s = "=thread-created,id=\"2\",group-id=\"i1\"";
+    dbg_mi::ResultParser parser;
+
+    CHECK(parser.Parse(s, strlen(s)));
+    CHECK_EQUAL(dbg_mi::ResultParser::NotifyAsyncOutput, parser.GetResultType());
+    CHECK_EQUAL(wxT("thread-created"), parser.GetAsyncNotifyType());
+    CHECK_EQUAL(wxT("{id=2,group-id=i1}"), parser.GetResultValue().MakeDebugString());
+}
+
+TEST(TestParseValueUTF8_Fail)
+{
+    char const *s = "a = {b = 5, c =5]";
+    dbg_mi::ResultValue r;
+    CHECK(!dbg_mi::ParseValue(s, strlen(s), r));
+}
+
 TEST(TestResultParser_NotifyAsyncValue)
 {
     dbg_mi::ResultParser parser;
@@ -882,6 +945,164 @@ TEST(ResultParserInequallityOperator)
     CHECK(r1 && r2);
     CHECK(p1 != p2);
 }
+
+TEST(ResultParserCopyOutlivesOriginal)
+{
+    dbg_mi::ResultParser *p1 = new dbg_mi::ResultParser;
+    CHECK(p1->Parse(_T("^done,a={b=\"\xe4\xf6\",c=[1,2]}")));
+    dbg_mi::ResultParser p2(*p1);
+    delete p1;
+
+    CHECK_EQUAL(wxT("{a={b=\xe4\xf6,c=[1,2]}}"), p2.GetResultValue().MakeDebugString());
+    dbg_mi::ResultValue const *b = p2.GetResultValue().GetTupleValue(wxT("a.b"));
+    CHECK(b && b->GetSimpleValue() == wxT("\xe4\xf6"));
+}
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+TEST(ResultArenaAlignment)
+{
+    dbg_mi::ResultArena arena;
+    for(int ii = 1; ii < 100; ++ii)
+    {
+        void *p = arena.Allocate(ii);
+        CHECK(p && reinterpret_cast<size_t>(p) % 16 == 0);
+    }
+}
+
+TEST(ResultArenaChunks)
+{
+    dbg_mi::ResultArena arena;
+    CHECK_EQUAL(0, arena.GetChunkCount());
+    arena.Allocate(16);
+    arena.Allocate(16);
+    CHECK_EQUAL(1, arena.GetChunkCount());
+
+    // the big block gets its own chunk and the small allocation still goes in the first one
+    char *big = static_cast<char*>(arena.Allocate(100000));
+    big[99999] = 'x';
+    CHECK_EQUAL(2, arena.GetChunkCount());
+    arena.Allocate(16);
+    CHECK_EQUAL(2, arena.GetChunkCount());
+}
+
+TEST(ResultArenaCopyString)
+{
+    dbg_mi::ResultArena arena;
+    char const *s = arena.CopyString("test", 4);
+    CHECK(std::strncmp(s, "test", 4) == 0);
+}
+
+TEST(ResultValueLargeArray)
+{
+    std::string s("a=[");
+    for(int ii = 0; ii < 10000; ++ii)
+    {
+        if(ii > 0)
+            s += ",";
+        s += "{name=\"var1.child\",value=\"5\"}";
+    }
+    s += "]";
+
+    dbg_mi::ResultValue result;
+    CHECK(dbg_mi::ParseValue(s.c_str(), s.length(), result));
+    dbg_mi::ResultValue const *a = result.GetTupleValue(wxT("a"));
+    CHECK(a && a->GetTupleSize() == 10000);
+    dbg_mi::ResultValue const *last = a ? a->GetTupleValueByIndex(9999) : NULL;
+    CHECK(last && last->GetTupleValue(wxT("value"))->GetSimpleValue() == wxT("5"));
+    CHECK(a && a->GetTupleValueByIndex(10000) == NULL);
+}
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+namespace
+{
+std::string MakeWideTuple(int count)
+{
+    std::string s;
+    char buf[64];
+    for(int ii = 0; ii < count; ++ii)
+    {
+        std::sprintf(buf, "%svar%d=\"%d\"", ii > 0 ? "," : "", ii, ii);
+        s += buf;
+    }
+    return s;
+}
+} // anonymous namespace
+
+TEST(ResultValueIndexedLookup)
+{
+    std::string s = MakeWideTuple(100) + ",var5=\"dup\",\xd0\xb0=\"cyr\",a={b={c=1}}";
+    dbg_mi::ResultValue result;
+    CHECK(dbg_mi::ParseValue(s.c_str(), s.length(), result));
+
+    for(int ii = 0; ii < 100; ++ii)
+    {
+        dbg_mi::ResultValue const *v = result.GetTupleValue(wxString::Format(wxT("var%d"), ii));
+        CHECK(v && v->GetSimpleValue() == wxString::Format(wxT("%d"), ii));
+    }
+    CHECK(result.GetTupleValue(wxT("var100")) == NULL);
+    CHECK(result.GetTupleValue(wxT("\x0430"))->GetSimpleValue() == wxT("cyr"));
+    CHECK(result.GetTupleValue(wxT("a.b.c"))->GetSimpleValue() == wxT("1"));
+}
+
+TEST(ResultValueIndexedLookup_AfterAppend)
+{
+    std::string s = MakeWideTuple(50);
+    dbg_mi::ResultValue result;
+    CHECK(dbg_mi::ParseValue(s.c_str(), s.length(), result));
+    CHECK(result.GetTupleValue(wxT("var49")) != NULL);
+
+    dbg_mi::ResultValue *v = new dbg_mi::ResultValue(wxT("new"), dbg_mi::ResultValue::Simple);
+    v->SetSimpleValue(wxT("5"));
+    result.SetTupleValue(v);
+    dbg_mi::ResultValue const *found = result.GetTupleValue(wxT("new"));
+    CHECK(found && found->GetSimpleValue() == wxT("5"));
+}
+
+TEST(ResultValueCompareWithoutConversion)
+{
+    std::string s = "child={name=\"var1.a\",numchild=\"-3\",dynamic=\"true\",\xd0\xb0=\"12x\",big=\"99999999999999999999\"}";
+    dbg_mi::ResultValue result;
+    CHECK(dbg_mi::ParseValue(s.c_str(), s.length(), result));
+
+    dbg_mi::ResultValue const *child = result.GetTupleValueByIndex(0);
+    CHECK(child->NameEquals("child"));
+    CHECK(!child->NameEquals("chil"));
+    CHECK(!child->NameEquals("children"));
+    CHECK(child->GetTupleValue(wxT("\x0430"))->NameEquals("\xd0\xb0"));
+
+    long value;
+    CHECK(child->GetTupleValue(wxT("numchild"))->ToLong(value) && value == -3);
+    CHECK(!child->GetTupleValue(wxT("name"))->ToLong(value));
+    CHECK(!child->GetTupleValue(wxT("\x0430"))->ToLong(value));
+    CHECK(!child->GetTupleValue(wxT("big"))->ToLong(value));
+
+    bool dynamic = false;
+    CHECK(dbg_mi::Lookup(*child, wxT("dynamic"), dynamic) && dynamic);
+    CHECK(child->GetTupleValue(wxT("dynamic"))->SimpleValueEquals("true"));
+}
+
+TEST(ResultValueConvertsStringsOnce)
+{
+    std::string s = "child={name=\"var1.a\",\xd0\xb0=\"\xd0\xb1\",exp=\"\"}";
+    dbg_mi::ResultValue result;
+    CHECK(dbg_mi::ParseValue(s.c_str(), s.length(), result));
+
+    dbg_mi::ResultValue const *child = result.GetTupleValueByIndex(0);
+    dbg_mi::ResultValue const *name = child->GetTupleValue(wxT("name"));
+    CHECK(name->GetSimpleValue() == wxT("var1.a"));
+    CHECK(&name->GetSimpleValue() == &name->GetSimpleValue());
+    CHECK(&child->GetName() == &child->GetName());
+    CHECK(child->GetTupleValue(wxT("\x0430"))->GetSimpleValue() == wxT("\x0431"));
+    CHECK(child->GetTupleValue(wxT("exp"))->GetSimpleValue().empty());
+
+    dbg_mi::ResultValue copy(*child);
+    CHECK(copy.GetTupleValue(wxT("name"))->GetSimpleValue() == wxT("var1.a"));
+    CHECK(copy.GetName() == wxT("child"));
+    copy.SetName(wxT("other"));
+    CHECK(copy.GetName() == wxT("other"));
+    CHECK(child->GetName() == wxT("child"));
+
+    wxString value;
+    CHECK(dbg_mi::Lookup(*child, wxString(wxT("name")), value) && value == wxT("var1.a"));
+}
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 TEST(LookupInt)
 {
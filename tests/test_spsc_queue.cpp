@@ -0,0 +1,58 @@
+#include <UnitTest++.h>
+
+#include "spsc_queue.h"
+
+TEST(SPSCQueueEmpty)
+{
+    dbg_mi::SPSCQueue<int, 4> queue;
+    int value = -1;
+    CHECK(queue.Empty());
+    CHECK(!queue.Pop(value));
+    CHECK_EQUAL(-1, value);
+}
+
+TEST(SPSCQueueOrder)
+{
+    dbg_mi::SPSCQueue<int, 4> queue;
+    CHECK(queue.Push(1));
+    CHECK(queue.Push(2));
+    CHECK(!queue.Empty());
+
+    int value;
+    CHECK(queue.Pop(value));
+    CHECK_EQUAL(1, value);
+    CHECK(queue.Pop(value));
+    CHECK_EQUAL(2, value);
+    CHECK(queue.Empty());
+}
+
+TEST(SPSCQueueFull)
+{
+    dbg_mi::SPSCQueue<int, 4> queue;
+    for(int ii = 0; ii < 4; ++ii)
+        CHECK(queue.Push(ii));
+    CHECK(!queue.Push(4));
+
+    int value;
+    CHECK(queue.Pop(value));
+    CHECK_EQUAL(0, value);
+    CHECK(queue.Push(4));
+    CHECK(!queue.Push(5));
+}
+
+TEST(SPSCQueueWrapAround)
+{
+    dbg_mi::SPSCQueue<int, 4> queue;
+    for(int ii = 0; ii < 100; ++ii)
+    {
+        CHECK(queue.Push(ii));
+        CHECK(queue.Push(ii + 1000));
+
+        int value;
+        CHECK(queue.Pop(value));
+        CHECK_EQUAL(ii, value);
+        CHECK(queue.Pop(value));
+        CHECK_EQUAL(ii + 1000, value);
+    }
+    CHECK(queue.Empty());
+}
@@ -0,0 +1,273 @@
+#include <UnitTest++.h>
+
+#include "actions.h"
+
+#include "common.h"
+#include "mock_logger.h"
+
+TEST(ThreadsContainerAddRemove)
+{
+    dbg_mi::ThreadsContainer threads;
+    threads.Add(1);
+    threads.Add(3);
+    threads.Add(2);
+    threads.Add(3);
+
+    CHECK_EQUAL(3u, threads.size());
+    CHECK_EQUAL(1, threads[0]->GetNumber());
+    CHECK_EQUAL(2, threads[1]->GetNumber());
+    CHECK_EQUAL(3, threads[2]->GetNumber());
+
+    threads.Remove(2);
+    threads.Remove(7);
+    CHECK_EQUAL(2u, threads.size());
+    CHECK_EQUAL(3, threads[1]->GetNumber());
+}
+
+TEST(ThreadsContainerSynchronize)
+{
+    dbg_mi::ThreadsContainer threads;
+    threads.Add(2);
+    CHECK(threads.SetInfo(2, wxT("Thread 0x1"), wxT("0x10 main() in a.cpp:5")));
+    CHECK(!threads.IsSynchronized());
+
+    std::vector<int> ids;
+    ids.push_back(3);
+    ids.push_back(2);
+    threads.Synchronize(ids);
+
+    CHECK(threads.IsSynchronized());
+    CHECK_EQUAL(2u, threads.size());
+    CHECK_EQUAL(wxT("Thread 0x1 0x10 main() in a.cpp:5"), threads[0]->GetInfo());
+    CHECK(!threads.IsStale(2));
+    CHECK(threads.IsStale(3));
+}
+
+TEST(ThreadsContainerCurrent)
+{
+    dbg_mi::ThreadsContainer threads;
+    threads.Add(1);
+    threads.Add(2);
+    threads.SetCurrent(2);
+    CHECK(!threads[0]->IsActive());
+    CHECK(threads[1]->IsActive());
+
+    threads.SetCurrent(1);
+    CHECK(threads[0]->IsActive());
+    CHECK(!threads[1]->IsActive());
+}
+
+TEST(ThreadsContainerStaleFrames)
+{
+    dbg_mi::ThreadsContainer threads;
+    for (int id = 1; id <= 5; ++id)
+    {
+        threads.Add(id);
+        threads.SetInfo(id, wxString::Format(wxT("Thread %d"), id), wxT("frame"));
+    }
+    threads.MarkFramesAsStale();
+    CHECK_EQUAL(wxT("Thread 1"), threads[0]->GetInfo());
+
+    threads.SetInfo(2, wxT("Thread 2"), wxT("frame"));
+    std::vector<int> stale;
+    threads.GetStaleThreads(0, 3, stale);
+    CHECK_EQUAL(2u, stale.size());
+    CHECK_EQUAL(1, stale[0]);
+    CHECK_EQUAL(3, stale[1]);
+}
+
+TEST(ThreadsContainerRunning)
+{
+    dbg_mi::ThreadsContainer threads;
+    for (int id = 1; id <= 3; ++id)
+    {
+        threads.Add(id);
+        threads.SetInfo(id, wxString::Format(wxT("Thread %d"), id), wxT("frame"));
+    }
+
+    threads.SetRunning(-1, true);
+    CHECK(threads.IsRunning(1) && threads.IsRunning(2) && threads.IsRunning(3));
+    CHECK_EQUAL(wxT("Thread 2 (running)"), threads[1]->GetInfo());
+
+    // non-stop mode: one thread has hit a breakpoint
+    threads.SetRunning(2, false);
+    threads.MarkFramesAsStale();
+    CHECK(!threads.IsRunning(2));
+    CHECK(threads.IsRunning(3));
+
+    std::vector<int> stale;
+    threads.GetStaleThreads(0, 3, stale);
+    CHECK_EQUAL(1u, stale.size());
+    CHECK_EQUAL(2, stale[0]);
+}
+
+TEST(GenerateThreadsListFirstStop)
+{
+    dbg_mi::ThreadsContainer threads;
+    MockLogger logger;
+    dbg_mi::GenerateThreadsList action(threads, 1, logger);
+    action.SetID(1);
+    action.Start();
+
+    dbg_mi::CommandID id;
+    CHECK_EQUAL(wxT("-thread-list-ids"), action.PopPendingCommand(id));
+    action.OnCommandOutput(id, MakeParser(wxT("^done,thread-ids={thread-id=\"2\",thread-id=\"1\"},")
+                                          wxT("current-thread-id=\"1\",number-of-threads=\"2\"")));
+    CHECK_EQUAL(2u, threads.size());
+    CHECK_EQUAL(2, action.GetPendingCommandsCount());
+    CHECK_EQUAL(wxT("-thread-info 1"), action.PopPendingCommand(id));
+    action.OnCommandOutput(id, MakeParser(wxT("^done,threads=[{id=\"1\",target-id=\"Thread 0x1\",")
+                                          wxT("frame={level=\"0\",addr=\"0x10\",func=\"main\",args=[],")
+                                          wxT("file=\"a.cpp\",fullname=\"/a.cpp\",line=\"5\"},")
+                                          wxT("state=\"stopped\"}],current-thread-id=\"1\"")));
+    CHECK(!action.Finished());
+    CHECK_EQUAL(wxT("-thread-info 2"), action.PopPendingCommand(id));
+    action.OnCommandOutput(id, MakeParser(wxT("^error,msg=\"Invalid thread id: 2\"")));
+
+    CHECK(action.Finished());
+    CHECK(threads[0]->IsActive());
+    CHECK_EQUAL(wxT("Thread 0x1 0x10 main() in a.cpp:5"), threads[0]->GetInfo());
+}
+
+TEST(GenerateThreadsListFetchesOnlyStalePage)
+{
+    dbg_mi::ThreadsContainer threads;
+    std::vector<int> ids;
+    for (int id = 1; id <= 3 * dbg_mi::c_threads_page_size; ++id)
+        ids.push_back(id);
+    threads.Synchronize(ids);
+    threads.SetInfo(1, wxT("Thread 1"), wxT("frame"));
+
+    MockLogger logger;
+    // the current thread is not in the first page
+    dbg_mi::GenerateThreadsList action(threads, 2 * dbg_mi::c_threads_page_size + 1, logger);
+    action.SetID(1);
+    action.Start();
+
+    CHECK_EQUAL(dbg_mi::c_threads_page_size, action.GetPendingCommandsCount());
+    dbg_mi::CommandID id;
+    CHECK_EQUAL(wxString::Format(wxT("-thread-info %d"), 2 * dbg_mi::c_threads_page_size + 1),
+                action.PopPendingCommand(id));
+    CHECK_EQUAL(wxT("-thread-info 2"), action.PopPendingCommand(id));
+}
+
+TEST(GenerateThreadsListFetchesAllPages)
+{
+    dbg_mi::ThreadsContainer threads;
+    std::vector<int> ids;
+    for (int id = 1; id <= 2 * dbg_mi::c_threads_page_size + 20; ++id)
+        ids.push_back(id);
+    threads.Synchronize(ids);
+    // the second page is up to date
+    for (int id = dbg_mi::c_threads_page_size + 1; id <= 2 * dbg_mi::c_threads_page_size; ++id)
+        threads.SetInfo(id, wxT("Thread"), wxT("frame"));
+
+    MockLogger logger;
+    dbg_mi::GenerateThreadsList action(threads, 1, logger);
+    action.SetID(1);
+    action.Start();
+
+    int const expected_pages[] = { dbg_mi::c_threads_page_size, 20 };
+    for (int page = 0; page < 2; ++page)
+    {
+        CHECK(!action.Finished());
+        CHECK_EQUAL(expected_pages[page], action.GetPendingCommandsCount());
+        // the next page is queued when the last output of this one arrives
+        for (int ii = 0; ii < expected_pages[page]; ++ii)
+        {
+            dbg_mi::CommandID id;
+            long thread_id = -1;
+            wxString const command = action.PopPendingCommand(id);
+            CHECK(command.StartsWith(wxT("-thread-info ")) && command.AfterFirst(wxT(' ')).ToLong(&thread_id));
+            action.OnCommandOutput(id, MakeParser(wxString::Format(wxT("^done,threads=[{id=\"%ld\",")
+                                                                   wxT("target-id=\"Thread\",")
+                                                                   wxT("frame={level=\"0\",addr=\"0x10\"}}]"),
+                                                                   thread_id)));
+        }
+    }
+    CHECK(action.Finished());
+    CHECK_EQUAL(wxT("Thread 0x10"), threads[threads.size() - 1]->GetInfo());
+}
+
+TEST(GenerateThreadsListNothingStale)
+{
+    dbg_mi::ThreadsContainer threads;
+    std::vector<int> ids(1, 1);
+    threads.Synchronize(ids);
+    threads.SetInfo(1, wxT("Thread 1"), wxT("frame"));
+
+    MockLogger logger;
+    dbg_mi::GenerateThreadsList action(threads, 1, logger);
+    action.SetID(1);
+    action.Start();
+    CHECK(!action.HasPendingCommands());
+    CHECK(action.Finished());
+}
+
+namespace
+{
+wxString MakeStack(int top_address)
+{
+    return wxString::Format(wxT("^done,stack=[frame={level=\"0\",addr=\"0x%x\",func=\"wait\",from=\"/lib/libc.so\"},")
+                            wxT("frame={level=\"1\",addr=\"0x400\",func=\"worker\",file=\"a.cpp\",")
+                            wxT("fullname=\"/a.cpp\",line=\"12\"}]"), top_address);
+}
+
+struct SnapshotCollector : dbg_mi::ThreadsSnapshotInvoker
+{
+    SnapshotCollector(wxString &report) : m_report(report) {}
+    virtual void Invoke(dbg_mi::ThreadsSnapshot const &snapshot) { m_report = snapshot.MakeReport(); }
+
+    wxString &m_report;
+};
+} // anonymous namespace
+
+TEST(ThreadsSnapshotGroupsIdenticalStacks)
+{
+    dbg_mi::ThreadsSnapshot snapshot;
+    for (int id = 1; id <= 1000; ++id)
+        CHECK(snapshot.AddThread(id, MakeParser(MakeStack(id == 7 ? 0x200 : 0x100)).GetResultValue()));
+    CHECK(!snapshot.AddThread(1001, MakeParser(wxT("^error,msg=\"Selected thread is running.\""))
+                                        .GetResultValue()));
+
+    CHECK_EQUAL(1000, snapshot.GetThreadCount());
+    dbg_mi::ThreadsSnapshot::Groups const groups = snapshot.GetGroups();
+    CHECK_EQUAL(2u, groups.size());
+    CHECK_EQUAL(999u, groups[0].threads.size());
+    CHECK_EQUAL(2u, groups[0].frames.size());
+    CHECK_EQUAL(wxT("#1   0x0000000000000400 in worker at a.cpp:12"), groups[0].frames[1]);
+    CHECK_EQUAL(1u, groups[1].threads.size());
+    CHECK_EQUAL(7, groups[1].threads[0]);
+
+    wxString const report = snapshot.MakeReport();
+    CHECK(report.find(wxT("999 threads in this stack: 1-6, 8-1000\n")) != wxString::npos);
+    CHECK(report.find(wxT("1 threads in this stack: 7\n#0   0x0000000000000200 in wait from /lib/libc.so\n"))
+          != wxString::npos);
+}
+
+TEST(GenerateThreadsSnapshotListsAllThreads)
+{
+    dbg_mi::ThreadsContainer threads;
+    MockLogger logger;
+    wxString report;
+    dbg_mi::GenerateThreadsSnapshot action(new SnapshotCollector(report), threads, logger);
+    action.SetID(1);
+    action.Start();
+
+    dbg_mi::CommandID id;
+    CHECK_EQUAL(wxT("-thread-list-ids"), action.PopPendingCommand(id));
+    action.OnCommandOutput(id, MakeParser(wxT("^done,thread-ids={thread-id=\"2\",thread-id=\"1\"},")
+                                          wxT("current-thread-id=\"1\",number-of-threads=\"2\"")));
+    CHECK_EQUAL(2, action.GetPendingCommandsCount());
+
+    dbg_mi::CommandID first_id, second_id;
+    CHECK_EQUAL(wxString::Format(wxT("-stack-list-frames --thread 1 0 %d"), dbg_mi::c_snapshot_max_frames - 1),
+                action.PopPendingCommand(first_id));
+    CHECK_EQUAL(wxString::Format(wxT("-stack-list-frames --thread 2 0 %d"), dbg_mi::c_snapshot_max_frames - 1),
+                action.PopPendingCommand(second_id));
+    action.OnCommandOutput(second_id, MakeParser(MakeStack(0x100)));
+    CHECK(!action.Finished());
+    action.OnCommandOutput(first_id, MakeParser(MakeStack(0x100)));
+    CHECK(action.Finished());
+    CHECK(report.StartsWith(wxT("2 threads in 1 different stacks\n\n2 threads in this stack: 1-2\n")));
+}